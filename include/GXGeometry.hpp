@@ -2,4 +2,16 @@
 
 #include "geometry/GXGeometryEnums.hpp"
 #include "geometry/GXVertexData.hpp"
+#include "geometry/GXVertexLayout.hpp"
+#include "geometry/GXBounds.hpp"
+#include "geometry/GXAttributeDecoder.hpp"
 #include "geometry/GXGeometryData.hpp"
+#include "geometry/GXGeometryArena.hpp"
+#include "geometry/GXGeometryBuilder.hpp"
+#include "geometry/GXDisplayList.hpp"
+#include "geometry/GXMeshOptimizer.hpp"
+#include "geometry/GXMeshSimplifier.hpp"
+#include "geometry/GXMeshlet.hpp"
+#include "geometry/GXBvh.hpp"
+#include "geometry/GXSkinning.hpp"
+#include "geometry/GXTangentFrame.hpp"
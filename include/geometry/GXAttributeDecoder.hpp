@@ -0,0 +1,21 @@
+#pragma once
+
+#include "GXGeometryEnums.hpp"
+#include "GXVertexData.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Returns the size of a single element of attribute data in the given format, in bytes.
+uint32_t GXGetAttributeElementSize(const GXVertexAttributeFormat& format);
+
+// Decodes the given number of elements of big-endian attribute data in the given format, appending them to
+// the matching list in the attribute data. The format's attribute selects the list (positions, normals,
+// or one of the color or tex coord channels) and its fixed point shift is applied to integer data. Like the
+// hardware's 5-bit field, only the low 5 bits of the shift are used.
+void GXDecodeAttributeArray(const uint8_t* data, size_t count, const GXVertexAttributeFormat& format, GXAttributeData& attributes);
+
+// Decodes the given number of colors stored in the given GX color format, appending them to the output list
+// as normalized RGBA values. Formats without alpha decode with an alpha of 1.
+void GXDecodeColorArray(const uint8_t* data, size_t count, EGXComponentType type, std::vector<glm::vec4>& output);
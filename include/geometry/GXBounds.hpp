@@ -0,0 +1,77 @@
+#pragma once
+
+#include "GXVertexData.hpp"
+#include "glm/mat4x4.hpp"
+
+#include <cfloat>
+#include <cstddef>
+#include <vector>
+
+// An axis-aligned bounding box. A default-constructed box is empty, with Min above Max.
+struct GXBoundingBox {
+    glm::vec3 Min;
+    glm::vec3 Max;
+
+    GXBoundingBox() : Min(FLT_MAX), Max(-FLT_MAX) {}
+    GXBoundingBox(const glm::vec3& min, const glm::vec3& max) : Min(min), Max(max) {}
+
+    // Returns whether this box encloses nothing.
+    bool IsEmpty() const { return Min.x > Max.x || Min.y > Max.y || Min.z > Max.z; }
+    // Returns the point in the middle of this box.
+    glm::vec3 GetCenter() const { return (Min + Max) * 0.5f; }
+    // Returns half of this box's size along each axis.
+    glm::vec3 GetExtents() const { return (Max - Min) * 0.5f; }
+};
+
+// A bounding sphere.
+struct GXBoundingSphere {
+    glm::vec3 Center;
+    float Radius;
+
+    GXBoundingSphere() : Center(0.0f), Radius(0.0f) {}
+    GXBoundingSphere(const glm::vec3& center, float radius) : Center(center), Radius(radius) {}
+};
+
+// Adds the positions of the given vertices to positionSum and grows box to enclose them. Position.w is ignored.
+void GXAccumulateBounds(const ModernVertex* vertices, size_t count, glm::vec3& positionSum, GXBoundingBox& box);
+
+// Returns the largest squared distance from center to the position of any of the given vertices.
+float GXCalculateMaxDistanceSquared(const ModernVertex* vertices, size_t count, const glm::vec3& center);
+
+// A view frustum as six inward-facing planes, each stored as (normal, distance) with a unit-length normal.
+// A point p is inside a plane when dot(normal, p) + distance >= 0.
+struct GXFrustum {
+    // The left, right, bottom, top, near and far planes, in that order.
+    glm::vec4 Planes[6];
+
+    // Extracts the planes of the frustum from a view-projection matrix. The planes are in whatever space the matrix
+    // transforms from, so passing projection * view * model gives a frustum in that model's local space.
+    // zeroToOneDepth selects clip-space depth in [0, 1] as in Direct3D and Vulkan, rather than [-1, 1] as in OpenGL.
+    static GXFrustum FromMatrix(const glm::mat4& viewProjection, bool zeroToOneDepth = false);
+};
+
+// The bounding boxes and spheres of many objects, stored one component per array for batch culling.
+// The arrays are padded to a multiple of four entries with bounds that are always culled.
+struct GXBoundsArray {
+    std::vector<float> CenterX;
+    std::vector<float> CenterY;
+    std::vector<float> CenterZ;
+    std::vector<float> ExtentX;
+    std::vector<float> ExtentY;
+    std::vector<float> ExtentZ;
+    std::vector<float> Radius;
+    // The number of objects, not counting padding.
+    size_t Count;
+
+    GXBoundsArray() : Count(0) {}
+
+    // Resizes the arrays to hold the given number of objects, all of them empty.
+    void Resize(size_t count);
+    // Sets the bounds of the given object. Box and sphere are both tested, and either can cull the object.
+    // An empty box makes the object always culled.
+    void Set(size_t index, const GXBoundingBox& box, const GXBoundingSphere& sphere);
+};
+
+// Tests every object's bounds against the given frustum, four at a time. Bit i % 32 of visibleBits[i / 32] is set
+// if object i may be visible and cleared if it is certainly outside. visibleBits must hold (Count + 31) / 32 words.
+void GXCullBounds(const GXBoundsArray& bounds, const GXFrustum& frustum, uint32_t* visibleBits);
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "GXVertexData.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class GXGeometry;
+
+// A node of a GXBvh. Inner nodes have two children stored next to each other; leaves hold a run of triangles.
+struct GXBvhNode {
+    // The minimum corner of the box enclosing everything below this node.
+    glm::vec3 Min;
+    // For inner nodes, the index of the first child. For leaves, the position of the first triangle in leaf order.
+    uint32_t LeftOrFirst;
+    // The maximum corner of the box enclosing everything below this node.
+    glm::vec3 Max;
+    // The number of triangles in this leaf, or 0 for inner nodes.
+    uint32_t Count;
+
+    GXBvhNode() : Min(0.0f), LeftOrFirst(0), Max(0.0f), Count(0) {}
+
+    bool IsLeaf() const { return Count != 0; }
+};
+
+// A triangle found by a GXBvh query.
+struct GXBvhHit {
+    // The index of the shape the triangle belongs to.
+    uint32_t ShapeIndex;
+    // The index of the triangle in the model index list; its vertex indices start at 3 * Triangle.
+    uint32_t Triangle;
+    // For ray and segment queries, the distance along the ray to the hit. For sphere queries, the distance
+    // from the sphere's centre to the closest point on the triangle.
+    float Distance;
+    // The weights of the triangle's second and third vertices at the hit point. The first vertex's weight is 1 - x - y.
+    glm::vec2 Barycentrics;
+
+    GXBvhHit() : ShapeIndex(0), Triangle(0), Distance(0.0f), Barycentrics(0.0f) {}
+};
+
+// A bounding volume hierarchy over the triangles in a model's index list, for picking and collision queries.
+// Triangles are treated as two-sided. The hierarchy keeps its own copy of the triangles' positions, so it stays
+// valid if the geometry changes; call Refit after moving vertices, or Build again after changing the indices.
+class GXBvh {
+    // The nodes of the hierarchy. The root is node 0, and children always come after their parent.
+    std::vector<GXBvhNode> mNodes;
+    // The index of each triangle in the model index list, in leaf order.
+    std::vector<uint32_t> mTriangles;
+    // The shape each triangle belongs to, in leaf order.
+    std::vector<uint32_t> mTriangleShapes;
+    // The three corner positions of each triangle, in leaf order.
+    std::vector<glm::vec3> mTriangleVertices;
+
+    // Copies the triangles' current positions out of the given geometry.
+    void GatherTriangleVertices(const GXGeometry& geometry, uint32_t threadCount);
+    // Recalculates every node's box from the triangle positions, leaves first.
+    void RefitNodes(uint32_t threadCount);
+
+public:
+    GXBvh() { }
+
+    // Builds the hierarchy over every triangle of the given geometry's model index list, splitting nodes with a
+    // binned surface area heuristic. The subtrees below the first few levels are built across up to threadCount
+    // threads (0 for one per hardware thread). The hierarchy is identical for any thread count.
+    void Build(const GXGeometry& geometry, uint32_t threadCount = 1);
+    // Updates the hierarchy's boxes to the current vertex positions of the geometry it was built from, without
+    // changing its structure. Queries stay exact, but get slower the further vertices move from where they were at build time.
+    void Refit(const GXGeometry& geometry, uint32_t threadCount = 1);
+
+    // Finds the closest triangle hit by the ray within maxDistance, measured in multiples of the direction's length.
+    // Returns whether anything was hit.
+    bool Raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, GXBvhHit& hit) const;
+    // Finds the triangle hit closest to start by the segment from start to end. Returns whether anything was hit.
+    bool SegmentCast(const glm::vec3& start, const glm::vec3& end, GXBvhHit& hit) const;
+    // Fills hits with every triangle that touches the given sphere, in no particular order. Returns the number of hits.
+    size_t SphereQuery(const glm::vec3& center, float radius, std::vector<GXBvhHit>& hits) const;
+
+    // Returns a const reference to the nodes of the hierarchy.
+    const std::vector<GXBvhNode>& GetNodes() const { return mNodes; }
+    // Returns the number of triangles in the hierarchy.
+    size_t GetTriangleCount() const { return mTriangles.size(); }
+    // Returns whether the hierarchy has no triangles.
+    bool IsEmpty() const { return mNodes.empty(); }
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "GXGeometryEnums.hpp"
+#include "GXVertexData.hpp"
+#include "GXGeometryData.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// Represents a primitive decoded from a display list, with its vertices still in index form.
+struct GXDisplayListPrimitive {
+    // What kind of shape the vertices in this primitive make.
+    EGXPrimitiveType Type;
+    // The attribute indices of each vertex in the primitive.
+    std::vector<GXVertex> Vertices;
+
+    GXDisplayListPrimitive() : Type(EGXPrimitiveType::None) {}
+};
+
+// Decodes GX display lists for one vertex descriptor. The layout of a vertex is worked out once when the
+// decoder is created, so decoding a list is a single pass over its bytes with no per-vertex setup.
+class GXDisplayListDecoder {
+    // How a single attribute is read out of a vertex in the display list.
+    struct AttributeReader {
+        EGXAttribute Attribute;
+        EGXAttributeIndexType IndexType;
+        // The offset of the attribute from the start of the vertex, in bytes.
+        uint32_t Offset;
+        // The slot the attribute is written to in a packed vertex.
+        uint32_t Slot;
+    };
+
+    // The attributes present in the display list, in the order the hardware stores them.
+    std::vector<EGXAttribute> mVertexAttributeTable;
+    // The format decoded vertices are packed with.
+    GXPackedVertexFormat mFormat;
+    // The readers for every attribute present in the display list.
+    std::vector<AttributeReader> mReaders;
+    // The size of a single vertex in the display list, in bytes.
+    uint32_t mVertexStride;
+
+    // Calls onPrimitive(type, vertexCount) for every primitive in the list, followed by onVertex(key) for each of its
+    // vertices, where key is the vertex packed with mFormat. If attributes isn't null, throws on any index past the
+    // end of the array it refers to.
+    template<typename PrimitiveFunc, typename VertexFunc>
+    void DecodeImpl(const uint8_t* data, size_t size, const GXAttributeData* attributes, PrimitiveFunc onPrimitive, VertexFunc onVertex) const;
+
+public:
+    // Creates a decoder for display lists using the given vertex descriptor. Attribute formats are only
+    // needed for attributes stored as direct data, which is supported for the matrix index attributes.
+    GXDisplayListDecoder(const std::vector<GXVertexDescriptor>& descriptors, const std::vector<GXVertexAttributeFormat>& formats = std::vector<GXVertexAttributeFormat>());
+
+    // Returns a const reference to the list of attributes present in the display list.
+    const std::vector<EGXAttribute>& GetAttributeTable() const { return mVertexAttributeTable; }
+    // Returns the size of a single vertex in the display list, in bytes.
+    uint32_t GetVertexStride() const { return mVertexStride; }
+    // Returns the format that vertices decoded in index form are packed with.
+    const GXPackedVertexFormat& GetPackedFormat() const { return mFormat; }
+
+    // Decodes the given big-endian display list, appending its primitives to the given list.
+    // If attribute data is given, throws if any index is past the end of the array it refers to.
+    void Decode(const uint8_t* data, size_t size, std::vector<GXDisplayListPrimitive>& primitives, const GXAttributeData* attributes = nullptr) const;
+    // Decodes the given big-endian display list into the given shape, converting its vertices through the given cache.
+    // Primitives are created in the given arena, or on the heap if it is null. Throws if any index is past the end
+    // of the cache's attribute array it refers to.
+    void DecodeShape(const uint8_t* data, size_t size, GXVertexCache& cache, GXShape& shape, GXGeometryArena* arena = nullptr) const;
+    // Decodes the given big-endian display list into the given shape as primitives in index form, leaving
+    // their conversion to GXGeometry::CreateVertexArray. Primitives are created in the given arena, or on the heap if it is null.
+    // If attribute data is given, throws if any index is past the end of the array it refers to; otherwise an index
+    // out of range only throws once CreateVertexArray converts it.
+    void DecodeShape(const uint8_t* data, size_t size, GXShape& shape, GXGeometryArena* arena = nullptr, const GXAttributeData* attributes = nullptr) const;
+};
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "GXGeometryData.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Allocates a model's shapes and primitives out of contiguous blocks, and frees all of them in one go once the last
+// reference to the arena, or to any shape created from it, goes away. Shapes share the arena's reference count,
+// so handing them to a GXGeometry allocates no control block of their own. Shapes never delete primitives created
+// by an arena, so arena primitives can be added to any shape, as long as the arena outlives that shape.
+// An arena is not thread-safe; use one per loading thread.
+class GXGeometryArena : public std::enable_shared_from_this<GXGeometryArena> {
+    // Hands out objects of one type from blocks that grow geometrically, and destroys them all together.
+    template<typename T>
+    class Pool {
+        typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type Slot;
+
+        // A block of storage and the number of its slots holding constructed objects.
+        struct Block {
+            std::unique_ptr<Slot[]> Slots;
+            size_t Capacity;
+            size_t Count;
+        };
+
+        std::vector<Block> mBlocks;
+        // The number of objects constructed across every block.
+        size_t mCount;
+
+    public:
+        Pool() : mCount(0) { }
+        ~Pool() { Clear(); }
+
+        Pool(const Pool&) = delete;
+        Pool& operator=(const Pool&) = delete;
+
+        // Makes sure that the next count objects fit in the current block.
+        void Reserve(size_t count) {
+            if (!mBlocks.empty() && mBlocks.back().Capacity - mBlocks.back().Count >= count)
+                return;
+
+            mBlocks.push_back({ std::unique_ptr<Slot[]>(new Slot[count]), count, 0 });
+        }
+
+        // Constructs a new object in the pool with the given arguments.
+        template<typename... Args>
+        T* Create(Args&&... args) {
+            if (mBlocks.empty() || mBlocks.back().Count == mBlocks.back().Capacity) {
+                // Start small for tiny models, and double up to a limit so large ones need few blocks.
+                size_t capacity = mBlocks.empty() ? 64 : std::min<size_t>(mBlocks.back().Capacity * 2, 4096);
+                Reserve(capacity);
+            }
+
+            Block& block = mBlocks.back();
+            T* object = new (&block.Slots[block.Count]) T(std::forward<Args>(args)...);
+            block.Count++;
+            mCount++;
+
+            return object;
+        }
+
+        // Destroys every object in the pool, newest first, and releases its storage.
+        void Clear() {
+            for (size_t b = mBlocks.size(); b > 0; b--) {
+                Block& block = mBlocks[b - 1];
+                for (size_t i = block.Count; i > 0; i--) {
+                    reinterpret_cast<T*>(&block.Slots[i - 1])->~T();
+                }
+            }
+
+            mBlocks.clear();
+            mCount = 0;
+        }
+
+        // Returns the number of objects in the pool.
+        size_t GetCount() const { return mCount; }
+    };
+
+    Pool<GXShape> mShapes;
+    Pool<GXPrimitive> mPrimitives;
+
+    GXGeometryArena() { }
+
+public:
+    // Creates an empty arena. Arenas are always owned through a shared pointer, which their shapes share.
+    static std::shared_ptr<GXGeometryArena> Create();
+
+    ~GXGeometryArena();
+
+    GXGeometryArena(const GXGeometryArena&) = delete;
+    GXGeometryArena& operator=(const GXGeometryArena&) = delete;
+
+    // Creates an empty shape in the arena. The shape keeps the arena alive for as long as it is referenced.
+    std::shared_ptr<GXShape> CreateShape();
+    // Creates a primitive of the given type in the arena. It is freed with the arena, never by the shape holding it.
+    GXPrimitive* CreatePrimitive(EGXPrimitiveType type);
+
+    // Makes room for the given number of shapes and primitives in one block each, for loaders that know their counts up front.
+    void Reserve(size_t shapeCount, size_t primitiveCount);
+
+    // Returns the number of shapes created in the arena.
+    size_t GetShapeCount() const { return mShapes.GetCount(); }
+    // Returns the number of primitives created in the arena.
+    size_t GetPrimitiveCount() const { return mPrimitives.GetCount(); }
+};
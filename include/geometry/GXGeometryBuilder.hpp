@@ -0,0 +1,87 @@
+#pragma once
+
+#include "GXGeometryEnums.hpp"
+#include "GXVertexData.hpp"
+#include "GXGeometryData.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// Builds a model's shapes straight into its flattened lists, without a tree of GXPrimitives to flatten afterwards.
+// Vertices and primitives are pushed one shape at a time; primitives are triangulated and appended to the model
+// index lists as they arrive, and vertices are welded within their shape like GXGeometry::CreateVertexArray does.
+// Every index the builder returns stays valid as the model grows. Shapes made by a builder hold no primitives, so
+// calling CreateVertexArray afterwards would empty them. Nothing else may append to the model lists while a shape is
+// being built, and anything built from those lists, such as the compact vertex buffer or the shape bounds, has to be
+// built again once the model is complete.
+class GXGeometryBuilder {
+    // The model being built.
+    GXGeometry& mGeometry;
+    // Whether bit-identical vertices within a shape are stored once.
+    bool mbWeldVertices;
+
+    // The shape being built, or null between shapes.
+    std::shared_ptr<GXShape> mShape;
+    // Maps the vertices of the current shape to their position in the model vertex list.
+    std::unordered_map<ModernVertex, uint32_t, ModernVertexHash, ModernVertexBitwiseEqual> mWeldMap;
+    // Converts vertices in index form with the current shape's attribute table.
+    GXVertexCache mCache;
+    // The model vertex index of every vertex in mCache, for the current shape.
+    std::vector<uint32_t> mTupleIds;
+
+    // Scratch space for the vertex ids and triangulated indices of one primitive.
+    std::vector<uint32_t> mVertexIds;
+    GXPrimitiveIndices mIndices;
+
+    // Throws if no shape is being built.
+    void CheckShape() const;
+    // Triangulates a primitive of the given type whose vertices are in mVertexIds, appends its indices to the model,
+    // and returns the offset of the first index in the model list for its primitive type.
+    uint32_t AppendPrimitive(EGXPrimitiveType type);
+    // Updates the current shape's ranges to cover everything appended since it began.
+    void UpdateShapeRanges();
+
+public:
+    // Creates a builder appending to the given model. The model must outlive the builder.
+    GXGeometryBuilder(GXGeometry& geometry, bool weldVertices = true);
+    // Ends the shape being built, if there is one.
+    ~GXGeometryBuilder();
+
+    GXGeometryBuilder(const GXGeometryBuilder&) = delete;
+    GXGeometryBuilder& operator=(const GXGeometryBuilder&) = delete;
+
+    // Ends the current shape, if there is one, and starts a new shape with the given attribute table at the end of
+    // the model's shape list. If a shape is given, such as one from a GXGeometryArena, it is used instead of a new one.
+    // Returns a reference to the new shape.
+    GXShape& BeginShape(const std::vector<EGXAttribute>& attributeTable, std::shared_ptr<GXShape> shape = nullptr);
+    // Ends the current shape. Further vertices and primitives need a new shape.
+    void EndShape();
+    // Returns the shape being built, or null between shapes.
+    const std::shared_ptr<GXShape>& GetShape() const { return mShape; }
+
+    // Adds a vertex to the current shape and returns its index in the model vertex list, which is the index of an
+    // earlier bit-identical vertex of the shape if welding is enabled.
+    uint32_t AddVertex(const ModernVertex& vertex);
+    // Adds a vertex in index form to the current shape, converted from the model's attribute data with the shape's
+    // attribute table, and returns its index in the model vertex list.
+    uint32_t AddVertex(const GXVertex& vertex);
+
+    // Adds a primitive of the given type made of the given vertices to the current shape. Returns the offset of its
+    // first index in the model triangle, line or point index list, whichever its type is triangulated into.
+    uint32_t AddPrimitive(EGXPrimitiveType type, const ModernVertex* vertices, size_t count);
+    // Adds a primitive of the given type made of the given vertices to the current shape. Returns the offset of its
+    // first index in the model triangle, line or point index list, whichever its type is triangulated into.
+    uint32_t AddPrimitive(EGXPrimitiveType type, const std::vector<ModernVertex>& vertices) { return AddPrimitive(type, vertices.data(), vertices.size()); }
+    // Adds a primitive of the given type made of the given vertices in index form to the current shape.
+    // Returns the offset of its first index in the model index list for its type.
+    uint32_t AddPrimitive(EGXPrimitiveType type, const GXVertex* vertices, size_t count);
+    // Adds a primitive of the given type made of vertices already added by AddVertex, by their model vertex indices.
+    // Returns the offset of its first index in the model index list for its type.
+    uint32_t AddPrimitive(EGXPrimitiveType type, const uint32_t* vertexIndices, size_t count);
+    // Adds a copy of the given primitive, in either vertex form, to the current shape.
+    // Returns the offset of its first index in the model index list for its type.
+    uint32_t AddPrimitive(const GXPrimitive& primitive);
+};
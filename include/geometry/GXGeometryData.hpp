@@ -2,47 +2,165 @@
 
 #include "GXGeometryEnums.hpp"
 #include "GXVertexData.hpp"
+#include "GXVertexLayout.hpp"
+#include "GXBounds.hpp"
+#include "GXMeshOptimizer.hpp"
+#include "GXMeshSimplifier.hpp"
+#include "GXMeshlet.hpp"
+#include "GXSkinning.hpp"
+#include "GXTangentFrame.hpp"
 
 #include <cstdint>
+#include <functional>
 #include <vector>
 #include <memory>
+#include <unordered_map>
+#include <utility>
 
 class GXGeometry;
+class GXGeometryArena;
+class GXGeometryBuilder;
+
+// The index lists produced by triangulating primitives, split by the kind of primitive they draw.
+struct GXPrimitiveIndices {
+    // Every three indices make up one triangle.
+    std::vector<uint32_t> Triangles;
+    // Every two indices make up one line.
+    std::vector<uint32_t> Lines;
+    // Every index is one point.
+    std::vector<uint32_t> Points;
+
+    void Clear() {
+        Triangles.clear();
+        Lines.clear();
+        Points.clear();
+    }
+};
 
 // Represents a single primitive made up of a list of vertices.
+// A primitive stores its vertices either as ModernVertex data or in index form, as attribute index tuples that
+// refer to the model's GXAttributeData. Tuples are packed with the GXPackedVertexFormat of the owning shape's
+// attribute table, and are only turned into ModernVertex data when the model is flattened by
+// GXGeometry::CreateVertexArray.
 class GXPrimitive {
+    friend GXGeometryArena;
+
     // What kind of shape the vertices in this primitive make - triangles, quads, etc.
     EGXPrimitiveType mType;
     // The vertices making up this primitive.
     std::vector<ModernVertex> mVertices;
-
-    // Converts this primitive from triangle strip to triangles.
-    void TriangulateTriangleStrip();
-    // Converts this primitive from triangl fan to triangles.
-    void TriangulateTriangleFan();
+    // The vertices making up this primitive in index form, as packed tuples laid out back to back.
+    std::vector<uint16_t> mPackedVertices;
+    // The size of each packed tuple, in 16-bit words.
+    uint32_t mPackedStride;
+    // Whether this primitive was created by a GXGeometryArena, which frees it instead of the shape holding it.
+    bool mbArenaOwned;
 
 public:
-    GXPrimitive() : mType(EGXPrimitiveType::None) {}
-    GXPrimitive(const EGXPrimitiveType& type) { mType = type; }
+    GXPrimitive() : mType(EGXPrimitiveType::None), mPackedStride(0), mbArenaOwned(false) {}
+    GXPrimitive(const EGXPrimitiveType& type) : mPackedStride(0), mbArenaOwned(false) { mType = type; }
+
+    // Copies and moves are never owned by an arena, so the shape holding one frees it. Assigning to a primitive
+    // keeps its own ownership, since that only depends on where it was created.
+    GXPrimitive(const GXPrimitive& other) : mType(other.mType), mVertices(other.mVertices), mPackedVertices(other.mPackedVertices),
+                                            mPackedStride(other.mPackedStride), mbArenaOwned(false) {}
+    GXPrimitive(GXPrimitive&& other) noexcept : mType(other.mType), mVertices(std::move(other.mVertices)),
+                                                mPackedVertices(std::move(other.mPackedVertices)), mPackedStride(other.mPackedStride), mbArenaOwned(false) {}
+
+    GXPrimitive& operator=(const GXPrimitive& other) {
+        mType = other.mType;
+        mVertices = other.mVertices;
+        mPackedVertices = other.mPackedVertices;
+        mPackedStride = other.mPackedStride;
+        return *this;
+    }
+
+    GXPrimitive& operator=(GXPrimitive&& other) noexcept {
+        mType = other.mType;
+        mVertices = std::move(other.mVertices);
+        mPackedVertices = std::move(other.mPackedVertices);
+        mPackedStride = other.mPackedStride;
+        return *this;
+    }
 
     // Returns this primitive's type.
     EGXPrimitiveType GetType() const { return mType; }
+    // Returns whether this primitive belongs to a GXGeometryArena rather than to the shape holding it.
+    bool IsArenaOwned() const { return mbArenaOwned; }
 
     // Returns a reference to this primitive's list of vertices.
     std::vector<ModernVertex>& GetVertices() { return mVertices; }
     // Returns a const reference to this primitive's list of vertices.
     const std::vector<ModernVertex>& GetVertices() const { return mVertices; }
 
+    // Appends a vertex in index form, packed with the given format. Every vertex in index form must use the same format.
+    void AddIndexedVertex(const GXPackedVertexFormat& format, const GXVertex& vertex);
+    // Appends a vertex in index form that is already packed with a format of the given stride.
+    void AddPackedVertex(const uint16_t* key, uint32_t stride);
+    // Returns the vertex in index form at the given position, unpacked with the given format.
+    GXVertex GetIndexedVertex(const GXPackedVertexFormat& format, size_t index) const { return format.Unpack(GetPackedVertex(index)); }
+    // Returns the packed tuple of the vertex in index form at the given position.
+    const uint16_t* GetPackedVertex(size_t index) const { return mPackedVertices.data() + index * mPackedStride; }
+    // Returns the size of each packed tuple, in 16-bit words.
+    uint32_t GetPackedStride() const { return mPackedStride; }
+    // Prepares the primitive to hold the given number of vertices in index form with the given stride.
+    void ReservePacked(size_t count, uint32_t stride) { mPackedVertices.reserve(count * stride); }
+
+    // Returns whether this primitive stores its vertices in index form.
+    bool IsIndexed() const { return !mPackedVertices.empty(); }
+    // Returns the number of vertices in this primitive, in whichever form they are stored.
+    size_t GetVertexCount() const { return IsIndexed() ? mPackedVertices.size() / mPackedStride : mVertices.size(); }
+
     // Reconfigures the indices in this primitive from whatever its
-    // original primitive type was to triangles.
+    // original primitive type was to triangles. Line and point primitives are left as they are.
     void TriangluatePrimitive();
+
+    // Appends the index lists for a primitive of the given type to the output, where vertexIds holds the id of
+    // each of the primitive's vertices in order. Triangles, quads, strips and fans become triangles, lines and
+    // line strips become lines, and points become points. Triangles and lines that use the same id more than
+    // once are degenerate and are skipped.
+    static void TriangulateIndices(EGXPrimitiveType type, const uint32_t* vertexIds, size_t count, GXPrimitiveIndices& output);
+    // Fills vertexIds with ids for a primitive's vertices that are stored as they are, numbered from firstId.
+    // A vertex equal to one of the vertices it can share a triangle or line with takes that vertex's id instead,
+    // so TriangulateIndices skips the same degenerate triangles that comparing the vertices themselves would.
+    static void GetUnweldedVertexIds(const ModernVertex* vertices, size_t count, uint32_t firstId, uint32_t* vertexIds);
+};
+
+
+// A run of a shape's indices that can be drawn with a single matrix palette.
+struct GXShapeDraw {
+    // The type of primitive the indices make up: Triangles, Lines or Points.
+    EGXPrimitiveType Type;
+    // The offset of the draw's first index in the model index list for its primitive type.
+    uint32_t FirstIndex;
+    // The number of indices in the draw.
+    uint32_t IndexCount;
+    // The original position matrix index of each palette slot. The vertices of this draw store their slot in Position.w.
+    std::vector<uint32_t> Palette;
+
+    GXShapeDraw() : Type(EGXPrimitiveType::Triangles), FirstIndex(0), IndexCount(0) {}
 };
 
+// A simplified version of a shape's triangles, sharing the shape's vertices.
+struct GXShapeLod {
+    // The offset of the level's first index in the model LOD index list.
+    uint32_t FirstIndex;
+    // The number of indices in the level.
+    uint32_t IndexCount;
+    // An estimate of how far the level's surface strays from the full-detail triangles, in model units.
+    float Error;
+    // The level's triangles split by matrix palette, with offsets into the model LOD index list.
+    // Empty unless the shape has been split into draws.
+    std::vector<GXShapeDraw> Draws;
+
+    GXShapeLod() : FirstIndex(0), IndexCount(0), Error(0.0f) {}
+};
 
 // Represents a set of primitives sharing the same Vertex Attribute Table setup,
 // i.e. a set of primitives with the same attributes enabled.
 class GXShape {
     friend GXGeometry;
+    friend GXGeometryBuilder;
 
     // A list that indicates which attributes are enabled for the primitives in this shape.
     std::vector<EGXAttribute> mVertexAttributeTable;
@@ -55,20 +173,57 @@ class GXShape {
     uint32_t mFirstVertexOffset;
     // The total number of vertex indices that this shape has in the model index list.
     uint32_t mVertexCount;
+    // The offset of this shape's first vertex in the model vertex list.
+    uint32_t mFirstModelVertex;
+    // The number of vertices that this shape has in the model vertex list.
+    uint32_t mModelVertexCount;
+    // The offset of this shape's first index in the model line index list.
+    uint32_t mFirstLineIndex;
+    // The number of indices that this shape has in the model line index list.
+    uint32_t mLineIndexCount;
+    // The offset of this shape's first index in the model point index list.
+    uint32_t mFirstPointIndex;
+    // The number of indices that this shape has in the model point index list.
+    uint32_t mPointIndexCount;
+    // The offset of this shape's first meshlet in the model meshlet list.
+    uint32_t mFirstMeshlet;
+    // The number of meshlets that this shape has in the model meshlet list.
+    uint32_t mMeshletCount;
 
     glm::vec3 mCenterOfMass;
+    // The axis-aligned box enclosing this shape's vertices.
+    GXBoundingBox mBoundingBox;
+    // A sphere enclosing this shape's vertices, centred on its bounding box.
+    GXBoundingSphere mBoundingSphere;
+
+    // The parameters for restoring this shape's positions in the quantized vertex buffer.
+    GXDequantizationParams mDequantizationParams;
+
+    // The palette-limited draws this shape is split into. Empty unless the model's matrix palettes have been partitioned.
+    std::vector<GXShapeDraw> mDraws;
+    // The simplified levels of detail of this shape's triangles, from most to least detailed. Empty unless built.
+    std::vector<GXShapeLod> mLods;
 
     bool mbIsVisible;
 
     // Arbitrary data that can be associated with this shape.
     void* mUserData;
 
+    // Sets this shape's center of mass, bounding box and bounding sphere from the given vertices.
+    void CalculateBounds(const ModernVertex* vertices, size_t count);
+    // Fills ranges with the offset and count of each run of this shape's triangle indices that must stay together:
+    // one per triangle draw if the shape has been split into draws, otherwise its whole triangle index range.
+    void GetTriangleRanges(std::vector<std::pair<uint32_t, uint32_t>>& ranges) const;
+
 public:
-    GXShape() : mFirstVertexOffset(0), mVertexCount(0), mCenterOfMass(), mbIsVisible(true), mUserData(nullptr) {}
+    GXShape() : mFirstVertexOffset(0), mVertexCount(0), mFirstModelVertex(0), mModelVertexCount(0),
+                mFirstLineIndex(0), mLineIndexCount(0), mFirstPointIndex(0), mPointIndexCount(0),
+                mFirstMeshlet(0), mMeshletCount(0), mCenterOfMass(), mbIsVisible(true), mUserData(nullptr) {}
 
     ~GXShape() {
         for (GXPrimitive* p : mPrimitives) {
-            delete p;
+            if (!p->IsArenaOwned())
+                delete p;
         }
 
         mPrimitives.clear();
@@ -86,11 +241,37 @@ public:
     const std::vector<GXPrimitive*>& GetPrimitives() const { return mPrimitives; }
 
     const glm::vec3& GetCenterOfMass() const { return mCenterOfMass; }
+    // Returns the axis-aligned box enclosing this shape's vertices. Empty until the bounds are calculated.
+    const GXBoundingBox& GetBoundingBox() const { return mBoundingBox; }
+    // Returns a sphere enclosing this shape's vertices. Zero-sized until the bounds are calculated.
+    const GXBoundingSphere& GetBoundingSphere() const { return mBoundingSphere; }
+
+    // Returns a const reference to the palette-limited draws this shape is split into.
+    // Empty unless GXGeometry::PartitionMatrixPalettes has been called.
+    const std::vector<GXShapeDraw>& GetDraws() const { return mDraws; }
+    // Returns a const reference to this shape's simplified levels of detail, not counting the full-detail triangles.
+    // Empty unless GXGeometry::BuildLods has been called.
+    const std::vector<GXShapeLod>& GetLods() const { return mLods; }
+
+    // Returns the parameters for restoring this shape's positions in the model's quantized vertex buffer.
+    const GXDequantizationParams& GetDequantizationParams() const { return mDequantizationParams; }
 
     void SetVertexOffset(uint32_t offset) { mFirstVertexOffset = offset; }
     // Fills the input references with the offset of this shape's first index in the global index list
     // and the number of indices belonging to it.
     void GetVertexOffsetAndCount(uint32_t& offset, uint32_t& count) const;
+    // Fills the input references with the offset of this shape's first vertex in the model vertex list
+    // and the number of vertices belonging to it. Indices of this shape only reference vertices in this range.
+    void GetModelVertexRange(uint32_t& first, uint32_t& count) const;
+    // Fills the input references with the offset of this shape's first index in the model line index list
+    // and the number of line indices belonging to it.
+    void GetLineOffsetAndCount(uint32_t& offset, uint32_t& count) const;
+    // Fills the input references with the offset of this shape's first index in the model point index list
+    // and the number of point indices belonging to it.
+    void GetPointOffsetAndCount(uint32_t& offset, uint32_t& count) const;
+    // Fills the input references with the offset of this shape's first meshlet in the model meshlet list
+    // and the number of meshlets belonging to it.
+    void GetMeshletRange(uint32_t& first, uint32_t& count) const;
 
     bool GetVisible() const { return mbIsVisible; }
     void SetVisible(bool visible) { mbIsVisible = visible; }
@@ -102,19 +283,104 @@ public:
 
     void SetUserData(void* data) { mUserData = data; }
 
+    // Calculates this shape's center of mass, bounding box and bounding sphere from the vertices of its primitives.
+    // Primitives in index form are not included; use GXGeometry::CalculateShapeBounds once the vertex array is built.
     void CalculateCenterOfMass();
 };
 
+// Options controlling how GXGeometry::CreateVertexArray flattens a model.
+struct GXVertexArrayOptions {
+    // Whether bit-identical vertices within a shape should be stored once and shared through the index list,
+    // rather than once per vertex of every primitive. Either way, triangles that repeat a vertex, such as the
+    // joins between GX triangle strips, are recognized as degenerate and dropped.
+    bool WeldVertices;
+    // Whether to also build a tightly packed interleaved vertex buffer holding only the attributes
+    // that the model's shapes actually enable. See GXGeometry::BuildCompactVertices.
+    bool CompactVertices;
+    // Whether to also build an interleaved vertex buffer using quantized formats. See GXGeometry::BuildQuantizedVertices.
+    bool QuantizeVertices;
+    // Whether to also split the model vertices into one stream per attribute. See GXGeometry::BuildVertexStreams.
+    bool SplitVertexStreams;
+    // Whether to calculate every shape's center of mass, bounding box and bounding sphere while its vertices
+    // are being written. See GXGeometry::CalculateShapeBounds.
+    bool CalculateBounds;
+    // How many threads to flatten shapes on. 0 uses one thread per hardware thread.
+    // The output is identical regardless of the thread count.
+    uint32_t ThreadCount;
+
+    GXVertexArrayOptions() : WeldVertices(false), CompactVertices(false), QuantizeVertices(false), SplitVertexStreams(false), CalculateBounds(false), ThreadCount(1) {}
+};
+
+// The result of optimizing a model's triangle order for the post-transform vertex cache.
+struct GXVertexCacheReport {
+    // The simulated cache behaviour of every shape before optimizing.
+    GXVertexCacheStats Before;
+    // The simulated cache behaviour of every shape after optimizing.
+    GXVertexCacheStats After;
+};
+
 // Represents all of the geometry for a given model.
 class GXGeometry {
+    friend GXGeometryBuilder;
+
     // The geometry data that makes up this model.
     std::vector<std::shared_ptr<GXShape>> mShapes;
 
-    // All the vertex indices in the model, collated for one-and-done uploading to the GPU.
+    // All the triangle vertex indices in the model, collated for one-and-done uploading to the GPU.
     std::vector<uint32_t> mModelIndices;
+    // All the line vertex indices in the model, from line and line strip primitives.
+    std::vector<uint32_t> mModelLineIndices;
+    // All the point vertex indices in the model, from point primitives.
+    std::vector<uint32_t> mModelPointIndices;
+    // The triangle vertex indices of every shape's simplified levels of detail, indexing the model vertex list.
+    std::vector<uint32_t> mModelLodIndices;
     // All the vertex data in the model, sorted by the model's indices.
     std::vector<ModernVertex> mModelVertices;
 
+    // The layout of the vertices in the compact vertex buffer.
+    GXVertexLayout mCompactVertexLayout;
+    // The model vertex list packed into an interleaved buffer holding only the enabled attributes.
+    std::vector<uint8_t> mCompactVertices;
+    // The layout of the vertices in the quantized vertex buffer.
+    GXVertexLayout mQuantizedVertexLayout;
+    // The model vertex list packed into an interleaved buffer holding only the enabled attributes, in quantized formats.
+    std::vector<uint8_t> mQuantizedVertices;
+    // The parameters for restoring the positions of model vertices outside of every shape in the quantized vertex buffer.
+    GXDequantizationParams mDequantizationParams;
+
+    // The model vertex list split into one contiguous stream per enabled attribute, indexed by the model's indices.
+    GXAttributeData mModelStreams;
+
+    // The bounds of every shape, gathered for batch culling whenever the shapes' bounds are calculated.
+    GXBoundsArray mShapeBounds;
+
+    // The model's triangles split into meshlets, with their vertices referring to the model vertex list.
+    GXMeshletList mModelMeshlets;
+
+    // The tangent frame of every model vertex, kept out of ModernVertex so welding and hashing don't see it. Each is the
+    // normal, tangent and bitangent packed into a quaternion, with the bitangent's handedness in the sign of w; see
+    // GXEncodeTangentFrame. Empty until GenerateTangentFrames is called.
+    std::vector<glm::vec4> mModelTangentFrames;
+
+    // The attribute data that the vertices of primitives in index form refer to.
+    GXAttributeData mAttributeData;
+
+    // Maps vertices appended since the last weld boundary to their position in the model vertex list.
+    std::unordered_map<ModernVertex, uint32_t, ModernVertexHash, ModernVertexBitwiseEqual> mVertexWeldMap;
+
+    // Returns the index of the given vertex in the model vertex list, appending it if no
+    // bit-identical vertex has been added since the last weld boundary.
+    uint32_t WeldVertex(const ModernVertex& vertex);
+
+    // Moves every model vertex v to remap[v] and rewrites all of the model's index lists to match.
+    // The remap must be a permutation that keeps each shape's vertices inside its own model vertex range.
+    void RemapModelVertices(const std::vector<uint32_t>& remap, uint32_t threadCount);
+    // Copies every shape's bounds into the batch culling arrays.
+    void GatherShapeBounds();
+    // Rebuilds whichever of the compact, quantized and split vertex buffers have already been built,
+    // after a pass has changed the model vertex list.
+    void RefreshVertexBuffers();
+
 public:
     GXGeometry() { }
 
@@ -122,7 +388,13 @@ public:
         mShapes.clear();
     }
 
-    uint32_t AddVertices(std::vector<ModernVertex> vertices);
+    // Appends a list of triangle vertices to the model, welding bit-identical vertices together.
+    // Returns the offset of the first appended index in the model index list. Throws if count isn't a multiple
+    // of three, since that would misalign every later triangle. See GXGeometryBuilder for building whole shapes this way.
+    uint32_t AddVertices(const ModernVertex* vertices, size_t count);
+    // Appends a list of triangle vertices to the model, welding bit-identical vertices together.
+    // Returns the offset of the first appended index in the model index list.
+    uint32_t AddVertices(const std::vector<ModernVertex>& vertices) { return AddVertices(vertices.data(), vertices.size()); }
 
     // Returns a reference to the list of shapes in this model.
     std::vector<std::shared_ptr<GXShape>>& GetShapes() { return mShapes; }
@@ -130,6 +402,10 @@ public:
     std::vector<uint32_t>& GetModelIndices() { return mModelIndices; }
     // Returns a reference to the list of all vertices in this model.
     std::vector<ModernVertex>& GetModelVertices() { return mModelVertices; }
+    // Returns a reference to the list of all line vertex indices in this model.
+    std::vector<uint32_t>& GetModelLineIndices() { return mModelLineIndices; }
+    // Returns a reference to the list of all point vertex indices in this model.
+    std::vector<uint32_t>& GetModelPointIndices() { return mModelPointIndices; }
 
     // Returns a const reference to the list of shapes in this model.
     const std::vector<std::shared_ptr<GXShape>>& GetShapes() const { return mShapes; }
@@ -137,7 +413,122 @@ public:
     const std::vector<uint32_t>& GetModelIndices() const { return mModelIndices; }
     // Returns a const reference to the list of all vertices in this model.
     const std::vector<ModernVertex>& GetModelVertices() const { return mModelVertices; }
-
-    // Processes the loaded geometry to be easier for modern GPUs to render.
-    void CreateVertexArray();
+    // Returns a const reference to the list of all line vertex indices in this model.
+    const std::vector<uint32_t>& GetModelLineIndices() const { return mModelLineIndices; }
+    // Returns a const reference to the list of all point vertex indices in this model.
+    const std::vector<uint32_t>& GetModelPointIndices() const { return mModelPointIndices; }
+    // Returns a const reference to the triangle vertex indices of every shape's levels of detail. Empty until BuildLods is called.
+    const std::vector<uint32_t>& GetModelLodIndices() const { return mModelLodIndices; }
+
+    // Returns a const reference to the layout of the compact vertex buffer.
+    const GXVertexLayout& GetCompactVertexLayout() const { return mCompactVertexLayout; }
+    // Returns a const reference to the compact vertex buffer. Empty until BuildCompactVertices is called.
+    const std::vector<uint8_t>& GetCompactVertices() const { return mCompactVertices; }
+    // Returns a const reference to the layout of the quantized vertex buffer.
+    const GXVertexLayout& GetQuantizedVertexLayout() const { return mQuantizedVertexLayout; }
+    // Returns a const reference to the quantized vertex buffer. Empty until BuildQuantizedVertices is called.
+    const std::vector<uint8_t>& GetQuantizedVertices() const { return mQuantizedVertices; }
+    // Returns the parameters for restoring the positions of model vertices outside of every shape, such as those
+    // from AddVertices, in the quantized vertex buffer. Vertices of a shape use GXShape::GetDequantizationParams.
+    const GXDequantizationParams& GetDequantizationParams() const { return mDequantizationParams; }
+    // Returns a const reference to the per-attribute vertex streams. Empty until BuildVertexStreams is called.
+    const GXAttributeData& GetModelStreams() const { return mModelStreams; }
+    // Returns a const reference to the model's meshlets. Empty until BuildMeshlets is called.
+    const GXMeshletList& GetModelMeshlets() const { return mModelMeshlets; }
+    // Returns a const reference to the bounds of every shape, as used by CullShapes. Empty until the shape bounds are calculated.
+    const GXBoundsArray& GetShapeBounds() const { return mShapeBounds; }
+
+    // Returns a reference to the attribute data that the vertices of primitives in index form refer to.
+    GXAttributeData& GetAttributeData() { return mAttributeData; }
+    // Returns a const reference to the attribute data that the vertices of primitives in index form refer to.
+    const GXAttributeData& GetAttributeData() const { return mAttributeData; }
+
+    // Processes the loaded geometry to be easier for modern GPUs to render. Every shape's primitives are
+    // triangulated into the model index list, with lines and points going to their own index lists.
+    // Vertices of primitives in index form are converted from the model's attribute data once per unique
+    // index tuple in each shape. The shapes' primitives are left untouched.
+    void CreateVertexArray(const GXVertexArrayOptions& options = GXVertexArrayOptions());
+
+    // Packs the model vertex list into an interleaved buffer holding only the attributes enabled
+    // in at least one shape's attribute table. Must be called again if the model vertices change.
+    void BuildCompactVertices();
+    // Packs the model vertex list like BuildCompactVertices, but with positions quantized to 16 bits
+    // relative to each shape's bounding box, octahedral 16-bit normals, 8-bit colors and half-float tex coords.
+    // Each shape's dequantization parameters are available through GXShape::GetDequantizationParams; vertices outside
+    // of every shape are quantized together to their own bounding box, with parameters from GetDequantizationParams.
+    void BuildQuantizedVertices();
+    // Splits the model vertex list into one contiguous stream per attribute, only for the attributes
+    // enabled in at least one shape's attribute table. Positions keep the position matrix index in w,
+    // so passes that only need positions can read 16 bytes per vertex.
+    void BuildVertexStreams();
+    // Calculates the center of mass, bounding box and bounding sphere of every shape from its range of the model
+    // vertex list. Must be called again if the model vertices change.
+    void CalculateShapeBounds(uint32_t threadCount = 1);
+
+    // Skins the model vertex list on the CPU with the given palette, writing one position and normal per model vertex.
+    // Each vertex uses the palette matrix selected by its position matrix index; see GXSkinVertices. Once matrix
+    // palettes are partitioned, the vertices of each draw are looked up through its palette slots instead, so the
+    // same model-wide palette still applies. Shapes are skinned across up to threadCount threads (0 for one per
+    // hardware thread).
+    void SkinVertices(const GXSkinPalette& palette, std::vector<glm::vec3>& positions, std::vector<glm::vec3>& normals, uint32_t threadCount = 1) const;
+
+    // Splits every shape's triangles, lines and points into draws that each use at most maxMatrices distinct position
+    // matrix indices, so that each draw can be rendered with one palette upload. Primitives are grouped into the draw
+    // that needs the fewest new matrices, keeping their relative order. Each draw gets its own copy of its vertices,
+    // with Position.w rewritten to the vertex's slot in the draw's palette; vertices without a matrix index keep 65535.
+    // Shapes' index and vertex ranges change, so meshlets and levels of detail are cleared
+    // and any built vertex buffers are rebuilt. Data outside of every shape, such as from AddVertices, is kept.
+    // The index optimization passes keep triangles inside their draw afterwards. Throws if the palettes have already
+    // been partitioned, since Position.w then holds slots; call CreateVertexArray first to partition again.
+    void PartitionMatrixPalettes(uint32_t maxMatrices, uint32_t threadCount = 1);
+
+    // Tests the bounds of every shape against the given frustum in one batch. Bit s % 32 of visibleBits[s / 32] is set
+    // if shape s may be visible. The shape bounds must have been calculated by CalculateShapeBounds or CreateVertexArray;
+    // a frustum built from projection * view * model culls an instance of this model placed with the given model matrix.
+    void CullShapes(const GXFrustum& frustum, std::vector<uint32_t>& visibleBits) const;
+    // Tests the bounds of every shape against the given frustum in one batch, and sets each shape's visible flag
+    // to the result. Returns the number of shapes that may be visible.
+    uint32_t CullShapes(const GXFrustum& frustum);
+    // Splits the triangles of every shape into meshlets of at most maxVertices vertices (up to 256) and maxTriangles
+    // triangles, each with a bounding sphere and normal cone for culling. Meshlet vertices index the model vertex list,
+    // and each meshlet records the shape it came from. Best run after the index optimizations, and must be called
+    // again if the model indices change.
+    void BuildMeshlets(uint32_t maxVertices = 64, uint32_t maxTriangles = 124, uint32_t threadCount = 1);
+
+    // Reorders the triangles of every shape for post-transform vertex cache locality on modern GPUs.
+    // Triangles never move out of their shape's index range, so per-shape draws keep working. Cache behaviour
+    // before and after is simulated with a FIFO cache of the given size, with each shape starting on an empty cache.
+    GXVertexCacheReport OptimizeVertexCache(uint32_t analysisCacheSize = 16, uint32_t threadCount = 1);
+    // Renumbers the vertices of every shape in the order its triangle, then line, then point indices first use them,
+    // so vertex fetches walk memory mostly sequentially. Best run after OptimizeVertexCache. Vertices stay inside
+    // their shape's model vertex range, and any vertex buffers that were already built are rebuilt to match.
+    void OptimizeVertexFetch(uint32_t threadCount = 1);
+    // Reorders the triangles of every shape to reduce overdraw, drawing outward-facing clusters first, while keeping
+    // the simulated cache miss ratio of each shape within threshold times its current value. Best run after
+    // OptimizeVertexCache. Shapes whose triangle order matters, such as translucent ones, can be skipped by passing
+    // a filter that returns false for them. Returns the cache behaviour of the processed shapes before and after.
+    GXVertexCacheReport OptimizeOverdraw(float threshold = 1.05f, const std::function<bool(const GXShape&)>& shapeFilter = nullptr,
+                                         uint32_t analysisCacheSize = 16, uint32_t threadCount = 1);
+
+    // Builds a chain of up to maxLods simplified levels of detail for every shape's triangles; see GXSimplifyMesh.
+    // Each level aims for reduction times the triangles of the one before it and is simplified from it, so errors
+    // accumulate down the chain; a chain stops early once a level would stray more than maxError, relative to the
+    // shape's size, or cannot get meaningfully smaller. The levels index the model vertex list, so they need no vertex
+    // data of their own, and are ordered for the vertex cache. Shapes split into draws are simplified one draw at a time.
+    // Vertex arrays created without welding work too, since GXSimplifyMesh welds bit-identical vertices itself.
+    // Recreating the vertex array or partitioning matrix palettes clears the levels.
+    void BuildLods(uint32_t maxLods = 4, float reduction = 0.5f, float maxError = 0.05f, uint32_t threadCount = 1);
+
+    // Generates a tangent frame for every shape's vertices from tex coord set texCoordIndex; see GXGenerateTangentFrames.
+    // Shapes whose attribute table has no normals first get smooth normals generated from their triangles. Vertices on
+    // a mirrored texture seam are split in two, growing their shape's vertex range, and if any are, meshlets and levels
+    // of detail are cleared. Vertices outside of every shape get zero frames. Afterwards the compact and quantized vertex
+    // buffers store the frames as the NBT attribute, and any that were already built are rebuilt to match. Must be
+    // called again after CreateVertexArray.
+    void GenerateTangentFrames(uint32_t texCoordIndex = 0, uint32_t threadCount = 1);
+
+    // Returns whether the model vertices' tangent frames have been generated since the vertex array was last created.
+    bool HasTangentFrames() const { return !mModelTangentFrames.empty(); }
+    // Returns a const reference to the tangent frame of every model vertex. Empty until GenerateTangentFrames is called.
+    const std::vector<glm::vec4>& GetModelTangentFrames() const { return mModelTangentFrames; }
 };
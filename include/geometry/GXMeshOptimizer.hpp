@@ -0,0 +1,46 @@
+#pragma once
+
+#include "GXVertexData.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+// Statistics from simulating a FIFO post-transform vertex cache over a triangle list.
+struct GXVertexCacheStats {
+    // The number of triangles simulated.
+    size_t TriangleCount;
+    // The number of vertices that missed the cache and had to be transformed.
+    size_t TransformedVertices;
+
+    GXVertexCacheStats() : TriangleCount(0), TransformedVertices(0) {}
+
+    // Returns the average cache miss ratio: transformed vertices per triangle. 0.5 is ideal and 3 is the worst case.
+    float GetACMR() const { return TriangleCount != 0 ? static_cast<float>(TransformedVertices) / TriangleCount : 0.0f; }
+
+    GXVertexCacheStats& operator+=(const GXVertexCacheStats& b) {
+        TriangleCount += b.TriangleCount;
+        TransformedVertices += b.TransformedVertices;
+        return *this;
+    }
+};
+
+// Simulates a FIFO post-transform vertex cache of the given size over the given triangle list.
+GXVertexCacheStats GXAnalyzeVertexCache(const uint32_t* indices, size_t indexCount, uint32_t cacheSize);
+
+// Reorders the triangles in the given list for post-transform vertex cache locality, using Tom Forsyth's
+// linear-speed vertex cache optimization. Every index must be in [firstVertex, firstVertex + vertexCount).
+void GXOptimizeVertexCache(uint32_t* indices, size_t indexCount, uint32_t firstVertex, uint32_t vertexCount);
+
+// Reorders the triangles in the given list to reduce overdraw, by splitting it into clusters and drawing the clusters
+// that face away from the centre of the mesh first, as they are the most likely to occlude the rest. The list should
+// already be optimized for the vertex cache; clusters are only split as finely as keeps the simulated cache miss ratio
+// of each original run of triangles within threshold times its current value. A threshold of 1 keeps the cache
+// efficiency intact, and larger values allow more clusters. Every index must be in [firstVertex, firstVertex + vertexCount)
+// and refers to an element of vertices.
+void GXOptimizeOverdraw(uint32_t* indices, size_t indexCount, const ModernVertex* vertices, uint32_t firstVertex, uint32_t vertexCount,
+                        float threshold, uint32_t cacheSize = 16);
+
+// Builds a vertex renumbering that orders the vertices in [firstVertex, firstVertex + vertexCount) by their first use
+// in the given index list, so vertex fetches walk memory mostly sequentially. remap[v - firstVertex] receives the new
+// index of vertex v, which stays inside the same range. Vertices the list never uses keep their relative order after the used ones.
+void GXBuildVertexFetchRemap(const uint32_t* indices, size_t indexCount, uint32_t firstVertex, uint32_t vertexCount, uint32_t* remap);
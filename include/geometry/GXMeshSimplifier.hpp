@@ -0,0 +1,24 @@
+#pragma once
+
+#include "GXVertexData.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Returns the scale that GXSimplifyMesh measures errors relative to: the largest extent of the bounding box of the
+// vertices in [firstVertex, firstVertex + vertexCount). Multiplying a relative error by it gives a distance in model units.
+float GXGetSimplifyScale(const ModernVertex* vertices, uint32_t firstVertex, uint32_t vertexCount);
+
+// Simplifies the given triangle list by collapsing edges in order of quadric error, until at most targetIndexCount
+// indices remain or every remaining collapse would move the surface further than targetError, relative to
+// GXGetSimplifyScale. Tex coord set 0 and color 0 are weighed in through attribute quadrics, so collapses that would
+// stretch textures or smear colors are taken last. Open borders and attribute seams, where vertices share a position
+// but not their other attributes, only collapse along themselves, and vertices on more complicated topology never move.
+// Bit-identical vertices are welded together first, so unwelded input simplifies like welded input; the result then
+// uses the first of each set of identical vertices. Vertices that only differ slightly are not merged.
+// The result only uses the given vertices, so it can share their vertex list. Every index must be in
+// [firstVertex, firstVertex + vertexCount) and refers to an element of vertices. Writes the simplified list to output
+// and returns the largest geometric error of the collapses made, relative to GXGetSimplifyScale.
+float GXSimplifyMesh(const uint32_t* indices, size_t indexCount, const ModernVertex* vertices, uint32_t firstVertex, uint32_t vertexCount,
+                     size_t targetIndexCount, float targetError, std::vector<uint32_t>& output);
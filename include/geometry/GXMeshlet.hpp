@@ -0,0 +1,63 @@
+#pragma once
+
+#include "GXVertexData.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// A small cluster of a shape's triangles, for culling and drawing at a finer grain than whole shapes.
+struct GXMeshlet {
+    // The offset of this meshlet's first vertex in the meshlet vertex list.
+    uint32_t VertexOffset;
+    // The offset of this meshlet's first triangle in the meshlet triangle list, in triangles.
+    uint32_t TriangleOffset;
+    // The number of unique vertices this meshlet uses.
+    uint32_t VertexCount;
+    // The number of triangles in this meshlet.
+    uint32_t TriangleCount;
+    // The index of the shape this meshlet was built from.
+    uint32_t ShapeIndex;
+
+    // The centre of a sphere enclosing every vertex of this meshlet.
+    glm::vec3 Center;
+    // The radius of a sphere enclosing every vertex of this meshlet.
+    float Radius;
+
+    // The apex of a cone that every triangle of this meshlet faces out of.
+    glm::vec3 ConeApex;
+    // The axis of the normal cone, pointing out of the front faces.
+    glm::vec3 ConeAxis;
+    // The sine of the cone's half-angle widened by 90 degrees. 1 when the triangles face too many ways for a useful cone.
+    float ConeCutoff;
+
+    GXMeshlet() : VertexOffset(0), TriangleOffset(0), VertexCount(0), TriangleCount(0), ShapeIndex(0),
+                  Center(0.0f), Radius(0.0f), ConeApex(0.0f), ConeAxis(0.0f), ConeCutoff(1.0f) {}
+
+    // Returns whether every triangle in this meshlet faces away from the given camera position, and can be culled.
+    // Meshlets without a useful cone, and cameras exactly on the apex, are never culled.
+    bool IsBackfacing(const glm::vec3& cameraPosition) const;
+};
+
+// The meshlets built from one triangle list.
+struct GXMeshletList {
+    // The meshlets, in the order their triangles appear in the source list.
+    std::vector<GXMeshlet> Meshlets;
+    // The vertices used by each meshlet, as indices into the vertex list the triangles index.
+    std::vector<uint32_t> Vertices;
+    // Three indices per triangle into the meshlet's slice of the vertex list.
+    std::vector<uint8_t> Triangles;
+
+    void Clear() {
+        Meshlets.clear();
+        Vertices.clear();
+        Triangles.clear();
+    }
+};
+
+// Splits the given triangle list into meshlets of at most maxVertices vertices (up to 256) and maxTriangles triangles,
+// appending them to output. Triangles are taken in order, so the list should already be optimized for the vertex cache
+// to get full meshlets. Each meshlet gets a bounding sphere and normal cone from the positions in vertices, which the
+// indices refer to. The new meshlets' ShapeIndex is set to shapeIndex.
+void GXBuildMeshlets(const uint32_t* indices, size_t indexCount, const ModernVertex* vertices, uint32_t maxVertices, uint32_t maxTriangles,
+                     uint32_t shapeIndex, GXMeshletList& output);
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "GXVertexData.hpp"
+#include "glm/mat4x4.hpp"
+
+#include <cstddef>
+#include <vector>
+
+// A palette of matrices to skin vertices with, indexed by the position matrix index stored in each vertex's Position.w.
+// GX display lists usually store a matrix's row in matrix memory as its index, which is three times its slot,
+// so the palette must be laid out the same way as the indices in the data.
+class GXSkinPalette {
+    // The matrices that transform positions.
+    std::vector<glm::mat4> mPositionMatrices;
+    // The inverse transposes of the position matrices, which transform normals.
+    std::vector<glm::mat4> mNormalMatrices;
+
+public:
+    GXSkinPalette() { }
+
+    // Replaces the palette with the given matrices, and precalculates the matrices for their normals.
+    void SetMatrices(const glm::mat4* matrices, size_t count);
+    // Replaces the palette with the given matrices, and precalculates the matrices for their normals.
+    void SetMatrices(const std::vector<glm::mat4>& matrices) { SetMatrices(matrices.data(), matrices.size()); }
+
+    // Returns a const reference to the matrices that transform positions.
+    const std::vector<glm::mat4>& GetPositionMatrices() const { return mPositionMatrices; }
+    // Returns a const reference to the matrices that transform normals.
+    const std::vector<glm::mat4>& GetNormalMatrices() const { return mNormalMatrices; }
+    // Returns the number of matrices in the palette.
+    size_t GetSize() const { return mPositionMatrices.size(); }
+};
+
+// Transforms the positions and normals of the given vertices by the palette matrices that their Position.w selects.
+// Vertices whose index is outside of the palette, including vertices without a position matrix index, are left
+// untransformed. Normals are renormalized after transforming. normals may be null to only skin positions.
+// Vertices of a draw made by GXGeometry::PartitionMatrixPalettes store a slot in the draw's palette instead of a
+// position matrix index; pass that draw's GXShapeDraw::Palette as drawPalette to look their matrices up through it.
+void GXSkinVertices(const ModernVertex* vertices, size_t count, const GXSkinPalette& palette, glm::vec3* positions, glm::vec3* normals,
+                    const std::vector<uint32_t>* drawPalette = nullptr);
+// Skins the vertices whose indices are given in ids, as above. Vertex ids[i] is read from vertices and written to
+// positions and normals at the same index, so a scattered set of vertices, such as those of one draw, can be skinned
+// in a single call. ids must not repeat a vertex.
+void GXSkinVertices(const ModernVertex* vertices, const uint32_t* ids, size_t count, const GXSkinPalette& palette, glm::vec3* positions,
+                    glm::vec3* normals, const std::vector<uint32_t>* drawPalette = nullptr);
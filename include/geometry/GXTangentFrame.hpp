@@ -0,0 +1,34 @@
+#pragma once
+
+#include "GXVertexData.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Packs an orthonormal normal and tangent, and the handedness of the bitangent, into a single unit quaternion.
+// The quaternion's w is kept away from zero so that its sign can carry the handedness, even once quantized
+// to 16-bit signed normalized values. The bitangent is cross(normal, tangent) * handedness.
+glm::vec4 GXEncodeTangentFrame(const glm::vec3& normal, const glm::vec3& tangent, float handedness);
+
+// Unpacks a tangent frame quaternion made by GXEncodeTangentFrame. The quaternion does not need to be normalized,
+// so frames read back from quantized vertex buffers can be passed in directly.
+void GXDecodeTangentFrame(const glm::vec4& frame, glm::vec3& normal, glm::vec3& tangent, glm::vec3& bitangent);
+
+// Replaces the normals of the vertices in [firstVertex, firstVertex + vertexCount) with smooth normals calculated
+// from the given triangle list. Face normals are weighted by area, and shared between vertices at the same position,
+// so seams in the other attributes do not show up as creases. Every index must be in the vertex range and refers
+// to an element of vertices. Vertices that no triangle uses get a zero normal.
+void GXGenerateSmoothNormals(ModernVertex* vertices, const uint32_t* indices, size_t indexCount, uint32_t firstVertex, uint32_t vertexCount);
+
+// Generates tangent frames for the vertices in [firstVertex, firstVertex + vertexCount) from their normals and the
+// given triangle list, following MikkTSpace: each triangle's texture-space tangent is projected onto the vertex's
+// tangent plane and weighted by the triangle's angle at the vertex, and the bitangent's handedness follows the
+// winding of the triangle in texture space. Tangents come from tex coord set texCoordIndex. Vertices that no triangle
+// gives a usable tangent get an arbitrary one perpendicular to their normal.
+// As in MikkTSpace, a vertex whose triangles disagree on handedness, such as one on the seam of a mirrored texture,
+// is split in two. The k-th split appends the vertex it copies to splitVertices, and the indices of the vertex's
+// left-handed triangles are rewritten to firstVertex + vertexCount + k, so the copies belong right after the range.
+// frames receives one frame per vertex in the range, followed by one per copy.
+void GXGenerateTangentFrames(const ModernVertex* vertices, uint32_t* indices, size_t indexCount, uint32_t firstVertex, uint32_t vertexCount,
+                             std::vector<glm::vec4>& frames, std::vector<uint32_t>& splitVertices, uint32_t texCoordIndex = 0);
@@ -5,6 +5,7 @@
 #include "glm/vec3.hpp"
 #include "glm/vec4.hpp"
 
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 #include <stdexcept>
@@ -65,6 +66,10 @@ public:
             throw std::out_of_range("Specified invalid vertex tex coord ID! (range is 0 to 7)");
     }
 
+    // Returns the number of elements in the array that the given attribute's indices refer to, or SIZE_MAX if its
+    // indices don't refer to an array here, as for the matrix index attributes.
+    size_t GetArraySize(EGXAttribute attribute) const;
+
     // Returns whether this model has position matrix data.
     bool HasPositionMatrixIndices() { return mPositionMatrixIndices.size() != 0; }
     // Returns whether this model has position data.
@@ -97,8 +102,25 @@ struct GXVertexAttributeFormat {
     }
 };
 
+// Represents how a per-vertex attribute is stored in a display list, i.e. one entry of the vertex descriptor.
+struct GXVertexDescriptor {
+    // What attribute this descriptor is for.
+    EGXAttribute Attribute;
+    // Whether the attribute is stored as an index into an array (and how large the index is) or as direct data.
+    EGXAttributeIndexType IndexType;
+
+    GXVertexDescriptor() : Attribute(EGXAttribute::Null), IndexType(EGXAttributeIndexType::None) {}
+
+    GXVertexDescriptor(const EGXAttribute attribute, const EGXAttributeIndexType indexType) {
+        Attribute = attribute;
+        IndexType = indexType;
+    }
+};
+
 // Represents a vertex found inside a primitive.
 class GXVertex {
+    friend struct GXVertexHash;
+
     // The indices that point to the data that this vertex is made up of.
     uint16_t AttributeIndices[(uint32_t)EGXAttribute::Attribute_Max];
 
@@ -114,6 +136,91 @@ public:
     bool operator!=(const GXVertex& b) const { return !operator==(b); };
 };
 
+// Hashes a GXVertex by all of its attribute indices.
+struct GXVertexHash {
+    size_t operator()(const GXVertex& v) const;
+};
+
+// Describes how the attribute indices of a vertex are packed into a compact key, holding only the attributes
+// enabled in an attribute table. Keys are arrays of 16-bit indices padded to a multiple of 8 bytes, so a
+// vertex with up to 4 attributes compares as a single 64-bit value and one with up to 8 as two.
+class GXPackedVertexFormat {
+    // The slot each attribute is packed into, or UINT8_MAX if the attribute isn't part of the key.
+    uint8_t mSlots[(uint32_t)EGXAttribute::Attribute_Max];
+    // The attributes in the key, in slot order.
+    std::vector<EGXAttribute> mAttributes;
+    // The size of a key, in 16-bit words.
+    uint32_t mStride;
+
+public:
+    GXPackedVertexFormat();
+    // Creates a format holding every attribute in the given table. The position matrix index is also kept
+    // whenever positions are enabled, since it is part of a converted vertex's position.
+    explicit GXPackedVertexFormat(const std::vector<EGXAttribute>& vat);
+
+    // Returns the size of a key, in 16-bit words.
+    uint32_t GetStride() const { return mStride; }
+    // Returns the slot the given attribute is packed into, or UINT8_MAX if it isn't part of the key.
+    uint8_t GetSlot(EGXAttribute attribute) const;
+    // Returns a const reference to the list of attributes in the key, in slot order.
+    const std::vector<EGXAttribute>& GetAttributes() const { return mAttributes; }
+
+    // Writes the key for the given vertex to the given array of GetStride() words.
+    void Pack(const GXVertex& vertex, uint16_t* key) const;
+    // Returns the vertex stored in the given key. Attributes that aren't part of the key are left unset.
+    GXVertex Unpack(const uint16_t* key) const;
+
+    bool operator==(const GXPackedVertexFormat& b) const { return mAttributes == b.mAttributes; }
+    bool operator!=(const GXPackedVertexFormat& b) const { return !operator==(b); }
+};
+
+// A hash table of packed vertex keys of a single stride, giving each unique key a dense id in insertion order.
+// Keys are stored back to back in one array, and the table itself only holds ids and hashes.
+class GXPackedVertexTable {
+    // A slot in the table. Id is UINT32_MAX for an empty slot.
+    struct Bucket {
+        uint32_t Id;
+        uint32_t Hash;
+    };
+
+    // The size of a key, in 16-bit words.
+    uint32_t mStride;
+    // Every unique key added to the table, in the order they were added.
+    std::vector<uint16_t> mKeys;
+    // The open-addressed table of ids. Always a power of two in size.
+    std::vector<Bucket> mBuckets;
+    // The number of unique keys in the table.
+    uint32_t mCount;
+
+    // Returns whether the given keys are the same.
+    bool KeysEqual(const uint16_t* a, const uint16_t* b) const;
+    // Rebuilds the table with the given number of buckets.
+    void Rehash(size_t bucketCount);
+
+public:
+    explicit GXPackedVertexTable(uint32_t stride = 4);
+
+    // Returns the hash of the given key with the given stride.
+    static uint32_t HashKey(const uint16_t* key, uint32_t stride);
+
+    // Returns the id of the given key, adding it to the table if it isn't there yet. Sets inserted to whether it was added.
+    uint32_t Insert(const uint16_t* key, bool& inserted);
+    // Returns the id of the given key, or UINT32_MAX if it isn't in the table.
+    uint32_t Find(const uint16_t* key) const;
+
+    // Returns the key with the given id.
+    const uint16_t* GetKey(uint32_t id) const { return mKeys.data() + static_cast<size_t>(id) * mStride; }
+    // Returns the number of unique keys in the table.
+    uint32_t GetCount() const { return mCount; }
+    // Returns the size of a key, in 16-bit words.
+    uint32_t GetStride() const { return mStride; }
+
+    // Prepares the table to hold the given number of unique keys without growing.
+    void Reserve(size_t count);
+    // Removes every key from the table, optionally switching to a new stride.
+    void Clear(uint32_t stride);
+};
+
 // Represents a vertex for use with modern GPUs.
 struct ModernVertex {
     glm::vec4 Position;
@@ -126,3 +233,65 @@ struct ModernVertex {
     bool operator==(const ModernVertex& other) const;
     bool operator!=(const ModernVertex& other) const { return !operator==(other); }
 };
+
+// Hashes a ModernVertex by its raw bit pattern, for welding identical vertices together.
+struct ModernVertexHash {
+    size_t operator()(const ModernVertex& v) const;
+};
+
+// Compares two ModernVertex values bit-for-bit. Unlike operator==, this keeps 0.0 and -0.0 apart
+// and treats a NaN as equal to itself, so it is consistent with ModernVertexHash.
+struct ModernVertexBitwiseEqual {
+    bool operator()(const ModernVertex& a, const ModernVertex& b) const;
+};
+
+// Converts a vertex's attribute indices into a ModernVertex using the given attribute data.
+// Only the attributes enabled in the given attribute table are read. Throws if an index is past the end of its array.
+ModernVertex GXVertexToModern(const GXAttributeData& Attributes, const std::vector<EGXAttribute>& vat, const GXVertex& Vertex);
+
+// Converts GXVertex index tuples into ModernVertex data, doing the conversion only once per unique tuple.
+// Can be kept alive across the shapes of a model to share converted vertices between them.
+class GXVertexCache {
+    // The attribute data that vertices are converted from.
+    const GXAttributeData* mAttributes;
+    // The attribute table that vertices are currently converted with.
+    std::vector<EGXAttribute> mVertexAttributeTable;
+    // The format tuples are packed with under the current attribute table.
+    GXPackedVertexFormat mFormat;
+
+    // The packed tuples seen under the current attribute table.
+    GXPackedVertexTable mTuples;
+    // The index in the converted vertex list of each tuple in the tuple table.
+    std::vector<uint32_t> mIndices;
+    // The converted vertices, in the order their tuples were first seen.
+    std::vector<ModernVertex> mVertices;
+
+public:
+    GXVertexCache(const GXAttributeData& attributes) : mAttributes(&attributes), mTuples(mFormat.GetStride()) {}
+
+    // Sets the attribute table that vertices are converted with. Changing it resets the tuple lookup,
+    // since the same tuple converts differently under another table; already converted vertices are kept.
+    void SetAttributeTable(const std::vector<EGXAttribute>& vat);
+
+    // Returns the index of the given vertex in the converted vertex list, converting it if it hasn't been seen before.
+    uint32_t GetIndex(const GXVertex& vertex);
+    // Returns the index of the given tuple, packed with GetFormat(), in the converted vertex list,
+    // converting it if it hasn't been seen before.
+    uint32_t GetIndex(const uint16_t* key);
+    // Returns the format tuples are packed with under the current attribute table.
+    const GXPackedVertexFormat& GetFormat() const { return mFormat; }
+    // Returns a const reference to the attribute data that vertices are converted from.
+    const GXAttributeData& GetAttributeData() const { return *mAttributes; }
+    // Returns the converted data for the given vertex, converting it if it hasn't been seen before.
+    const ModernVertex& GetVertex(const GXVertex& vertex) { return mVertices[GetIndex(vertex)]; }
+    // Appends the converted vertex index of every vertex in the given list to the given index list.
+    void GetIndices(const std::vector<GXVertex>& vertices, std::vector<uint32_t>& indices);
+
+    // Returns a reference to the list of converted vertices.
+    std::vector<ModernVertex>& GetVertices() { return mVertices; }
+    // Returns a const reference to the list of converted vertices.
+    const std::vector<ModernVertex>& GetVertices() const { return mVertices; }
+
+    // Removes all converted vertices and tuples from the cache.
+    void Clear();
+};
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "GXGeometryEnums.hpp"
+#include "GXVertexData.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// Represents the data format of a single element in an interleaved vertex.
+enum class EGXVertexElementFormat : uint8_t {
+    Float1,
+    Float2,
+    Float3,
+    Float4,
+
+    UInt32,
+
+    // Four 16-bit unsigned normalized values. Used for positions quantized to a shape's bounding box,
+    // with the fourth component left as padding.
+    UNorm16x4,
+    // Two 16-bit signed normalized values holding an octahedral-encoded unit vector.
+    OctahedralSNorm16x2,
+    // Four 8-bit unsigned normalized values.
+    UNorm8x4,
+    // Two 16-bit half-precision floats.
+    Half2,
+    // Four 16-bit signed normalized values. Used for tangent frame quaternions.
+    SNorm16x4
+};
+
+// Describes where one attribute is stored within an interleaved vertex, and in what format.
+struct GXVertexElement {
+    // The attribute stored in this element.
+    EGXAttribute Attribute;
+    // The format the attribute's data is stored in.
+    EGXVertexElementFormat Format;
+    // The offset of this element from the start of the vertex, in bytes.
+    uint32_t Offset;
+
+    GXVertexElement() : Attribute(EGXAttribute::Null), Format(EGXVertexElementFormat::Float1), Offset(0) {}
+
+    GXVertexElement(const EGXAttribute attribute, const EGXVertexElementFormat format, const uint32_t offset) {
+        Attribute = attribute;
+        Format = format;
+        Offset = offset;
+    }
+};
+
+// The parameters needed to restore a shape's quantized positions, as Position = Offset + Scale * Quantized
+// where Quantized is the UNorm16x4 value read as floats in the range [0, 1].
+struct GXDequantizationParams {
+    glm::vec3 PositionOffset;
+    glm::vec3 PositionScale;
+
+    GXDequantizationParams() : PositionOffset(0.0f), PositionScale(0.0f) {}
+};
+
+// Describes the layout of an interleaved vertex buffer, for setting up vertex input on the GPU.
+class GXVertexLayout {
+    // The elements making up a vertex, in the order they are stored.
+    std::vector<GXVertexElement> mElements;
+    // The size of a single vertex, in bytes.
+    uint32_t mStride;
+
+public:
+    GXVertexLayout() : mStride(0) {}
+
+    // Returns the size of the given format, in bytes.
+    static uint32_t GetFormatSize(EGXVertexElementFormat format);
+    // Returns the number of components in the given format.
+    static uint32_t GetFormatComponentCount(EGXVertexElementFormat format);
+
+    // Creates a layout holding every attribute enabled in at least one of the given attribute tables.
+    // Attributes are stored as 32-bit floats, or in compact quantized formats if quantized is true.
+    // If tangentFrames is true, the layout also stores each vertex's tangent frame quaternion as the NBT attribute.
+    static GXVertexLayout FromAttributeTables(const std::vector<const std::vector<EGXAttribute>*>& tables, bool quantized = false,
+                                              bool tangentFrames = false);
+
+    // Appends an element storing the given attribute in the given format to the end of the vertex.
+    void AddElement(EGXAttribute attribute, EGXVertexElementFormat format);
+    // Pads the vertex so that its size is a multiple of the given alignment.
+    void AlignStride(uint32_t alignment);
+
+    // Returns the element storing the given attribute, or nullptr if the layout doesn't contain it.
+    const GXVertexElement* FindElement(EGXAttribute attribute) const;
+
+    // Returns a const reference to the list of elements making up a vertex.
+    const std::vector<GXVertexElement>& GetElements() const { return mElements; }
+    // Returns the size of a single vertex, in bytes.
+    uint32_t GetStride() const { return mStride; }
+
+    // Returns whether the layout contains no elements.
+    bool IsEmpty() const { return mElements.empty(); }
+};
+
+// Calculates the parameters for quantizing the positions of the given vertices to their bounding box.
+GXDequantizationParams GXCalculateDequantizationParams(const ModernVertex* vertices, size_t count);
+
+// Converts the given vertices into the given layout, appending the packed data to the output buffer.
+// UNorm16x4 positions are quantized using the given parameters, which are required if the layout has any.
+// The NBT attribute is read from tangentFrames, which holds one frame per vertex and is required if the layout has it.
+void GXPackVertices(const ModernVertex* vertices, size_t count, const GXVertexLayout& layout, std::vector<uint8_t>& output,
+                    const GXDequantizationParams* params = nullptr, const glm::vec4* tangentFrames = nullptr);
@@ -0,0 +1,393 @@
+#include "geometry/GXAttributeDecoder.hpp"
+#include "util/GXEndian.hpp"
+#include "util/GXSimd.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+// Returns the size of a single component of the given non-color type, in bytes.
+static uint32_t GetComponentSize(EGXComponentType type) {
+    switch (type) {
+        case EGXComponentType::Unsigned8:
+        case EGXComponentType::Signed8:
+            return 1;
+        case EGXComponentType::Unsigned16:
+        case EGXComponentType::Signed16:
+            return 2;
+        case EGXComponentType::Float:
+            return 4;
+        default:
+            throw std::invalid_argument("Invalid component type for attribute data!");
+    }
+}
+
+// Returns the number of components in a single element of the given attribute's data.
+static uint32_t GetComponentCount(EGXAttribute attribute, EGXComponentCount count) {
+    switch (attribute) {
+        case EGXAttribute::Position:
+            return count == EGXComponentCount::Position_XY ? 2 : 3;
+        case EGXAttribute::Normal:
+        case EGXAttribute::NBT:
+            // NBT data stores the normal, binormal and tangent back to back. NBT3 data stores them
+            // as separate elements with their own indices, so each element is a single vector.
+            return count == EGXComponentCount::Normal_NBT ? 9 : 3;
+        case EGXAttribute::TexCoord0:
+        case EGXAttribute::TexCoord1:
+        case EGXAttribute::TexCoord2:
+        case EGXAttribute::TexCoord3:
+        case EGXAttribute::TexCoord4:
+        case EGXAttribute::TexCoord5:
+        case EGXAttribute::TexCoord6:
+        case EGXAttribute::TexCoord7:
+            return count == EGXComponentCount::TexCoord_U ? 1 : 2;
+        default:
+            throw std::invalid_argument("Attribute does not have array data that can be decoded!");
+    }
+}
+
+// Describes a GX color format as a big-endian packed value, with each channel stored in a run of bits.
+struct PackedColorFormat {
+    // The size of a single color, in bytes.
+    uint32_t Size;
+    // The position of each channel's lowest bit within the packed value, in RGBA order.
+    uint32_t Shift[4];
+    // The number of bits in each channel, in RGBA order. Channels with no bits decode as 1.
+    uint32_t Bits[4];
+};
+
+// Returns the packed layout of the given color format.
+static const PackedColorFormat& GetPackedColorFormat(EGXComponentType type) {
+    static const PackedColorFormat formats[] = {
+        { 2, { 11, 5, 0, 0 }, { 5, 6, 5, 0 } },     // RGB565
+        { 3, { 16, 8, 0, 0 }, { 8, 8, 8, 0 } },     // RGB8
+        { 4, { 24, 16, 8, 0 }, { 8, 8, 8, 0 } },    // RGBX8
+        { 2, { 12, 8, 4, 0 }, { 4, 4, 4, 4 } },     // RGBA4
+        { 3, { 18, 12, 6, 0 }, { 6, 6, 6, 6 } },    // RGBA6
+        { 4, { 24, 16, 8, 0 }, { 8, 8, 8, 8 } },    // RGBA8
+    };
+
+    uint32_t index = (uint32_t)type;
+    if (index > (uint32_t)EGXComponentType::RGBA8)
+        throw std::invalid_argument("Invalid component type for color data!");
+
+    return formats[index];
+}
+
+// Returns a table that maps every value of a channel with the given number of bits (1-8) to a normalized float.
+static const float* GetChannelTable(uint32_t bits) {
+    struct ChannelTables {
+        float Values[9][256];
+
+        ChannelTables() {
+            for (uint32_t b = 1; b <= 8; b++) {
+                const float max = static_cast<float>((1u << b) - 1);
+
+                for (uint32_t v = 0; v < 256; v++) {
+                    Values[b][v] = v < (1u << b) ? static_cast<float>(v) / max : 0.0f;
+                }
+            }
+        }
+    };
+
+    static const ChannelTables tables;
+    return tables.Values[bits];
+}
+
+uint32_t GXGetAttributeElementSize(const GXVertexAttributeFormat& format) {
+    if (format.Attribute == EGXAttribute::Color0 || format.Attribute == EGXAttribute::Color1)
+        return GetPackedColorFormat(format.ComponentType).Size;
+
+    return GetComponentCount(format.Attribute, format.ComponentCount) * GetComponentSize(format.ComponentType);
+}
+
+// Converts a run of scalar components from big-endian data into floats. Integer components are divided by 2^shift.
+// GX stores the shift in 5 bits, so only the low 5 bits of the given shift are used.
+static void DecodeComponents(const uint8_t* src, size_t count, EGXComponentType type, uint8_t shift, float* dst) {
+    const float scale = 1.0f / static_cast<float>(1u << (shift & 31));
+    size_t i = 0;
+
+    switch (type) {
+        case EGXComponentType::Float:
+        {
+#if defined(LIBFLIPPER_AVX2)
+            const __m256i swap32 = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                                    3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+            for (; i + 8 <= count; i += 8) {
+                __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 4));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_shuffle_epi8(v, swap32));
+            }
+#elif defined(LIBFLIPPER_SSE2)
+            for (; i + 4 <= count; i += 4) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+                // Swap the bytes in each 16-bit half, then swap the halves.
+                v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+                v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), v);
+            }
+#endif
+            for (; i < count; i++) {
+                uint32_t bits = ReadBE32(src + i * 4);
+                std::memcpy(dst + i, &bits, sizeof(float));
+            }
+            break;
+        }
+        case EGXComponentType::Unsigned16:
+        case EGXComponentType::Signed16:
+        {
+            const bool isSigned = type == EGXComponentType::Signed16;
+#if defined(LIBFLIPPER_AVX2)
+            const __m256 scale8 = _mm256_set1_ps(scale);
+            const __m128i swap16 = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+            for (; i + 8 <= count; i += 8) {
+                __m128i v = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2)), swap16);
+                __m256i wide = isSigned ? _mm256_cvtepi16_epi32(v) : _mm256_cvtepu16_epi32(v);
+                _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(wide), scale8));
+            }
+#elif defined(LIBFLIPPER_SSE2)
+            const __m128 scale4 = _mm_set1_ps(scale);
+            const __m128i zero = _mm_setzero_si128();
+            for (; i + 8 <= count; i += 8) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2));
+                v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+
+                __m128i lo, hi;
+                if (isSigned) {
+                    lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+                    hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+                }
+                else {
+                    lo = _mm_unpacklo_epi16(v, zero);
+                    hi = _mm_unpackhi_epi16(v, zero);
+                }
+
+                _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale4));
+                _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale4));
+            }
+#endif
+            for (; i < count; i++) {
+                uint16_t bits = ReadBE16(src + i * 2);
+                float value = isSigned ? static_cast<float>(static_cast<int16_t>(bits)) : static_cast<float>(bits);
+                dst[i] = value * scale;
+            }
+            break;
+        }
+        case EGXComponentType::Unsigned8:
+        case EGXComponentType::Signed8:
+        {
+            const bool isSigned = type == EGXComponentType::Signed8;
+#if defined(LIBFLIPPER_AVX2)
+            const __m256 scale8 = _mm256_set1_ps(scale);
+            for (; i + 8 <= count; i += 8) {
+                __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i));
+                __m256i wide = isSigned ? _mm256_cvtepi8_epi32(v) : _mm256_cvtepu8_epi32(v);
+                _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(wide), scale8));
+            }
+#elif defined(LIBFLIPPER_SSE2)
+            const __m128 scale4 = _mm_set1_ps(scale);
+            const __m128i zero = _mm_setzero_si128();
+            for (; i + 16 <= count; i += 16) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+
+                // Widen to 16 bits, sign extending by placing each byte in the high half and shifting it back down.
+                __m128i lo16 = isSigned ? _mm_srai_epi16(_mm_unpacklo_epi8(v, v), 8) : _mm_unpacklo_epi8(v, zero);
+                __m128i hi16 = isSigned ? _mm_srai_epi16(_mm_unpackhi_epi8(v, v), 8) : _mm_unpackhi_epi8(v, zero);
+
+                __m128i words[2] = { lo16, hi16 };
+                for (int w = 0; w < 2; w++) {
+                    __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(words[w], words[w]), 16);
+                    __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(words[w], words[w]), 16);
+
+                    _mm_storeu_ps(dst + i + w * 8, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale4));
+                    _mm_storeu_ps(dst + i + w * 8 + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale4));
+                }
+            }
+#endif
+            for (; i < count; i++) {
+                float value = isSigned ? static_cast<float>(static_cast<int8_t>(src[i])) : static_cast<float>(src[i]);
+                dst[i] = value * scale;
+            }
+            break;
+        }
+        default:
+            throw std::invalid_argument("Invalid component type for attribute data!");
+    }
+}
+
+// Decodes elements of the given width into a list of vectors with the given number of components,
+// zero-filling any components that the source data doesn't have.
+template<typename T>
+static void DecodeElements(const uint8_t* data, size_t count, const GXVertexAttributeFormat& format, uint32_t sourceComponents,
+                           uint32_t usedComponents, uint8_t shift, std::vector<T>& output) {
+    const uint32_t destComponents = sizeof(T) / sizeof(float);
+    size_t start = output.size();
+    output.resize(start + count, T(0.0f));
+
+    float* dst = reinterpret_cast<float*>(output.data() + start);
+
+    // When the layouts match, decode straight into the output list.
+    if (sourceComponents == destComponents) {
+        DecodeComponents(data, count * sourceComponents, format.ComponentType, shift, dst);
+        return;
+    }
+
+    std::vector<float> scratch(count * sourceComponents);
+    DecodeComponents(data, scratch.size(), format.ComponentType, shift, scratch.data());
+
+    for (size_t i = 0; i < count; i++) {
+        for (uint32_t c = 0; c < usedComponents; c++) {
+            dst[i * destComponents + c] = scratch[i * sourceComponents + c];
+        }
+    }
+}
+
+#if defined(LIBFLIPPER_SSE2)
+// Splits four packed colors, one per 32-bit lane, into their channels and stores them as four RGBA floats.
+static inline void ExpandPackedColors(__m128i packed, const PackedColorFormat& format, float* dst) {
+    __m128 channels[4];
+
+    for (int c = 0; c < 4; c++) {
+        if (format.Bits[c] == 0) {
+            channels[c] = _mm_set1_ps(1.0f);
+            continue;
+        }
+
+        const __m128i mask = _mm_set1_epi32((1 << format.Bits[c]) - 1);
+        const __m128 scale = _mm_set1_ps(1.0f / static_cast<float>((1 << format.Bits[c]) - 1));
+
+        __m128i value = _mm_and_si128(_mm_srl_epi32(packed, _mm_cvtsi32_si128(format.Shift[c])), mask);
+        channels[c] = _mm_mul_ps(_mm_cvtepi32_ps(value), scale);
+    }
+
+    // Each register holds one channel of four colors; transpose them into four colors.
+    _MM_TRANSPOSE4_PS(channels[0], channels[1], channels[2], channels[3]);
+
+    for (int c = 0; c < 4; c++) {
+        _mm_storeu_ps(dst + c * 4, channels[c]);
+    }
+}
+#endif
+
+void GXDecodeColorArray(const uint8_t* data, size_t count, EGXComponentType type, std::vector<glm::vec4>& output) {
+    const PackedColorFormat& format = GetPackedColorFormat(type);
+
+    size_t start = output.size();
+    output.resize(start + count);
+
+    float* dst = reinterpret_cast<float*>(output.data() + start);
+    size_t i = 0;
+
+#if defined(LIBFLIPPER_SSE2)
+    switch (format.Size) {
+        case 2:
+            // Eight 16-bit colors per load, byte-swapped and widened into two sets of four lanes.
+            for (; i + 8 <= count; i += 8) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * 2));
+                v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+
+                ExpandPackedColors(_mm_unpacklo_epi16(v, _mm_setzero_si128()), format, dst + i * 4);
+                ExpandPackedColors(_mm_unpackhi_epi16(v, _mm_setzero_si128()), format, dst + i * 4 + 16);
+            }
+            break;
+        case 3:
+        {
+#if defined(LIBFLIPPER_SSSE3)
+            // Gather four 24-bit colors into the low bytes of four lanes, reversing their byte order.
+            // Each load reads 16 bytes for 12 bytes of colors, so stop while a full load is still in bounds.
+            const __m128i gather24 = _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+            for (; i + 4 <= count && (count - i) * 3 >= 16; i += 4) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * 3));
+                ExpandPackedColors(_mm_shuffle_epi8(v, gather24), format, dst + i * 4);
+            }
+#else
+            for (; i + 4 <= count; i += 4) {
+                const uint8_t* src = data + i * 3;
+                __m128i v = _mm_setr_epi32((src[0] << 16) | (src[1] << 8) | src[2],
+                                           (src[3] << 16) | (src[4] << 8) | src[5],
+                                           (src[6] << 16) | (src[7] << 8) | src[8],
+                                           (src[9] << 16) | (src[10] << 8) | src[11]);
+                ExpandPackedColors(v, format, dst + i * 4);
+            }
+#endif
+            break;
+        }
+        case 4:
+            for (; i + 4 <= count; i += 4) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * 4));
+                v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+                v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+
+                ExpandPackedColors(v, format, dst + i * 4);
+            }
+            break;
+    }
+#endif
+
+    // Convert whatever is left through per-channel lookup tables.
+    const float* tables[4];
+    uint32_t masks[4];
+    for (int c = 0; c < 4; c++) {
+        tables[c] = format.Bits[c] != 0 ? GetChannelTable(format.Bits[c]) : nullptr;
+        masks[c] = (1u << format.Bits[c]) - 1;
+    }
+
+    for (; i < count; i++) {
+        const uint8_t* src = data + i * format.Size;
+
+        uint32_t packed = 0;
+        for (uint32_t b = 0; b < format.Size; b++) {
+            packed = (packed << 8) | src[b];
+        }
+
+        for (int c = 0; c < 4; c++) {
+            dst[i * 4 + c] = tables[c] != nullptr ? tables[c][(packed >> format.Shift[c]) & masks[c]] : 1.0f;
+        }
+    }
+}
+
+void GXDecodeAttributeArray(const uint8_t* data, size_t count, const GXVertexAttributeFormat& format, GXAttributeData& attributes) {
+    // Colors use their own packed formats, so only look up a component count for the other attributes.
+    const bool isColor = format.Attribute == EGXAttribute::Color0 || format.Attribute == EGXAttribute::Color1;
+    const uint32_t components = isColor ? 0 : GetComponentCount(format.Attribute, format.ComponentCount);
+
+    switch (format.Attribute) {
+        case EGXAttribute::Position:
+            DecodeElements(data, count, format, components, components, format.FixedPoint, attributes.GetPositions());
+            break;
+        case EGXAttribute::Normal:
+        case EGXAttribute::NBT:
+        {
+            // The hardware ignores the format's shift for normals and always uses 6 bits for 8-bit data and 14 for 16-bit data.
+            uint8_t shift = format.FixedPoint;
+            if (format.ComponentType == EGXComponentType::Signed8 || format.ComponentType == EGXComponentType::Unsigned8)
+                shift = 6;
+            else if (format.ComponentType == EGXComponentType::Signed16 || format.ComponentType == EGXComponentType::Unsigned16)
+                shift = 14;
+
+            // Only the normal of NBT data is kept, as the attribute data has nowhere to store the binormal and tangent.
+            DecodeElements(data, count, format, components, 3, shift, attributes.GetNormals());
+            break;
+        }
+        case EGXAttribute::Color0:
+        case EGXAttribute::Color1:
+        {
+            uint32_t channel = (uint32_t)format.Attribute - (uint32_t)EGXAttribute::Color0;
+            GXDecodeColorArray(data, count, format.ComponentType, attributes.GetColors(channel));
+            break;
+        }
+        case EGXAttribute::TexCoord0:
+        case EGXAttribute::TexCoord1:
+        case EGXAttribute::TexCoord2:
+        case EGXAttribute::TexCoord3:
+        case EGXAttribute::TexCoord4:
+        case EGXAttribute::TexCoord5:
+        case EGXAttribute::TexCoord6:
+        case EGXAttribute::TexCoord7:
+        {
+            uint32_t channel = (uint32_t)format.Attribute - (uint32_t)EGXAttribute::TexCoord0;
+            DecodeElements(data, count, format, components, components, format.FixedPoint, attributes.GetTexCoords(channel));
+            break;
+        }
+        default:
+            throw std::invalid_argument("Attribute does not have array data that can be decoded!");
+    }
+}
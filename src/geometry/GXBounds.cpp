@@ -0,0 +1,215 @@
+#include "geometry/GXBounds.hpp"
+#include "util/GXSimd.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+void GXAccumulateBounds(const ModernVertex* vertices, size_t count, glm::vec3& positionSum, GXBoundingBox& box) {
+    size_t i = 0;
+
+#if defined(LIBFLIPPER_SSE2)
+    // Each position is loaded whole; the matrix index in w rides along and is dropped at the end.
+    // Two sets of accumulators hide the latency of the adds.
+    __m128 sum0 = _mm_setzero_ps();
+    __m128 sum1 = _mm_setzero_ps();
+    __m128 min0 = _mm_setr_ps(box.Min.x, box.Min.y, box.Min.z, 0.0f);
+    __m128 max0 = _mm_setr_ps(box.Max.x, box.Max.y, box.Max.z, 0.0f);
+    __m128 min1 = min0;
+    __m128 max1 = max0;
+
+    for (; i + 2 <= count; i += 2) {
+        __m128 p0 = _mm_loadu_ps(&vertices[i].Position.x);
+        __m128 p1 = _mm_loadu_ps(&vertices[i + 1].Position.x);
+
+        sum0 = _mm_add_ps(sum0, p0);
+        sum1 = _mm_add_ps(sum1, p1);
+        min0 = _mm_min_ps(min0, p0);
+        min1 = _mm_min_ps(min1, p1);
+        max0 = _mm_max_ps(max0, p0);
+        max1 = _mm_max_ps(max1, p1);
+    }
+
+    float sum[4], min[4], max[4];
+    _mm_storeu_ps(sum, _mm_add_ps(sum0, sum1));
+    _mm_storeu_ps(min, _mm_min_ps(min0, min1));
+    _mm_storeu_ps(max, _mm_max_ps(max0, max1));
+
+    positionSum += glm::vec3(sum[0], sum[1], sum[2]);
+    box.Min = glm::vec3(min[0], min[1], min[2]);
+    box.Max = glm::vec3(max[0], max[1], max[2]);
+#endif
+
+    for (; i < count; i++) {
+        const glm::vec4& p = vertices[i].Position;
+
+        positionSum += glm::vec3(p);
+        box.Min = glm::vec3(std::min(box.Min.x, p.x), std::min(box.Min.y, p.y), std::min(box.Min.z, p.z));
+        box.Max = glm::vec3(std::max(box.Max.x, p.x), std::max(box.Max.y, p.y), std::max(box.Max.z, p.z));
+    }
+}
+
+float GXCalculateMaxDistanceSquared(const ModernVertex* vertices, size_t count, const glm::vec3& center) {
+    float maxDistance = 0.0f;
+    size_t i = 0;
+
+#if defined(LIBFLIPPER_SSE2)
+    // Transpose four positions at a time so that each lane holds one vertex's distance.
+    const __m128 cx = _mm_set1_ps(center.x);
+    const __m128 cy = _mm_set1_ps(center.y);
+    const __m128 cz = _mm_set1_ps(center.z);
+    __m128 maxDistances = _mm_setzero_ps();
+
+    for (; i + 4 <= count; i += 4) {
+        __m128 x = _mm_loadu_ps(&vertices[i].Position.x);
+        __m128 y = _mm_loadu_ps(&vertices[i + 1].Position.x);
+        __m128 z = _mm_loadu_ps(&vertices[i + 2].Position.x);
+        __m128 w = _mm_loadu_ps(&vertices[i + 3].Position.x);
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+
+        __m128 dx = _mm_sub_ps(x, cx);
+        __m128 dy = _mm_sub_ps(y, cy);
+        __m128 dz = _mm_sub_ps(z, cz);
+        __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+
+        maxDistances = _mm_max_ps(maxDistances, d);
+    }
+
+    float lanes[4];
+    _mm_storeu_ps(lanes, maxDistances);
+    maxDistance = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+#endif
+
+    for (; i < count; i++) {
+        glm::vec3 d = glm::vec3(vertices[i].Position) - center;
+        maxDistance = std::max(maxDistance, d.x * d.x + d.y * d.y + d.z * d.z);
+    }
+
+    return maxDistance;
+}
+
+GXFrustum GXFrustum::FromMatrix(const glm::mat4& viewProjection, bool zeroToOneDepth) {
+    // Each plane is a sum or difference of the matrix's rows (Gribb and Hartmann). glm matrices are column-major.
+    glm::vec4 rows[4];
+    for (int r = 0; r < 4; r++) {
+        rows[r] = glm::vec4(viewProjection[0][r], viewProjection[1][r], viewProjection[2][r], viewProjection[3][r]);
+    }
+
+    GXFrustum frustum;
+    frustum.Planes[0] = rows[3] + rows[0];
+    frustum.Planes[1] = rows[3] - rows[0];
+    frustum.Planes[2] = rows[3] + rows[1];
+    frustum.Planes[3] = rows[3] - rows[1];
+    frustum.Planes[4] = zeroToOneDepth ? rows[2] : rows[3] + rows[2];
+    frustum.Planes[5] = rows[3] - rows[2];
+
+    for (glm::vec4& plane : frustum.Planes) {
+        float length = std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+        if (length > 0.0f)
+            plane /= length;
+    }
+
+    return frustum;
+}
+
+void GXBoundsArray::Resize(size_t count) {
+    const size_t padded = (count + 3) & ~static_cast<size_t>(3);
+    Count = count;
+
+    for (std::vector<float>* component : { &CenterX, &CenterY, &CenterZ, &ExtentX, &ExtentY, &ExtentZ }) {
+        component->assign(padded, 0.0f);
+    }
+
+    // A sphere of negative infinite radius is outside of every plane.
+    Radius.assign(padded, -FLT_MAX);
+}
+
+void GXBoundsArray::Set(size_t index, const GXBoundingBox& box, const GXBoundingSphere& sphere) {
+    if (box.IsEmpty()) {
+        CenterX[index] = CenterY[index] = CenterZ[index] = 0.0f;
+        ExtentX[index] = ExtentY[index] = ExtentZ[index] = 0.0f;
+        Radius[index] = -FLT_MAX;
+        return;
+    }
+
+    glm::vec3 center = box.GetCenter();
+    glm::vec3 extents = box.GetExtents();
+
+    CenterX[index] = center.x;
+    CenterY[index] = center.y;
+    CenterZ[index] = center.z;
+    ExtentX[index] = extents.x;
+    ExtentY[index] = extents.y;
+    ExtentZ[index] = extents.z;
+    Radius[index] = sphere.Radius;
+
+    // The sphere is tested against planes through the box's centre, so it has to be centred there too.
+    glm::vec3 offset = sphere.Center - center;
+    Radius[index] += std::sqrt(offset.x * offset.x + offset.y * offset.y + offset.z * offset.z);
+}
+
+void GXCullBounds(const GXBoundsArray& bounds, const GXFrustum& frustum, uint32_t* visibleBits) {
+    const size_t wordCount = (bounds.Count + 31) / 32;
+    std::memset(visibleBits, 0, wordCount * sizeof(uint32_t));
+
+    size_t i = 0;
+
+#if defined(LIBFLIPPER_SSE2)
+    const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+
+    __m128 planeX[6], planeY[6], planeZ[6], planeW[6], absX[6], absY[6], absZ[6];
+    for (int p = 0; p < 6; p++) {
+        planeX[p] = _mm_set1_ps(frustum.Planes[p].x);
+        planeY[p] = _mm_set1_ps(frustum.Planes[p].y);
+        planeZ[p] = _mm_set1_ps(frustum.Planes[p].z);
+        planeW[p] = _mm_set1_ps(frustum.Planes[p].w);
+        absX[p] = _mm_and_ps(planeX[p], signMask);
+        absY[p] = _mm_and_ps(planeY[p], signMask);
+        absZ[p] = _mm_and_ps(planeZ[p], signMask);
+    }
+
+    for (; i + 4 <= bounds.CenterX.size(); i += 4) {
+        __m128 cx = _mm_loadu_ps(&bounds.CenterX[i]);
+        __m128 cy = _mm_loadu_ps(&bounds.CenterY[i]);
+        __m128 cz = _mm_loadu_ps(&bounds.CenterZ[i]);
+        __m128 ex = _mm_loadu_ps(&bounds.ExtentX[i]);
+        __m128 ey = _mm_loadu_ps(&bounds.ExtentY[i]);
+        __m128 ez = _mm_loadu_ps(&bounds.ExtentZ[i]);
+        __m128 radius = _mm_loadu_ps(&bounds.Radius[i]);
+
+        __m128 outside = _mm_setzero_ps();
+        for (int p = 0; p < 6; p++) {
+            // The signed distance from the plane to the centre, and how far the box reaches towards the plane.
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], cx), _mm_mul_ps(planeY[p], cy)),
+                                         _mm_add_ps(_mm_mul_ps(planeZ[p], cz), planeW[p]));
+            __m128 reach = _mm_add_ps(_mm_add_ps(_mm_mul_ps(absX[p], ex), _mm_mul_ps(absY[p], ey)), _mm_mul_ps(absZ[p], ez));
+
+            reach = _mm_min_ps(reach, radius);
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, reach), _mm_setzero_ps()));
+        }
+
+        uint32_t visible = ~static_cast<uint32_t>(_mm_movemask_ps(outside)) & 0xF;
+        visibleBits[i / 32] |= visible << (i % 32);
+    }
+#endif
+
+    for (; i < bounds.Count; i++) {
+        bool outside = false;
+
+        for (int p = 0; p < 6 && !outside; p++) {
+            const glm::vec4& plane = frustum.Planes[p];
+
+            float distance = plane.x * bounds.CenterX[i] + plane.y * bounds.CenterY[i] + plane.z * bounds.CenterZ[i] + plane.w;
+            float reach = std::fabs(plane.x) * bounds.ExtentX[i] + std::fabs(plane.y) * bounds.ExtentY[i] + std::fabs(plane.z) * bounds.ExtentZ[i];
+
+            outside = distance + std::min(reach, bounds.Radius[i]) < 0.0f;
+        }
+
+        if (!outside)
+            visibleBits[i / 32] |= 1u << (i % 32);
+    }
+
+    // Padding is always culled, but clear its bits anyway so they can be counted safely.
+    if (bounds.Count % 32 != 0)
+        visibleBits[wordCount - 1] &= (1u << (bounds.Count % 32)) - 1;
+}
@@ -0,0 +1,572 @@
+#include "geometry/GXBvh.hpp"
+#include "geometry/GXGeometryData.hpp"
+#include "util/GXParallel.hpp"
+#include "glm/common.hpp"
+#include "glm/geometric.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+    // The number of bins the surface area heuristic sorts centroids into along each axis.
+    const uint32_t kBinCount = 16;
+    // Nodes with this many triangles or fewer are never split.
+    const uint32_t kMinLeafSize = 2;
+    // Nodes with more triangles than this are always split.
+    const uint32_t kMaxLeafSize = 8;
+    // Nodes this deep are always leaves, which bounds the traversal stacks.
+    const uint32_t kMaxDepth = 60;
+    // How many items each thread takes at a time in the flat parallel loops.
+    const size_t kChunkSize = 1024;
+    // How many subtrees the top of the tree is split into before they are built in parallel. It is fixed rather
+    // than derived from the thread count, since it decides where nodes are placed.
+    const size_t kFrontierSize = 64;
+
+    // A triangle being sorted into the hierarchy.
+    struct BuildRef {
+        glm::vec3 Min;
+        glm::vec3 Max;
+        glm::vec3 Centroid;
+        uint32_t Triangle;
+    };
+
+    // A node waiting to be split, covering refs [Begin, End).
+    struct BuildTask {
+        uint32_t Node;
+        uint32_t Begin;
+        uint32_t End;
+        uint32_t Depth;
+    };
+
+    // Returns half the surface area of the given box, or 0 if it is empty.
+    float HalfArea(const glm::vec3& min, const glm::vec3& max) {
+        glm::vec3 d = max - min;
+        if (d.x < 0.0f || d.y < 0.0f || d.z < 0.0f)
+            return 0.0f;
+
+        return d.x * d.y + d.y * d.z + d.z * d.x;
+    }
+
+    // Calls func(first, last) over [0, count) in chunks, spread across threads.
+    template<typename Func>
+    void ParallelForChunks(size_t count, uint32_t threadCount, Func func) {
+        ParallelFor((count + kChunkSize - 1) / kChunkSize, threadCount, [&](size_t c) {
+            func(c * kChunkSize, std::min(count, (c + 1) * kChunkSize));
+        });
+    }
+
+    // Sets the node's box to enclose refs [begin, end), then either makes it a leaf or splits the refs between
+    // two new children. Returns whether the node was split, with the refs of the first child ending at mid.
+    bool SplitNode(std::vector<GXBvhNode>& nodes, BuildTask task, BuildRef* refs, uint32_t& mid) {
+        glm::vec3 nodeMin(FLT_MAX), nodeMax(-FLT_MAX);
+        glm::vec3 centroidMin(FLT_MAX), centroidMax(-FLT_MAX);
+
+        for (uint32_t i = task.Begin; i < task.End; i++) {
+            nodeMin = glm::min(nodeMin, refs[i].Min);
+            nodeMax = glm::max(nodeMax, refs[i].Max);
+            centroidMin = glm::min(centroidMin, refs[i].Centroid);
+            centroidMax = glm::max(centroidMax, refs[i].Centroid);
+        }
+
+        nodes[task.Node].Min = nodeMin;
+        nodes[task.Node].Max = nodeMax;
+        nodes[task.Node].LeftOrFirst = task.Begin;
+        nodes[task.Node].Count = task.End - task.Begin;
+
+        const uint32_t count = task.End - task.Begin;
+        if (count <= kMinLeafSize || task.Depth >= kMaxDepth)
+            return false;
+
+        // Find the cheapest split between bins along any axis.
+        float bestCost = FLT_MAX;
+        int bestAxis = -1;
+        uint32_t bestBin = 0;
+
+        for (int axis = 0; axis < 3; axis++) {
+            const float extent = centroidMax[axis] - centroidMin[axis];
+            if (!(extent > 0.0f))
+                continue;
+
+            struct Bin {
+                glm::vec3 Min = glm::vec3(FLT_MAX);
+                glm::vec3 Max = glm::vec3(-FLT_MAX);
+                uint32_t Count = 0;
+            } bins[kBinCount];
+
+            const float scale = kBinCount / extent;
+            for (uint32_t i = task.Begin; i < task.End; i++) {
+                uint32_t b = std::min(kBinCount - 1, static_cast<uint32_t>((refs[i].Centroid[axis] - centroidMin[axis]) * scale));
+                bins[b].Min = glm::min(bins[b].Min, refs[i].Min);
+                bins[b].Max = glm::max(bins[b].Max, refs[i].Max);
+                bins[b].Count++;
+            }
+
+            // Sweep from the right to get the cost of everything past each split, then from the left.
+            float rightCost[kBinCount - 1];
+            glm::vec3 min(FLT_MAX), max(-FLT_MAX);
+            uint32_t rightCount = 0;
+
+            for (uint32_t b = kBinCount - 1; b > 0; b--) {
+                min = glm::min(min, bins[b].Min);
+                max = glm::max(max, bins[b].Max);
+                rightCount += bins[b].Count;
+                rightCost[b - 1] = rightCount * HalfArea(min, max);
+            }
+
+            min = glm::vec3(FLT_MAX);
+            max = glm::vec3(-FLT_MAX);
+            uint32_t leftCount = 0;
+
+            for (uint32_t b = 0; b < kBinCount - 1; b++) {
+                min = glm::min(min, bins[b].Min);
+                max = glm::max(max, bins[b].Max);
+                leftCount += bins[b].Count;
+
+                if (leftCount == 0 || leftCount == count)
+                    continue;
+
+                float cost = leftCount * HalfArea(min, max) + rightCost[b];
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestBin = b;
+                }
+            }
+        }
+
+        const float nodeArea = HalfArea(nodeMin, nodeMax);
+
+        if (bestAxis < 0) {
+            // Every centroid is in the same place, so only splitting by count is left.
+            if (count <= kMaxLeafSize)
+                return false;
+
+            mid = task.Begin + count / 2;
+        }
+        else {
+            // Splitting costs one extra box test compared to intersecting every triangle here.
+            if (nodeArea + bestCost >= count * nodeArea && count <= kMaxLeafSize)
+                return false;
+
+            const float extent = centroidMax[bestAxis] - centroidMin[bestAxis];
+            const float scale = kBinCount / extent;
+
+            BuildRef* split = std::partition(refs + task.Begin, refs + task.End, [&](const BuildRef& ref) {
+                return std::min(kBinCount - 1, static_cast<uint32_t>((ref.Centroid[bestAxis] - centroidMin[bestAxis]) * scale)) <= bestBin;
+            });
+
+            mid = static_cast<uint32_t>(split - refs);
+        }
+
+        uint32_t left = static_cast<uint32_t>(nodes.size());
+        nodes.resize(nodes.size() + 2);
+        nodes[task.Node].LeftOrFirst = left;
+        nodes[task.Node].Count = 0;
+
+        return true;
+    }
+
+    // Builds the subtree below nodes[root] depth-first.
+    void BuildSubtree(std::vector<GXBvhNode>& nodes, BuildTask root, BuildRef* refs) {
+        std::vector<BuildTask> stack(1, root);
+
+        while (!stack.empty()) {
+            BuildTask task = stack.back();
+            stack.pop_back();
+
+            uint32_t mid;
+            if (!SplitNode(nodes, task, refs, mid))
+                continue;
+
+            uint32_t left = nodes[task.Node].LeftOrFirst;
+            stack.push_back({ left + 1, mid, task.End, task.Depth + 1 });
+            stack.push_back({ left, task.Begin, mid, task.Depth + 1 });
+        }
+    }
+
+    // Returns the reciprocal of each component of a ray direction, with zeros going to the largest finite value of their
+    // sign instead of infinity. An infinite reciprocal would turn into NaN in IntersectBox when the ray starts on a slab
+    // plane, where NaN would fail every comparison and miss the box.
+    glm::vec3 GetInverseDirection(const glm::vec3& direction) {
+        glm::vec3 inverse;
+
+        for (int i = 0; i < 3; i++) {
+            inverse[i] = 1.0f / direction[i];
+            if (!std::isfinite(inverse[i]))
+                inverse[i] = std::copysign(FLT_MAX, direction[i]);
+        }
+
+        return inverse;
+    }
+
+    // Returns the distance along the ray at which it enters the box, or FLT_MAX if it misses it before maxDistance.
+    float IntersectBox(const GXBvhNode& node, const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance) {
+        glm::vec3 t0 = (node.Min - origin) * inverseDirection;
+        glm::vec3 t1 = (node.Max - origin) * inverseDirection;
+
+        glm::vec3 tmin = glm::min(t0, t1);
+        glm::vec3 tmax = glm::max(t0, t1);
+
+        float enter = std::max(std::max(tmin.x, tmin.y), std::max(tmin.z, 0.0f));
+        float exit = std::min(std::min(tmax.x, tmax.y), std::min(tmax.z, maxDistance));
+
+        return enter <= exit ? enter : FLT_MAX;
+    }
+
+    // Intersects a ray with a two-sided triangle (Moller and Trumbore). Returns whether it hits before maxDistance.
+    bool IntersectTriangle(const glm::vec3& origin, const glm::vec3& direction, const glm::vec3* triangle, float maxDistance,
+                           float& distance, glm::vec2& barycentrics) {
+        glm::vec3 edge1 = triangle[1] - triangle[0];
+        glm::vec3 edge2 = triangle[2] - triangle[0];
+
+        glm::vec3 p = glm::cross(direction, edge2);
+        float determinant = glm::dot(edge1, p);
+        if (std::fabs(determinant) < 1e-12f)
+            return false;
+
+        float inverseDeterminant = 1.0f / determinant;
+        glm::vec3 s = origin - triangle[0];
+
+        float u = glm::dot(s, p) * inverseDeterminant;
+        if (u < 0.0f || u > 1.0f)
+            return false;
+
+        glm::vec3 q = glm::cross(s, edge1);
+        float v = glm::dot(direction, q) * inverseDeterminant;
+        if (v < 0.0f || u + v > 1.0f)
+            return false;
+
+        float t = glm::dot(edge2, q) * inverseDeterminant;
+        if (t < 0.0f || t >= maxDistance)
+            return false;
+
+        distance = t;
+        barycentrics = glm::vec2(u, v);
+        return true;
+    }
+
+    // Returns the point on the triangle closest to p, and its barycentrics (Ericson, Real-Time Collision Detection 5.1.5).
+    glm::vec3 ClosestPointOnTriangle(const glm::vec3& p, const glm::vec3* triangle, glm::vec2& barycentrics) {
+        const glm::vec3& a = triangle[0];
+        const glm::vec3& b = triangle[1];
+        const glm::vec3& c = triangle[2];
+
+        glm::vec3 ab = b - a;
+        glm::vec3 ac = c - a;
+        glm::vec3 ap = p - a;
+
+        float d1 = glm::dot(ab, ap);
+        float d2 = glm::dot(ac, ap);
+        if (d1 <= 0.0f && d2 <= 0.0f) {
+            barycentrics = glm::vec2(0.0f, 0.0f);
+            return a;
+        }
+
+        glm::vec3 bp = p - b;
+        float d3 = glm::dot(ab, bp);
+        float d4 = glm::dot(ac, bp);
+        if (d3 >= 0.0f && d4 <= d3) {
+            barycentrics = glm::vec2(1.0f, 0.0f);
+            return b;
+        }
+
+        float vc = d1 * d4 - d3 * d2;
+        if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+            float v = d1 / (d1 - d3);
+            barycentrics = glm::vec2(v, 0.0f);
+            return a + ab * v;
+        }
+
+        glm::vec3 cp = p - c;
+        float d5 = glm::dot(ab, cp);
+        float d6 = glm::dot(ac, cp);
+        if (d6 >= 0.0f && d5 <= d6) {
+            barycentrics = glm::vec2(0.0f, 1.0f);
+            return c;
+        }
+
+        float vb = d5 * d2 - d1 * d6;
+        if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+            float w = d2 / (d2 - d6);
+            barycentrics = glm::vec2(0.0f, w);
+            return a + ac * w;
+        }
+
+        float va = d3 * d6 - d5 * d4;
+        if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) {
+            float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+            barycentrics = glm::vec2(1.0f - w, w);
+            return b + (c - b) * w;
+        }
+
+        float denominator = 1.0f / (va + vb + vc);
+        float v = vb * denominator;
+        float w = vc * denominator;
+        barycentrics = glm::vec2(v, w);
+        return a + ab * v + ac * w;
+    }
+}
+
+void GXBvh::Build(const GXGeometry& geometry, uint32_t threadCount) {
+    const std::vector<uint32_t>& Indices = geometry.GetModelIndices();
+    const std::vector<ModernVertex>& Vertices = geometry.GetModelVertices();
+    const size_t TriangleCount = Indices.size() / 3;
+
+    mNodes.clear();
+    mTriangles.clear();
+    mTriangleShapes.clear();
+    mTriangleVertices.clear();
+
+    if (TriangleCount == 0)
+        return;
+
+    std::vector<uint32_t> ShapeOfTriangle(TriangleCount, 0);
+    const std::vector<std::shared_ptr<GXShape>>& Shapes = geometry.GetShapes();
+    for (size_t s = 0; s < Shapes.size(); s++) {
+        uint32_t Offset, Count;
+        Shapes[s]->GetVertexOffsetAndCount(Offset, Count);
+
+        std::fill(ShapeOfTriangle.begin() + Offset / 3, ShapeOfTriangle.begin() + (Offset + Count) / 3, static_cast<uint32_t>(s));
+    }
+
+    std::vector<BuildRef> Refs(TriangleCount);
+    ParallelForChunks(TriangleCount, threadCount, [&](size_t First, size_t Last) {
+        for (size_t t = First; t < Last; t++) {
+            glm::vec3 P0(Vertices.at(Indices[t * 3]).Position);
+            glm::vec3 P1(Vertices.at(Indices[t * 3 + 1]).Position);
+            glm::vec3 P2(Vertices.at(Indices[t * 3 + 2]).Position);
+
+            Refs[t].Min = glm::min(glm::min(P0, P1), P2);
+            Refs[t].Max = glm::max(glm::max(P0, P1), P2);
+            Refs[t].Centroid = (Refs[t].Min + Refs[t].Max) * 0.5f;
+            Refs[t].Triangle = static_cast<uint32_t>(t);
+        }
+    });
+
+    // Split the top of the tree breadth-first into enough subtrees to keep the threads busy. The same split is
+    // made on one thread, so the nodes come out identical for any thread count.
+    mNodes.resize(1);
+    std::vector<BuildTask> Frontier(1, BuildTask{ 0, 0, static_cast<uint32_t>(TriangleCount), 0 });
+
+    while (!Frontier.empty() && Frontier.size() < kFrontierSize) {
+        std::vector<BuildTask> Next;
+
+        for (const BuildTask& Task : Frontier) {
+            uint32_t Mid;
+            if (!SplitNode(mNodes, Task, Refs.data(), Mid))
+                continue;
+
+            uint32_t Left = mNodes[Task.Node].LeftOrFirst;
+            Next.push_back({ Left, Task.Begin, Mid, Task.Depth + 1 });
+            Next.push_back({ Left + 1, Mid, Task.End, Task.Depth + 1 });
+        }
+
+        Frontier = std::move(Next);
+    }
+
+    // Build each remaining subtree on its own, rooted at node 0 of a local list, then stitch them into the tree.
+    std::vector<std::vector<GXBvhNode>> Subtrees(Frontier.size());
+    ParallelFor(Frontier.size(), threadCount, [&](size_t i) {
+        Subtrees[i].resize(1);
+        BuildSubtree(Subtrees[i], BuildTask{ 0, Frontier[i].Begin, Frontier[i].End, Frontier[i].Depth }, Refs.data());
+    });
+
+    for (size_t i = 0; i < Frontier.size(); i++) {
+        const std::vector<GXBvhNode>& Subtree = Subtrees[i];
+        const uint32_t Base = static_cast<uint32_t>(mNodes.size());
+
+        auto Rebase = [Base](GXBvhNode node) {
+            if (!node.IsLeaf())
+                node.LeftOrFirst = Base + node.LeftOrFirst - 1;
+            return node;
+        };
+
+        mNodes[Frontier[i].Node] = Rebase(Subtree[0]);
+        for (size_t n = 1; n < Subtree.size(); n++) {
+            mNodes.push_back(Rebase(Subtree[n]));
+        }
+    }
+
+    mTriangles.resize(TriangleCount);
+    mTriangleShapes.resize(TriangleCount);
+    for (size_t i = 0; i < TriangleCount; i++) {
+        mTriangles[i] = Refs[i].Triangle;
+        mTriangleShapes[i] = ShapeOfTriangle[Refs[i].Triangle];
+    }
+
+    GatherTriangleVertices(geometry, threadCount);
+}
+
+void GXBvh::Refit(const GXGeometry& geometry, uint32_t threadCount) {
+    if (geometry.GetModelIndices().size() / 3 != mTriangles.size())
+        throw std::invalid_argument("The geometry's triangles have changed since the BVH was built!");
+
+    if (mNodes.empty())
+        return;
+
+    GatherTriangleVertices(geometry, threadCount);
+    RefitNodes(threadCount);
+}
+
+void GXBvh::GatherTriangleVertices(const GXGeometry& geometry, uint32_t threadCount) {
+    const std::vector<uint32_t>& Indices = geometry.GetModelIndices();
+    const std::vector<ModernVertex>& Vertices = geometry.GetModelVertices();
+
+    mTriangleVertices.resize(mTriangles.size() * 3);
+
+    ParallelForChunks(mTriangles.size(), threadCount, [&](size_t First, size_t Last) {
+        for (size_t i = First; i < Last; i++) {
+            for (int c = 0; c < 3; c++) {
+                mTriangleVertices[i * 3 + c] = glm::vec3(Vertices.at(Indices[mTriangles[i] * 3 + c]).Position);
+            }
+        }
+    });
+}
+
+void GXBvh::RefitNodes(uint32_t threadCount) {
+    ParallelForChunks(mNodes.size(), threadCount, [&](size_t First, size_t Last) {
+        for (size_t n = First; n < Last; n++) {
+            GXBvhNode& Node = mNodes[n];
+            if (!Node.IsLeaf())
+                continue;
+
+            Node.Min = glm::vec3(FLT_MAX);
+            Node.Max = glm::vec3(-FLT_MAX);
+            for (size_t v = Node.LeftOrFirst * 3; v < (Node.LeftOrFirst + Node.Count) * 3; v++) {
+                Node.Min = glm::min(Node.Min, mTriangleVertices[v]);
+                Node.Max = glm::max(Node.Max, mTriangleVertices[v]);
+            }
+        }
+    });
+
+    // Children always come after their parent, so walking backwards refits every child before its parent.
+    for (size_t n = mNodes.size(); n-- > 0;) {
+        GXBvhNode& Node = mNodes[n];
+        if (Node.IsLeaf())
+            continue;
+
+        const GXBvhNode& Left = mNodes[Node.LeftOrFirst];
+        const GXBvhNode& Right = mNodes[Node.LeftOrFirst + 1];
+        Node.Min = glm::min(Left.Min, Right.Min);
+        Node.Max = glm::max(Left.Max, Right.Max);
+    }
+}
+
+bool GXBvh::Raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, GXBvhHit& hit) const {
+    if (mNodes.empty())
+        return false;
+
+    const glm::vec3 InverseDirection = GetInverseDirection(direction);
+    float Closest = maxDistance;
+    bool bHit = false;
+
+    if (IntersectBox(mNodes[0], origin, InverseDirection, Closest) == FLT_MAX)
+        return false;
+
+    uint32_t Stack[kMaxDepth + 4];
+    uint32_t StackSize = 0;
+    Stack[StackSize++] = 0;
+
+    while (StackSize != 0) {
+        const GXBvhNode& Node = mNodes[Stack[--StackSize]];
+
+        if (Node.IsLeaf()) {
+            for (uint32_t i = Node.LeftOrFirst; i < Node.LeftOrFirst + Node.Count; i++) {
+                float Distance;
+                glm::vec2 Barycentrics;
+
+                if (IntersectTriangle(origin, direction, &mTriangleVertices[i * 3], Closest, Distance, Barycentrics)) {
+                    Closest = Distance;
+                    bHit = true;
+
+                    hit.ShapeIndex = mTriangleShapes[i];
+                    hit.Triangle = mTriangles[i];
+                    hit.Distance = Distance;
+                    hit.Barycentrics = Barycentrics;
+                }
+            }
+
+            continue;
+        }
+
+        // Visit the nearer child first, so that its hits can cull the farther one.
+        uint32_t Near = Node.LeftOrFirst;
+        uint32_t Far = Node.LeftOrFirst + 1;
+        float NearDistance = IntersectBox(mNodes[Near], origin, InverseDirection, Closest);
+        float FarDistance = IntersectBox(mNodes[Far], origin, InverseDirection, Closest);
+
+        if (FarDistance < NearDistance) {
+            std::swap(Near, Far);
+            std::swap(NearDistance, FarDistance);
+        }
+
+        if (FarDistance != FLT_MAX)
+            Stack[StackSize++] = Far;
+        if (NearDistance != FLT_MAX)
+            Stack[StackSize++] = Near;
+    }
+
+    return bHit;
+}
+
+bool GXBvh::SegmentCast(const glm::vec3& start, const glm::vec3& end, GXBvhHit& hit) const {
+    glm::vec3 Direction = end - start;
+    float Length = glm::length(Direction);
+
+    if (Length == 0.0f)
+        return false;
+
+    return Raycast(start, Direction / Length, Length, hit);
+}
+
+size_t GXBvh::SphereQuery(const glm::vec3& center, float radius, std::vector<GXBvhHit>& hits) const {
+    hits.clear();
+
+    if (mNodes.empty() || radius < 0.0f)
+        return 0;
+
+    const float RadiusSquared = radius * radius;
+
+    auto TouchesBox = [&](const GXBvhNode& node) {
+        glm::vec3 d = center - glm::clamp(center, node.Min, node.Max);
+        return glm::dot(d, d) <= RadiusSquared;
+    };
+
+    uint32_t Stack[kMaxDepth + 4];
+    uint32_t StackSize = 0;
+    if (TouchesBox(mNodes[0]))
+        Stack[StackSize++] = 0;
+
+    while (StackSize != 0) {
+        const GXBvhNode& Node = mNodes[Stack[--StackSize]];
+
+        if (Node.IsLeaf()) {
+            for (uint32_t i = Node.LeftOrFirst; i < Node.LeftOrFirst + Node.Count; i++) {
+                glm::vec2 Barycentrics;
+                glm::vec3 d = center - ClosestPointOnTriangle(center, &mTriangleVertices[i * 3], Barycentrics);
+                float DistanceSquared = glm::dot(d, d);
+
+                if (DistanceSquared > RadiusSquared)
+                    continue;
+
+                GXBvhHit Hit;
+                Hit.ShapeIndex = mTriangleShapes[i];
+                Hit.Triangle = mTriangles[i];
+                Hit.Distance = std::sqrt(DistanceSquared);
+                Hit.Barycentrics = Barycentrics;
+                hits.push_back(Hit);
+            }
+
+            continue;
+        }
+
+        for (uint32_t Child = Node.LeftOrFirst; Child < Node.LeftOrFirst + 2; Child++) {
+            if (TouchesBox(mNodes[Child]))
+                Stack[StackSize++] = Child;
+        }
+    }
+
+    return hits.size();
+}
@@ -0,0 +1,230 @@
+#include "geometry/GXDisplayList.hpp"
+#include "geometry/GXGeometryArena.hpp"
+#include "util/GXEndian.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+// Display list opcodes other than primitives.
+namespace {
+    const uint8_t GX_NOP = 0x00;
+    const uint8_t GX_LOAD_CP_REG = 0x08;
+    const uint8_t GX_LOAD_XF_REG = 0x10;
+    const uint8_t GX_LOAD_INDX_A = 0x20;
+    const uint8_t GX_LOAD_INDX_D = 0x38;
+    const uint8_t GX_CALL_DL = 0x40;
+    const uint8_t GX_INVALIDATE_VTX_CACHE = 0x48;
+    const uint8_t GX_LOAD_BP_REG = 0x61;
+
+    // Primitive opcodes keep the VAT index in the low 3 bits.
+    const uint8_t GX_PRIMITIVE_MASK = 0xF8;
+    const uint8_t GX_VAT_MASK = 0x07;
+}
+
+// Returns whether the given opcode, with its VAT index masked off, is one of the GX primitive types.
+static bool IsPrimitiveType(uint8_t type) {
+    switch ((EGXPrimitiveType)type) {
+        case EGXPrimitiveType::Quads:
+        case EGXPrimitiveType::Triangles:
+        case EGXPrimitiveType::TriangleStrips:
+        case EGXPrimitiveType::TriangleFan:
+        case EGXPrimitiveType::Lines:
+        case EGXPrimitiveType::LineStrips:
+        case EGXPrimitiveType::Points:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Returns whether the given attribute is a matrix index, which the hardware always treats as direct 8-bit data.
+static bool IsMatrixIndexAttribute(EGXAttribute attribute) {
+    return (uint32_t)attribute <= (uint32_t)EGXAttribute::Tex7MatrixIdx;
+}
+
+GXDisplayListDecoder::GXDisplayListDecoder(const std::vector<GXVertexDescriptor>& descriptors, const std::vector<GXVertexAttributeFormat>& formats) : mVertexStride(0) {
+    std::vector<GXVertexDescriptor> present;
+    for (const GXVertexDescriptor& descriptor : descriptors) {
+        if (descriptor.IndexType != EGXAttributeIndexType::None && (uint32_t)descriptor.Attribute < (uint32_t)EGXAttribute::Attribute_Max)
+            present.push_back(descriptor);
+    }
+
+    // The hardware always sends attributes in order of their ID, regardless of the order they were described in.
+    std::sort(present.begin(), present.end(), [](const GXVertexDescriptor& a, const GXVertexDescriptor& b) {
+        return (uint32_t)a.Attribute < (uint32_t)b.Attribute;
+    });
+
+    for (const GXVertexDescriptor& descriptor : present) {
+        AttributeReader reader = { descriptor.Attribute, descriptor.IndexType, mVertexStride, 0 };
+        uint32_t size = 0;
+
+        // NBT3 normals store separate indices for the normal, binormal and tangent.
+        uint32_t indexCount = 1;
+        for (const GXVertexAttributeFormat& format : formats) {
+            if (format.Attribute == descriptor.Attribute && format.Attribute == EGXAttribute::Normal && format.ComponentCount == EGXComponentCount::Normal_NBT3)
+                indexCount = 3;
+        }
+
+        switch (descriptor.IndexType) {
+            case EGXAttributeIndexType::Direct:
+                if (!IsMatrixIndexAttribute(descriptor.Attribute))
+                    throw std::invalid_argument("Direct vertex data is only supported for matrix index attributes!");
+
+                size = 1;
+                break;
+            case EGXAttributeIndexType::Index8:
+                size = 1 * indexCount;
+                break;
+            case EGXAttributeIndexType::Index16:
+                size = 2 * indexCount;
+                break;
+            default:
+                break;
+        }
+
+        mReaders.push_back(reader);
+        mVertexAttributeTable.push_back(descriptor.Attribute);
+        mVertexStride += size;
+    }
+
+    mFormat = GXPackedVertexFormat(mVertexAttributeTable);
+    for (AttributeReader& reader : mReaders) {
+        reader.Slot = mFormat.GetSlot(reader.Attribute);
+    }
+}
+
+template<typename PrimitiveFunc, typename VertexFunc>
+void GXDisplayListDecoder::DecodeImpl(const uint8_t* data, size_t size, const GXAttributeData* attributes, PrimitiveFunc onPrimitive, VertexFunc onVertex) const {
+    // The number of elements in the array that each reader's indices refer to. Direct data isn't an index.
+    std::vector<size_t> arraySizes(mReaders.size(), SIZE_MAX);
+    if (attributes != nullptr) {
+        for (size_t r = 0; r < mReaders.size(); r++) {
+            if (mReaders[r].IndexType != EGXAttributeIndexType::Direct)
+                arraySizes[r] = attributes->GetArraySize(mReaders[r].Attribute);
+        }
+    }
+
+    size_t offset = 0;
+
+    while (offset < size) {
+        uint8_t opcode = data[offset++];
+
+        uint8_t primitiveType = opcode & GX_PRIMITIVE_MASK;
+        if (IsPrimitiveType(primitiveType)) {
+            if (offset + 2 > size)
+                throw std::out_of_range("Display list ended in the middle of a primitive header!");
+
+            uint16_t vertexCount = ReadBE16(data + offset);
+            offset += 2;
+
+            size_t byteCount = static_cast<size_t>(vertexCount) * mVertexStride;
+            if (offset + byteCount > size)
+                throw std::out_of_range("Display list ended in the middle of a primitive!");
+
+            onPrimitive(static_cast<EGXPrimitiveType>(primitiveType), vertexCount);
+
+            // Slots that no reader writes to keep their unset value.
+            uint16_t key[(uint32_t)EGXAttribute::Attribute_Max + 3];
+            mFormat.Pack(GXVertex(), key);
+
+            const uint8_t* vertexData = data + offset;
+            for (uint16_t i = 0; i < vertexCount; i++, vertexData += mVertexStride) {
+                for (size_t r = 0; r < mReaders.size(); r++) {
+                    const AttributeReader& reader = mReaders[r];
+                    const uint8_t* src = vertexData + reader.Offset;
+                    key[reader.Slot] = reader.IndexType == EGXAttributeIndexType::Index16 ? ReadBE16(src) : *src;
+
+                    if (key[reader.Slot] >= arraySizes[r])
+                        throw std::out_of_range("Display list vertex refers past the end of its attribute array!");
+                }
+
+                onVertex(static_cast<const uint16_t*>(key));
+            }
+
+            offset += byteCount;
+            continue;
+        }
+
+        // Skip over any commands that don't draw anything.
+        size_t commandSize = 0;
+        switch (opcode) {
+            case GX_NOP:
+            case GX_INVALIDATE_VTX_CACHE:
+                break;
+            case GX_LOAD_CP_REG:
+                commandSize = 5;
+                break;
+            case GX_LOAD_XF_REG:
+                if (offset + 2 > size)
+                    throw std::out_of_range("Display list ended in the middle of an XF load!");
+
+                commandSize = 4 + (static_cast<size_t>(ReadBE16(data + offset)) + 1) * 4;
+                break;
+            case GX_CALL_DL:
+                commandSize = 8;
+                break;
+            case GX_LOAD_BP_REG:
+                commandSize = 4;
+                break;
+            default:
+                if (opcode >= GX_LOAD_INDX_A && opcode <= GX_LOAD_INDX_D && (opcode & GX_VAT_MASK) == 0) {
+                    commandSize = 4;
+                    break;
+                }
+
+                throw std::runtime_error("Display list contains an unknown command!");
+        }
+
+        offset += commandSize;
+    }
+}
+
+void GXDisplayListDecoder::Decode(const uint8_t* data, size_t size, std::vector<GXDisplayListPrimitive>& primitives, const GXAttributeData* attributes) const {
+    DecodeImpl(data, size, attributes,
+        [&primitives](EGXPrimitiveType type, uint16_t vertexCount) {
+            primitives.emplace_back();
+            primitives.back().Type = type;
+            primitives.back().Vertices.reserve(vertexCount);
+        },
+        [this, &primitives](const uint16_t* key) {
+            primitives.back().Vertices.push_back(mFormat.Unpack(key));
+        });
+}
+
+// Returns a new primitive of the given type, from the arena if there is one.
+static GXPrimitive* CreatePrimitive(GXGeometryArena* arena, EGXPrimitiveType type) {
+    return arena != nullptr ? arena->CreatePrimitive(type) : new GXPrimitive(type);
+}
+
+void GXDisplayListDecoder::DecodeShape(const uint8_t* data, size_t size, GXVertexCache& cache, GXShape& shape, GXGeometryArena* arena) const {
+    shape.GetAttributeTable() = mVertexAttributeTable;
+    cache.SetAttributeTable(mVertexAttributeTable);
+
+    std::vector<GXPrimitive*>& primitives = shape.GetPrimitives();
+
+    DecodeImpl(data, size, &cache.GetAttributeData(),
+        [&primitives, arena](EGXPrimitiveType type, uint16_t vertexCount) {
+            primitives.push_back(CreatePrimitive(arena, type));
+            primitives.back()->GetVertices().reserve(vertexCount);
+        },
+        [&primitives, &cache](const uint16_t* key) {
+            primitives.back()->GetVertices().push_back(cache.GetVertices()[cache.GetIndex(key)]);
+        });
+}
+
+void GXDisplayListDecoder::DecodeShape(const uint8_t* data, size_t size, GXShape& shape, GXGeometryArena* arena, const GXAttributeData* attributes) const {
+    shape.GetAttributeTable() = mVertexAttributeTable;
+
+    std::vector<GXPrimitive*>& primitives = shape.GetPrimitives();
+
+    const uint32_t stride = mFormat.GetStride();
+
+    DecodeImpl(data, size, attributes,
+        [&primitives, stride, arena](EGXPrimitiveType type, uint16_t vertexCount) {
+            primitives.push_back(CreatePrimitive(arena, type));
+            primitives.back()->ReservePacked(vertexCount, stride);
+        },
+        [&primitives, stride](const uint16_t* key) {
+            primitives.back()->AddPackedVertex(key, stride);
+        });
+}
@@ -0,0 +1,32 @@
+#include "geometry/GXGeometryArena.hpp"
+
+std::shared_ptr<GXGeometryArena> GXGeometryArena::Create() {
+    return std::shared_ptr<GXGeometryArena>(new GXGeometryArena());
+}
+
+GXGeometryArena::~GXGeometryArena() {
+    // Shapes look at their primitives while being destroyed, so they have to go first.
+    mShapes.Clear();
+    mPrimitives.Clear();
+}
+
+std::shared_ptr<GXShape> GXGeometryArena::CreateShape() {
+    GXShape* shape = mShapes.Create();
+
+    // Share the arena's control block, so the shape needs no allocation of its own and keeps the arena alive.
+    return std::shared_ptr<GXShape>(shared_from_this(), shape);
+}
+
+GXPrimitive* GXGeometryArena::CreatePrimitive(EGXPrimitiveType type) {
+    GXPrimitive* primitive = mPrimitives.Create(type);
+    primitive->mbArenaOwned = true;
+
+    return primitive;
+}
+
+void GXGeometryArena::Reserve(size_t shapeCount, size_t primitiveCount) {
+    if (shapeCount != 0)
+        mShapes.Reserve(shapeCount);
+    if (primitiveCount != 0)
+        mPrimitives.Reserve(primitiveCount);
+}
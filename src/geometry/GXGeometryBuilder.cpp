@@ -0,0 +1,167 @@
+#include "geometry/GXGeometryBuilder.hpp"
+
+#include <stdexcept>
+
+GXGeometryBuilder::GXGeometryBuilder(GXGeometry& geometry, bool weldVertices) : mGeometry(geometry), mbWeldVertices(weldVertices),
+    mCache(geometry.GetAttributeData()) {
+}
+
+GXGeometryBuilder::~GXGeometryBuilder() {
+    EndShape();
+}
+
+void GXGeometryBuilder::CheckShape() const {
+    if (mShape == nullptr)
+        throw std::runtime_error("No shape is being built; call BeginShape first!");
+}
+
+GXShape& GXGeometryBuilder::BeginShape(const std::vector<EGXAttribute>& attributeTable, std::shared_ptr<GXShape> shape) {
+    EndShape();
+
+    mShape = shape != nullptr ? std::move(shape) : std::make_shared<GXShape>();
+    mShape->GetAttributeTable() = attributeTable;
+
+    mShape->mFirstVertexOffset = static_cast<uint32_t>(mGeometry.mModelIndices.size());
+    mShape->mFirstLineIndex = static_cast<uint32_t>(mGeometry.mModelLineIndices.size());
+    mShape->mFirstPointIndex = static_cast<uint32_t>(mGeometry.mModelPointIndices.size());
+    mShape->mFirstModelVertex = static_cast<uint32_t>(mGeometry.mModelVertices.size());
+    UpdateShapeRanges();
+
+    mCache.Clear();
+    mCache.SetAttributeTable(attributeTable);
+    mTupleIds.clear();
+
+    mGeometry.mShapes.push_back(mShape);
+    return *mShape;
+}
+
+void GXGeometryBuilder::EndShape() {
+    if (mShape == nullptr)
+        return;
+
+    UpdateShapeRanges();
+
+    mShape.reset();
+    mWeldMap.clear();
+    mCache.Clear();
+    mTupleIds.clear();
+}
+
+void GXGeometryBuilder::UpdateShapeRanges() {
+    GXShape& shape = *mShape;
+
+    shape.mVertexCount = static_cast<uint32_t>(mGeometry.mModelIndices.size()) - shape.mFirstVertexOffset;
+    shape.mLineIndexCount = static_cast<uint32_t>(mGeometry.mModelLineIndices.size()) - shape.mFirstLineIndex;
+    shape.mPointIndexCount = static_cast<uint32_t>(mGeometry.mModelPointIndices.size()) - shape.mFirstPointIndex;
+    shape.mModelVertexCount = static_cast<uint32_t>(mGeometry.mModelVertices.size()) - shape.mFirstModelVertex;
+}
+
+uint32_t GXGeometryBuilder::AddVertex(const ModernVertex& vertex) {
+    CheckShape();
+
+    std::vector<ModernVertex>& vertices = mGeometry.mModelVertices;
+
+    if (mbWeldVertices) {
+        auto result = mWeldMap.emplace(vertex, static_cast<uint32_t>(vertices.size()));
+        if (!result.second)
+            return result.first->second;
+    }
+
+    vertices.push_back(vertex);
+    mShape->mModelVertexCount++;
+
+    return static_cast<uint32_t>(vertices.size() - 1);
+}
+
+uint32_t GXGeometryBuilder::AddVertex(const GXVertex& vertex) {
+    CheckShape();
+
+    // Each unique tuple is converted once, and keeps the model vertex it was first added as.
+    uint32_t tuple = mCache.GetIndex(vertex);
+    if (tuple == mTupleIds.size())
+        mTupleIds.push_back(AddVertex(mCache.GetVertices()[tuple]));
+
+    return mTupleIds[tuple];
+}
+
+uint32_t GXGeometryBuilder::AppendPrimitive(EGXPrimitiveType type) {
+    mIndices.Clear();
+    GXPrimitive::TriangulateIndices(type, mVertexIds.data(), mVertexIds.size(), mIndices);
+
+    std::vector<uint32_t>* destination = &mGeometry.mModelIndices;
+    const std::vector<uint32_t>* source = &mIndices.Triangles;
+
+    if (type == EGXPrimitiveType::Lines || type == EGXPrimitiveType::LineStrips) {
+        destination = &mGeometry.mModelLineIndices;
+        source = &mIndices.Lines;
+    }
+    else if (type == EGXPrimitiveType::Points) {
+        destination = &mGeometry.mModelPointIndices;
+        source = &mIndices.Points;
+    }
+
+    uint32_t firstIndex = static_cast<uint32_t>(destination->size());
+    destination->insert(destination->end(), source->begin(), source->end());
+
+    UpdateShapeRanges();
+    return firstIndex;
+}
+
+uint32_t GXGeometryBuilder::AddPrimitive(EGXPrimitiveType type, const ModernVertex* vertices, size_t count) {
+    CheckShape();
+
+    mVertexIds.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        mVertexIds[i] = AddVertex(vertices[i]);
+    }
+
+    // Without welding every vertex is stored, but repeated ones still need the same id to drop degenerate triangles.
+    if (!mbWeldVertices && count != 0)
+        GXPrimitive::GetUnweldedVertexIds(vertices, count, mVertexIds[0], mVertexIds.data());
+
+    return AppendPrimitive(type);
+}
+
+uint32_t GXGeometryBuilder::AddPrimitive(EGXPrimitiveType type, const GXVertex* vertices, size_t count) {
+    CheckShape();
+
+    mVertexIds.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        mVertexIds[i] = AddVertex(vertices[i]);
+    }
+
+    return AppendPrimitive(type);
+}
+
+uint32_t GXGeometryBuilder::AddPrimitive(EGXPrimitiveType type, const uint32_t* vertexIndices, size_t count) {
+    CheckShape();
+
+    for (size_t i = 0; i < count; i++) {
+        if (vertexIndices[i] < mShape->mFirstModelVertex || vertexIndices[i] >= mGeometry.mModelVertices.size())
+            throw std::invalid_argument("Primitive uses a vertex that isn't part of the shape being built!");
+    }
+
+    mVertexIds.assign(vertexIndices, vertexIndices + count);
+    return AppendPrimitive(type);
+}
+
+uint32_t GXGeometryBuilder::AddPrimitive(const GXPrimitive& primitive) {
+    CheckShape();
+
+    if (!primitive.IsIndexed())
+        return AddPrimitive(primitive.GetType(), primitive.GetVertices().data(), primitive.GetVertices().size());
+
+    if (primitive.GetPackedStride() != mCache.GetFormat().GetStride())
+        throw std::invalid_argument("Primitive in index form was packed with a different format than its shape's attribute table!");
+
+    mVertexIds.resize(primitive.GetVertexCount());
+    for (size_t i = 0; i < mVertexIds.size(); i++) {
+        uint32_t tuple = mCache.GetIndex(primitive.GetPackedVertex(i));
+        if (tuple == mTupleIds.size())
+            mTupleIds.push_back(AddVertex(mCache.GetVertices()[tuple]));
+
+        mVertexIds[i] = mTupleIds[tuple];
+    }
+
+    return AppendPrimitive(primitive.GetType());
+}
@@ -1,130 +1,287 @@
 #include "geometry/GXGeometryData.hpp"
+#include "util/GXParallel.hpp"
+#include "glm/common.hpp"
 
 #include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
 #include <utility>
 
 void GXPrimitive::TriangluatePrimitive() {
-    switch (mType) {
+    if (mType == EGXPrimitiveType::Lines || mType == EGXPrimitiveType::LineStrips || mType == EGXPrimitiveType::Points)
+        return;
+
+    // Give identical vertices the same id, so that degenerate triangles can be recognized by their ids.
+    std::vector<uint32_t> VertexIds;
+    VertexIds.reserve(GetVertexCount());
+
+    if (IsIndexed()) {
+        GXPackedVertexTable Ids(mPackedStride);
+
+        for (size_t i = 0; i < GetVertexCount(); i++) {
+            bool inserted;
+            VertexIds.push_back(Ids.Insert(GetPackedVertex(i), inserted));
+        }
+    }
+    else {
+        std::unordered_map<ModernVertex, uint32_t, ModernVertexHash, ModernVertexBitwiseEqual> Ids;
+
+        for (size_t i = 0; i < mVertices.size(); i++) {
+            VertexIds.push_back(Ids.emplace(mVertices[i], static_cast<uint32_t>(i)).first->second);
+        }
+    }
+
+    GXPrimitiveIndices Indices;
+    TriangulateIndices(mType, VertexIds.data(), VertexIds.size(), Indices);
+
+    if (IsIndexed()) {
+        // Ids are handed out in order of first use, so map them back to the first vertex that used each one.
+        std::vector<uint32_t> FirstUse;
+        for (size_t i = 0; i < VertexIds.size(); i++) {
+            if (VertexIds[i] == FirstUse.size())
+                FirstUse.push_back(static_cast<uint32_t>(i));
+        }
+
+        std::vector<uint16_t> Triangles;
+        Triangles.reserve(Indices.Triangles.size() * mPackedStride);
+
+        for (uint32_t index : Indices.Triangles) {
+            const uint16_t* key = GetPackedVertex(FirstUse[index]);
+            Triangles.insert(Triangles.end(), key, key + mPackedStride);
+        }
+
+        mPackedVertices = std::move(Triangles);
+    }
+    else {
+        std::vector<ModernVertex> Triangles;
+        Triangles.reserve(Indices.Triangles.size());
+
+        for (uint32_t index : Indices.Triangles) {
+            Triangles.push_back(mVertices[index]);
+        }
+
+        mVertices = std::move(Triangles);
+    }
+
+    mType = EGXPrimitiveType::Triangles;
+}
+
+void GXPrimitive::AddIndexedVertex(const GXPackedVertexFormat& format, const GXVertex& vertex) {
+    uint16_t key[(uint32_t)EGXAttribute::Attribute_Max + 3];
+    format.Pack(vertex, key);
+
+    AddPackedVertex(key, format.GetStride());
+}
+
+void GXPrimitive::AddPackedVertex(const uint16_t* key, uint32_t stride) {
+    if (mPackedStride != 0 && mPackedStride != stride)
+        throw std::invalid_argument("Every vertex in index form in a primitive must use the same packed format!");
+
+    mPackedStride = stride;
+    mPackedVertices.insert(mPackedVertices.end(), key, key + stride);
+}
+
+// Appends the given triangle to the list, unless two or more of its vertices are the same.
+static inline void AddTriangle(std::vector<uint32_t>& triangles, uint32_t v0, uint32_t v1, uint32_t v2) {
+    if (v0 == v1 || v0 == v2 || v1 == v2)
+        return;
+
+    triangles.push_back(v0);
+    triangles.push_back(v1);
+    triangles.push_back(v2);
+}
+
+// Appends the given line to the list, unless both of its vertices are the same.
+static inline void AddLine(std::vector<uint32_t>& lines, uint32_t v0, uint32_t v1) {
+    if (v0 == v1)
+        return;
+
+    lines.push_back(v0);
+    lines.push_back(v1);
+}
+
+void GXPrimitive::TriangulateIndices(EGXPrimitiveType type, const uint32_t* vertexIds, size_t count, GXPrimitiveIndices& output) {
+    const uint32_t* v = vertexIds;
+
+    switch (type) {
+        case EGXPrimitiveType::Triangles:
+            output.Triangles.reserve(output.Triangles.size() + count);
+            for (size_t i = 2; i < count; i += 3) {
+                AddTriangle(output.Triangles, v[i - 2], v[i - 1], v[i]);
+            }
+            break;
+        case EGXPrimitiveType::Quads:
+            output.Triangles.reserve(output.Triangles.size() + count / 4 * 6);
+            for (size_t i = 3; i < count; i += 4) {
+                AddTriangle(output.Triangles, v[i - 3], v[i - 2], v[i - 1]);
+                AddTriangle(output.Triangles, v[i - 3], v[i - 1], v[i]);
+            }
+            break;
         case EGXPrimitiveType::TriangleStrips:
-            TriangulateTriangleStrip();
+            output.Triangles.reserve(output.Triangles.size() + (count > 2 ? (count - 2) * 3 : 0));
+            for (size_t i = 2; i < count; i++) {
+                // Every other triangle in a strip has its winding flipped.
+                if (i % 2 != 0)
+                    AddTriangle(output.Triangles, v[i - 2], v[i], v[i - 1]);
+                else
+                    AddTriangle(output.Triangles, v[i - 2], v[i - 1], v[i]);
+            }
             break;
         case EGXPrimitiveType::TriangleFan:
-            TriangulateTriangleFan();
+            output.Triangles.reserve(output.Triangles.size() + (count > 2 ? (count - 2) * 3 : 0));
+            for (size_t i = 1; i + 1 < count; i++) {
+                AddTriangle(output.Triangles, v[i], v[i + 1], v[0]);
+            }
+            break;
+        case EGXPrimitiveType::Lines:
+            for (size_t i = 1; i < count; i += 2) {
+                AddLine(output.Lines, v[i - 1], v[i]);
+            }
+            break;
+        case EGXPrimitiveType::LineStrips:
+            for (size_t i = 1; i < count; i++) {
+                AddLine(output.Lines, v[i - 1], v[i]);
+            }
+            break;
+        case EGXPrimitiveType::Points:
+            output.Points.insert(output.Points.end(), v, v + count);
             break;
-        case EGXPrimitiveType::Triangles:
         default:
             break;
     }
 }
 
-void GXPrimitive::TriangulateTriangleStrip() {
-    std::vector<ModernVertex> Triangles;
+void GXPrimitive::GetUnweldedVertexIds(const ModernVertex* vertices, size_t count, uint32_t firstId, uint32_t* vertexIds) {
+    for (size_t i = 0; i < count; i++) {
+        vertexIds[i] = firstId + static_cast<uint32_t>(i);
 
-    for (size_t i = 2; i < mVertices.size(); i++) {
-        bool isIndexOdd = i % 2 != 0;
+        // Triangles and lines only join vertices up to three apart, as in quads, or vertex 0 of a fan.
+        // Matches are taken from the nearest vertex first, and an earlier match already carries the id of
+        // its own earliest match, so equal vertices that can meet always end up with the same id.
+        bool bMatched = false;
+        for (size_t d = 1; d <= 3 && d <= i && !bMatched; d++) {
+            if (vertices[i] == vertices[i - d]) {
+                vertexIds[i] = vertexIds[i - d];
+                bMatched = true;
+            }
+        }
 
-        ModernVertex const& v0 = mVertices[i - 2];
-        ModernVertex const& v1 = isIndexOdd ? mVertices[i] : mVertices[i - 1];
-        ModernVertex const& v2 = isIndexOdd ? mVertices[i - 1] : mVertices[i];
+        if (!bMatched && i > 3 && vertices[i] == vertices[0])
+            vertexIds[i] = vertexIds[0];
+    }
+}
 
-        if (v0 == v1 || v0 == v2 || v1 == v2)
-            continue;
+void GXShape::GetVertexOffsetAndCount(uint32_t& offset, uint32_t& count) const {
+    offset = mFirstVertexOffset;
+    count = mVertexCount;
+}
 
-        Triangles.push_back(v0);
-        Triangles.push_back(v1);
-        Triangles.push_back(v2);
-    }
+void GXShape::GetModelVertexRange(uint32_t& first, uint32_t& count) const {
+    first = mFirstModelVertex;
+    count = mModelVertexCount;
+}
 
-    mVertices = std::move(Triangles);
+void GXShape::GetLineOffsetAndCount(uint32_t& offset, uint32_t& count) const {
+    offset = mFirstLineIndex;
+    count = mLineIndexCount;
 }
 
-void GXPrimitive::TriangulateTriangleFan() {
-    std::vector<ModernVertex> Triangles;
+void GXShape::GetPointOffsetAndCount(uint32_t& offset, uint32_t& count) const {
+    offset = mFirstPointIndex;
+    count = mPointIndexCount;
+}
 
-    for (size_t i = 1; i < mVertices.size() - 1; i++) {
-        ModernVertex const& v0 = mVertices[i];
-        ModernVertex const& v1 = mVertices[i + 1];
-        ModernVertex const& v2 = mVertices[0];
+void GXShape::GetMeshletRange(uint32_t& first, uint32_t& count) const {
+    first = mFirstMeshlet;
+    count = mMeshletCount;
+}
 
-        // Reject degenerate triangles (triangles where two or more vertices are the same)
-        if (v0 == v1 || v0 == v2 || v1 == v2)
-            continue;
+void GXShape::GetTriangleRanges(std::vector<std::pair<uint32_t, uint32_t>>& ranges) const {
+    ranges.clear();
 
-        Triangles.push_back(v0);
-        Triangles.push_back(v1);
-        Triangles.push_back(v2);
+    for (const GXShapeDraw& Draw : mDraws) {
+        if (Draw.Type == EGXPrimitiveType::Triangles)
+            ranges.emplace_back(Draw.FirstIndex, Draw.IndexCount);
     }
 
-    mVertices = std::move(Triangles);
-}
-
-void GXShape::GetVertexOffsetAndCount(uint32_t& offset, uint32_t& count) const {
-    offset = mFirstVertexOffset;
-    count = mVertexCount;
+    if (ranges.empty())
+        ranges.emplace_back(mFirstVertexOffset, mVertexCount);
 }
 
 void GXShape::CalculateCenterOfMass() {
     size_t vertexCount = 0;
-    glm::vec3 center(0.0f, 0.0f, 0.0f);
+    glm::vec3 positionSum(0.0f);
+    GXBoundingBox box;
 
     for (const GXPrimitive* p : mPrimitives)
     {
-        for (const ModernVertex& v : p->GetVertices())
-        {
-            center.x += v.Position.x;
-            center.y += v.Position.y;
-            center.z += v.Position.z;
-
-            vertexCount++;
-        }
+        GXAccumulateBounds(p->GetVertices().data(), p->GetVertices().size(), positionSum, box);
+        vertexCount += p->GetVertices().size();
     }
 
     if (vertexCount == 0)
     {
+        mBoundingBox = GXBoundingBox();
+        mBoundingSphere = GXBoundingSphere();
         return;
     }
 
-    mCenterOfMass.x = center.x / vertexCount;
-    mCenterOfMass.y = center.y / vertexCount;
-    mCenterOfMass.z = center.z / vertexCount;
-}
+    float radiusSquared = 0.0f;
+    for (const GXPrimitive* p : mPrimitives)
+    {
+        radiusSquared = std::max(radiusSquared, GXCalculateMaxDistanceSquared(p->GetVertices().data(), p->GetVertices().size(), box.GetCenter()));
+    }
 
-ptrdiff_t VectorIndexOf(const std::vector<GXVertex>& vec, const GXVertex& elem)
-{
-    ptrdiff_t result = -1;
+    mCenterOfMass = positionSum / static_cast<float>(vertexCount);
+    mBoundingBox = box;
+    mBoundingSphere = GXBoundingSphere(box.GetCenter(), std::sqrt(radiusSquared));
+}
 
-    auto it = std::find(vec.begin(), vec.end(), elem);
-    if (it != vec.end())
-        result = it - vec.begin();
+void GXShape::CalculateBounds(const ModernVertex* vertices, size_t count) {
+    if (count == 0) {
+        mBoundingBox = GXBoundingBox();
+        mBoundingSphere = GXBoundingSphere();
+        return;
+    }
 
-    return result;
-}
+    glm::vec3 positionSum(0.0f);
+    GXBoundingBox box;
+    GXAccumulateBounds(vertices, count, positionSum, box);
 
-bool VectorContains(const std::vector<GXVertex>& vec, const GXVertex& elem, ptrdiff_t& index)
-{
-    index = VectorIndexOf(vec, elem);
-    return index != -1;
+    mCenterOfMass = positionSum / static_cast<float>(count);
+    mBoundingBox = box;
+    mBoundingSphere = GXBoundingSphere(box.GetCenter(), std::sqrt(GXCalculateMaxDistanceSquared(vertices, count, box.GetCenter())));
 }
 
 ModernVertex GXVertexToModern(const GXAttributeData& Attributes, const std::vector<EGXAttribute>& vat, const GXVertex& Vertex) {
     ModernVertex NewVertex;
 
-    uint32_t PosMatIndex = 0;
+    // Returns the vertex's index for the given attribute, making sure it's inside the attribute's array.
+    auto GetIndex = [&](EGXAttribute Attribute) {
+        uint16_t Index = Vertex.GetIndex(Attribute);
+        if (Index >= Attributes.GetArraySize(Attribute))
+            throw std::out_of_range("Vertex refers past the end of its attribute array!");
+
+        return Index;
+    };
 
     for (EGXAttribute Attribute : vat) {
         switch (Attribute) {
             case EGXAttribute::Position:
-                NewVertex.Position = Attributes.GetPositions()[Vertex.GetIndex(Attribute)];
+                NewVertex.Position = Attributes.GetPositions()[GetIndex(Attribute)];
                 NewVertex.Position.w = Vertex.GetIndex(EGXAttribute::PositionMatrixIdx);
                 break;
             case EGXAttribute::Normal:
-                NewVertex.Normal = Attributes.GetNormals()[Vertex.GetIndex(Attribute)];
+                NewVertex.Normal = Attributes.GetNormals()[GetIndex(Attribute)];
                 break;
             case EGXAttribute::Color0:
             case EGXAttribute::Color1:
             {
                 uint32_t index = (uint32_t)Attribute - (uint32_t)EGXAttribute::Color0;
-                NewVertex.Colors[index] = Attributes.GetColors(index)[Vertex.GetIndex(Attribute)];
+                NewVertex.Colors[index] = Attributes.GetColors(index)[GetIndex(Attribute)];
                 break;
             }
             case EGXAttribute::TexCoord0:
@@ -137,37 +294,1204 @@ ModernVertex GXVertexToModern(const GXAttributeData& Attributes, const std::vect
             case EGXAttribute::TexCoord7:
             {
                 uint32_t index = (uint32_t)Attribute - (uint32_t)EGXAttribute::TexCoord0;
-                NewVertex.TexCoords[index] = Attributes.GetTexCoords(index)[Vertex.GetIndex(Attribute)];
+                NewVertex.TexCoords[index] = Attributes.GetTexCoords(index)[GetIndex(Attribute)];
                 break;
             }
+            default:
+                break;
         }
     }
 
     return NewVertex;
 }
 
-void GXGeometry::CreateVertexArray() {
-    size_t index = 0;
+uint32_t GXGeometry::WeldVertex(const ModernVertex& vertex) {
+    auto result = mVertexWeldMap.emplace(vertex, static_cast<uint32_t>(mModelVertices.size()));
+
+    if (result.second) {
+        mModelVertices.push_back(vertex);
+
+        // New vertices have no frame of their own until tangent frames are generated again.
+        if (!mModelTangentFrames.empty())
+            mModelTangentFrames.push_back(glm::vec4(0.0f));
+    }
+
+    return result.first->second;
+}
+
+uint32_t GXGeometry::AddVertices(const ModernVertex* vertices, size_t count) {
+    if (count % 3 != 0)
+        throw std::invalid_argument("Triangle vertices must come in groups of three!");
+
+    uint32_t firstIndex = static_cast<uint32_t>(mModelIndices.size());
+
+    mModelIndices.reserve(mModelIndices.size() + count);
+    for (size_t i = 0; i < count; i++) {
+        mModelIndices.push_back(WeldVertex(vertices[i]));
+    }
+
+    return firstIndex;
+}
+
+void GXGeometry::CreateVertexArray(const GXVertexArrayOptions& options) {
+    // A run of consecutive vertices in a shape's vertex range, copied either straight out of a primitive
+    // or out of the shape's list of converted and welded vertices.
+    struct VertexRun {
+        const GXPrimitive* Source;
+        size_t Start;
+        size_t Count;
+    };
+
+    // A shape's flattened data before it is written into the model lists.
+    struct FlattenedShape {
+        // The shape's index lists, relative to the start of its vertex range.
+        GXPrimitiveIndices Indices;
+        size_t VertexCount = 0;
+
+        // Where each of the shape's vertices come from, in order.
+        std::vector<VertexRun> Runs;
+        // The shape's welded vertices and the vertices converted from its primitives in index form.
+        std::vector<ModernVertex> Vertices;
+    };
+
+    std::vector<FlattenedShape> Flattened(mShapes.size());
+
+    // First, triangulate every shape by vertex id and work out how much of the model lists it needs.
+    // Vertices are only welded within a shape, so every shape is independent of the others
+    // and owns a contiguous range of the model vertex list.
+    ParallelFor(mShapes.size(), options.ThreadCount, [&](size_t s) {
+        FlattenedShape& Out = Flattened[s];
+        const std::vector<GXPrimitive*>& Primitives = mShapes[s]->GetPrimitives();
+
+        size_t TotalVertices = 0;
+        for (const GXPrimitive* Prim : Primitives) {
+            TotalVertices += Prim->GetVertexCount();
+        }
+
+        std::unordered_map<ModernVertex, uint32_t, ModernVertexHash, ModernVertexBitwiseEqual> WeldMap;
+        if (options.WeldVertices)
+            WeldMap.reserve(TotalVertices);
+
+        // Adds a vertex to the shape's own vertex list, returning its id.
+        auto AddVertex = [&Out](const ModernVertex& vertex) {
+            if (Out.Runs.empty() || Out.Runs.back().Source != nullptr)
+                Out.Runs.push_back({ nullptr, Out.Vertices.size(), 0 });
+
+            Out.Runs.back().Count++;
+            Out.Vertices.push_back(vertex);
+
+            return static_cast<uint32_t>(Out.VertexCount++);
+        };
+
+        // Returns the id of the given vertex, adding it to the shape if it hasn't been welded to an earlier one.
+        auto WeldVertex = [&](const ModernVertex& vertex) {
+            auto result = WeldMap.emplace(vertex, static_cast<uint32_t>(Out.VertexCount));
+
+            if (result.second)
+                AddVertex(vertex);
+
+            return result.first->second;
+        };
+
+        // Vertices in index form are converted once per unique tuple; TupleIds holds the id of each converted tuple.
+        GXVertexCache Cache(mAttributeData);
+        Cache.SetAttributeTable(mShapes[s]->GetAttributeTable());
+        std::vector<uint32_t> TupleIds;
+
+        std::vector<uint32_t> VertexIds;
+        for (const GXPrimitive* Prim : Primitives) {
+            VertexIds.resize(Prim->GetVertexCount());
+
+            if (Prim->IsIndexed()) {
+                if (Prim->GetPackedStride() != Cache.GetFormat().GetStride())
+                    throw std::invalid_argument("Primitive in index form was packed with a different format than its shape's attribute table!");
+
+                for (size_t i = 0; i < VertexIds.size(); i++) {
+                    uint32_t Tuple = Cache.GetIndex(Prim->GetPackedVertex(i));
+
+                    if (Tuple == TupleIds.size()) {
+                        const ModernVertex& Converted = Cache.GetVertices()[Tuple];
+                        TupleIds.push_back(options.WeldVertices ? WeldVertex(Converted) : AddVertex(Converted));
+                    }
+
+                    VertexIds[i] = TupleIds[Tuple];
+                }
+            }
+            else if (options.WeldVertices) {
+                const std::vector<ModernVertex>& Vertices = Prim->GetVertices();
+
+                for (size_t i = 0; i < Vertices.size(); i++) {
+                    VertexIds[i] = WeldVertex(Vertices[i]);
+                }
+            }
+            else {
+                // Without welding, a primitive's vertices are copied into the model as they are.
+                Out.Runs.push_back({ Prim, 0, Prim->GetVertices().size() });
+
+                GXPrimitive::GetUnweldedVertexIds(Prim->GetVertices().data(), VertexIds.size(), static_cast<uint32_t>(Out.VertexCount), VertexIds.data());
+                Out.VertexCount += VertexIds.size();
+            }
+
+            GXPrimitive::TriangulateIndices(Prim->GetType(), VertexIds.data(), VertexIds.size(), Out.Indices);
+        }
+    });
+
+    // Lay the shapes out one after another in the model lists...
+    size_t IndexOffset = mModelIndices.size();
+    size_t LineOffset = mModelLineIndices.size();
+    size_t PointOffset = mModelPointIndices.size();
+    size_t VertexOffset = mModelVertices.size();
+
+    for (size_t s = 0; s < mShapes.size(); s++) {
+        GXShape& Shape = *mShapes[s];
+        const GXPrimitiveIndices& Indices = Flattened[s].Indices;
+
+        Shape.mFirstVertexOffset = static_cast<uint32_t>(IndexOffset);
+        Shape.mVertexCount = static_cast<uint32_t>(Indices.Triangles.size());
+        Shape.mFirstLineIndex = static_cast<uint32_t>(LineOffset);
+        Shape.mLineIndexCount = static_cast<uint32_t>(Indices.Lines.size());
+        Shape.mFirstPointIndex = static_cast<uint32_t>(PointOffset);
+        Shape.mPointIndexCount = static_cast<uint32_t>(Indices.Points.size());
+        Shape.mFirstModelVertex = static_cast<uint32_t>(VertexOffset);
+        Shape.mModelVertexCount = static_cast<uint32_t>(Flattened[s].VertexCount);
+
+        IndexOffset += Indices.Triangles.size();
+        LineOffset += Indices.Lines.size();
+        PointOffset += Indices.Points.size();
+        VertexOffset += Flattened[s].VertexCount;
+    }
+
+    mModelIndices.resize(IndexOffset);
+    mModelLineIndices.resize(LineOffset);
+    mModelPointIndices.resize(PointOffset);
+    mModelVertices.resize(VertexOffset);
+
+    // ...then fill in each shape's slice of them.
+    ParallelFor(mShapes.size(), options.ThreadCount, [&](size_t s) {
+        const GXShape& Shape = *mShapes[s];
+        FlattenedShape& In = Flattened[s];
+
+        ModernVertex* Vertices = mModelVertices.data() + Shape.mFirstModelVertex;
+
+        for (const VertexRun& Run : In.Runs) {
+            const ModernVertex* Source = Run.Source != nullptr ? Run.Source->GetVertices().data() : In.Vertices.data();
+            Vertices = std::copy(Source + Run.Start, Source + Run.Start + Run.Count, Vertices);
+        }
+
+        auto Rebase = [&Shape](const std::vector<uint32_t>& local, uint32_t* model) {
+            for (size_t i = 0; i < local.size(); i++) {
+                model[i] = Shape.mFirstModelVertex + local[i];
+            }
+        };
+
+        Rebase(In.Indices.Triangles, mModelIndices.data() + Shape.mFirstVertexOffset);
+        Rebase(In.Indices.Lines, mModelLineIndices.data() + Shape.mFirstLineIndex);
+        Rebase(In.Indices.Points, mModelPointIndices.data() + Shape.mFirstPointIndex);
+
+        // The shape's vertices were just written, so take the bounds while they're still in cache.
+        if (options.CalculateBounds)
+            mShapes[s]->CalculateBounds(mModelVertices.data() + Shape.mFirstModelVertex, Shape.mModelVertexCount);
+
+        In = FlattenedShape();
+    });
+
+    mVertexWeldMap.clear();
+
+    if (options.CalculateBounds)
+        GatherShapeBounds();
+
+    // Meshlets and levels of detail of the previous vertex array would index vertices that no longer exist.
+    mModelMeshlets.Clear();
+    mModelLodIndices.clear();
+    mModelTangentFrames.clear();
+    for (std::shared_ptr<GXShape>& Shape : mShapes) {
+        Shape->mFirstMeshlet = 0;
+        Shape->mMeshletCount = 0;
+        Shape->mDraws.clear();
+        Shape->mLods.clear();
+    }
+
+    if (options.CompactVertices)
+        BuildCompactVertices();
+    if (options.QuantizeVertices)
+        BuildQuantizedVertices();
+    if (options.SplitVertexStreams)
+        BuildVertexStreams();
+}
+
+void GXGeometry::BuildCompactVertices() {
+    std::vector<const std::vector<EGXAttribute>*> AttributeTables;
+    for (const std::shared_ptr<GXShape>& Shape : mShapes) {
+        AttributeTables.push_back(&Shape->GetAttributeTable());
+    }
+
+    if (HasTangentFrames() && mModelTangentFrames.size() != mModelVertices.size())
+        throw std::runtime_error("Model vertices were changed without their tangent frames; generate them again!");
+
+    mCompactVertexLayout = GXVertexLayout::FromAttributeTables(AttributeTables, false, HasTangentFrames());
+
+    mCompactVertices.clear();
+    mCompactVertices.shrink_to_fit();
+    GXPackVertices(mModelVertices.data(), mModelVertices.size(), mCompactVertexLayout, mCompactVertices, nullptr, mModelTangentFrames.data());
+}
+
+void GXGeometry::BuildQuantizedVertices() {
+    std::vector<const std::vector<EGXAttribute>*> AttributeTables;
+    for (const std::shared_ptr<GXShape>& Shape : mShapes) {
+        AttributeTables.push_back(&Shape->GetAttributeTable());
+    }
+
+    if (HasTangentFrames() && mModelTangentFrames.size() != mModelVertices.size())
+        throw std::runtime_error("Model vertices were changed without their tangent frames; generate them again!");
+
+    mQuantizedVertexLayout = GXVertexLayout::FromAttributeTables(AttributeTables, true, HasTangentFrames());
+    const uint32_t stride = mQuantizedVertexLayout.GetStride();
+
+    mQuantizedVertices.clear();
+    mQuantizedVertices.shrink_to_fit();
+    mQuantizedVertices.resize(mModelVertices.size() * stride);
+
+    // Packs a run of model vertices into its place in the quantized buffer.
+    std::vector<uint8_t> RunVertices;
+    auto PackRun = [&](uint32_t first, uint32_t count, const GXDequantizationParams& params) {
+        RunVertices.clear();
+        const glm::vec4* Frames = HasTangentFrames() ? mModelTangentFrames.data() + first : nullptr;
+        GXPackVertices(mModelVertices.data() + first, count, mQuantizedVertexLayout, RunVertices, &params, Frames);
+
+        if (!RunVertices.empty())
+            std::memcpy(mQuantizedVertices.data() + static_cast<size_t>(first) * stride, RunVertices.data(), RunVertices.size());
+    };
+
+    // Each shape is quantized to its own bounding box, so pack them one at a time into their vertex ranges.
+    std::vector<bool> InShape(mModelVertices.size(), false);
+    for (std::shared_ptr<GXShape>& Shape : mShapes) {
+        Shape->mDequantizationParams = GXCalculateDequantizationParams(mModelVertices.data() + Shape->mFirstModelVertex, Shape->mModelVertexCount);
+        PackRun(Shape->mFirstModelVertex, Shape->mModelVertexCount, Shape->mDequantizationParams);
+
+        std::fill(InShape.begin() + Shape->mFirstModelVertex, InShape.begin() + Shape->mFirstModelVertex + Shape->mModelVertexCount, true);
+    }
+
+    // Vertices outside of every shape, such as from AddVertices, share one set of parameters covering all of them.
+    std::vector<std::pair<uint32_t, uint32_t>> LooseRuns;
+    for (uint32_t v = 0; v < InShape.size(); v++) {
+        if (InShape[v])
+            continue;
+
+        if (LooseRuns.empty() || LooseRuns.back().first + LooseRuns.back().second != v)
+            LooseRuns.emplace_back(v, 0);
+
+        LooseRuns.back().second++;
+    }
+
+    mDequantizationParams = GXDequantizationParams();
+    if (!LooseRuns.empty()) {
+        glm::vec3 Min(std::numeric_limits<float>::max());
+        glm::vec3 Max(std::numeric_limits<float>::lowest());
+
+        for (const std::pair<uint32_t, uint32_t>& Run : LooseRuns) {
+            GXDequantizationParams RunParams = GXCalculateDequantizationParams(mModelVertices.data() + Run.first, Run.second);
+            Min = glm::min(Min, RunParams.PositionOffset);
+            Max = glm::max(Max, RunParams.PositionOffset + RunParams.PositionScale);
+        }
+
+        mDequantizationParams.PositionOffset = Min;
+        mDequantizationParams.PositionScale = Max - Min;
+    }
+
+    for (const std::pair<uint32_t, uint32_t>& Run : LooseRuns) {
+        PackRun(Run.first, Run.second, mDequantizationParams);
+    }
+}
+
+// Returns whether the given vertex has a position matrix index, and stores it in index if so.
+static bool GetPositionMatrixIndex(const ModernVertex& vertex, uint32_t& index) {
+    const float w = vertex.Position.w;
+
+    // Written so that NaN fails the test too.
+    if (!(w >= 0.0f && w < static_cast<float>(UINT16_MAX)))
+        return false;
+
+    index = static_cast<uint32_t>(w);
+    return true;
+}
+
+void GXGeometry::BuildVertexStreams() {
+    bool enabled[(uint32_t)EGXAttribute::Attribute_Max] = {};
+
+    for (const std::shared_ptr<GXShape>& Shape : mShapes) {
+        for (EGXAttribute Attribute : Shape->GetAttributeTable()) {
+            if (Attribute == EGXAttribute::NBT)
+                Attribute = EGXAttribute::Normal;
+
+            if ((uint32_t)Attribute < (uint32_t)EGXAttribute::Attribute_Max)
+                enabled[(uint32_t)Attribute] = true;
+        }
+    }
+
+    mModelStreams = GXAttributeData();
+    const size_t VertexCount = mModelVertices.size();
+
+    // Fill each stream in its own pass, so every loop writes to a single contiguous array.
+    if (enabled[(uint32_t)EGXAttribute::Position]) {
+        std::vector<glm::vec4>& Positions = mModelStreams.GetPositions();
+        Positions.resize(VertexCount);
+
+        for (size_t i = 0; i < VertexCount; i++) {
+            Positions[i] = mModelVertices[i].Position;
+        }
+    }
+
+    if (enabled[(uint32_t)EGXAttribute::PositionMatrixIdx]) {
+        std::vector<uint32_t>& MatrixIndices = mModelStreams.GetPositionMatrixIndices();
+        MatrixIndices.resize(VertexCount);
+
+        for (size_t i = 0; i < VertexCount; i++) {
+            // Vertices without a valid matrix index get UINT16_MAX, as they would from an unset GXVertex index.
+            if (!GetPositionMatrixIndex(mModelVertices[i], MatrixIndices[i]))
+                MatrixIndices[i] = UINT16_MAX;
+        }
+    }
+
+    if (enabled[(uint32_t)EGXAttribute::Normal]) {
+        std::vector<glm::vec3>& Normals = mModelStreams.GetNormals();
+        Normals.resize(VertexCount);
+
+        for (size_t i = 0; i < VertexCount; i++) {
+            Normals[i] = mModelVertices[i].Normal;
+        }
+    }
+
+    for (uint32_t c = 0; c < 2; c++) {
+        if (!enabled[(uint32_t)EGXAttribute::Color0 + c])
+            continue;
+
+        std::vector<glm::vec4>& Colors = mModelStreams.GetColors(c);
+        Colors.resize(VertexCount);
+
+        for (size_t i = 0; i < VertexCount; i++) {
+            Colors[i] = mModelVertices[i].Colors[c];
+        }
+    }
+
+    for (uint32_t t = 0; t < 8; t++) {
+        if (!enabled[(uint32_t)EGXAttribute::TexCoord0 + t])
+            continue;
+
+        std::vector<glm::vec3>& TexCoords = mModelStreams.GetTexCoords(t);
+        TexCoords.resize(VertexCount);
+
+        for (size_t i = 0; i < VertexCount; i++) {
+            TexCoords[i] = mModelVertices[i].TexCoords[t];
+        }
+    }
+}
+
+void GXGeometry::CalculateShapeBounds(uint32_t threadCount) {
+    ParallelFor(mShapes.size(), threadCount, [&](size_t s) {
+        GXShape& Shape = *mShapes[s];
+        Shape.CalculateBounds(mModelVertices.data() + Shape.mFirstModelVertex, Shape.mModelVertexCount);
+    });
+
+    GatherShapeBounds();
+}
+
+void GXGeometry::SkinVertices(const GXSkinPalette& palette, std::vector<glm::vec3>& positions, std::vector<glm::vec3>& normals, uint32_t threadCount) const {
+    positions.resize(mModelVertices.size());
+    normals.resize(mModelVertices.size());
+
+    // Vertices outside of every shape's range, from AddVertices or earlier calls to CreateVertexArray,
+    // get one work item for those before the shapes and one for those after them.
+    uint32_t ShapeVertexStart = static_cast<uint32_t>(mModelVertices.size());
+    uint32_t ShapeVertexEnd = 0;
+    for (const std::shared_ptr<GXShape>& Shape : mShapes) {
+        ShapeVertexStart = std::min(ShapeVertexStart, Shape->mFirstModelVertex);
+        ShapeVertexEnd = std::max(ShapeVertexEnd, Shape->mFirstModelVertex + Shape->mModelVertexCount);
+    }
+
+    ShapeVertexEnd = std::max(ShapeVertexEnd, ShapeVertexStart);
+
+    ParallelFor(mShapes.size() + 2, threadCount, [&](size_t s) {
+        uint32_t First = 0;
+        uint32_t Count = ShapeVertexStart;
+
+        if (s < mShapes.size()) {
+            First = mShapes[s]->mFirstModelVertex;
+            Count = mShapes[s]->mModelVertexCount;
+        }
+        else if (s == mShapes.size() + 1) {
+            First = ShapeVertexEnd;
+            Count = static_cast<uint32_t>(mModelVertices.size()) - ShapeVertexEnd;
+        }
+
+        if (s >= mShapes.size() || mShapes[s]->mDraws.empty()) {
+            GXSkinVertices(mModelVertices.data() + First, Count, palette, positions.data() + First, normals.data() + First);
+            return;
+        }
+
+        // Position.w of a partitioned shape's vertices is a slot in the palette of the one draw using them,
+        // so gather the vertices each draw reaches first and skin them through its palette in one batch.
+        const GXShape& Shape = *mShapes[s];
+        std::vector<bool> Skinned(Count, false);
+        std::vector<uint32_t> DrawVertices;
+
+        for (const GXShapeDraw& Draw : Shape.mDraws) {
+            const std::vector<uint32_t>& Indices = Draw.Type == EGXPrimitiveType::Triangles ? mModelIndices :
+                                                   Draw.Type == EGXPrimitiveType::Lines ? mModelLineIndices : mModelPointIndices;
+
+            DrawVertices.clear();
+            for (uint32_t i = Draw.FirstIndex; i < Draw.FirstIndex + Draw.IndexCount; i++) {
+                const uint32_t Vertex = Indices[i];
+                if (Skinned[Vertex - First])
+                    continue;
+
+                DrawVertices.push_back(Vertex);
+                Skinned[Vertex - First] = true;
+            }
+
+            GXSkinVertices(mModelVertices.data(), DrawVertices.data(), DrawVertices.size(), palette, positions.data(), normals.data(), &Draw.Palette);
+        }
+
+        // Vertices that no draw uses have no palette to look their slot up in, so they stay untransformed.
+        for (uint32_t v = 0; v < Count; v++) {
+            if (!Skinned[v]) {
+                positions[First + v] = glm::vec3(mModelVertices[First + v].Position);
+                normals[First + v] = mModelVertices[First + v].Normal;
+            }
+        }
+    });
+}
+
+namespace {
+    // A run of a model list that lies outside of every shape: Count entries moving from Source to Target.
+    struct ListGap {
+        uint32_t Source;
+        uint32_t Target;
+        uint32_t Count;
+    };
+}
+
+// Lays a model list of the given size out again once each shape's range of it, given as an offset and count, is
+// resized to newCounts[s] entries. Fills newOffsets with where each shape's range starts afterwards, and gaps with
+// where every run of entries outside of the shapes moves to, keeping everything in its order. Returns the new size.
+static size_t LayOutShapeRanges(size_t size, const std::vector<std::pair<uint32_t, uint32_t>>& ranges, const std::vector<uint32_t>& newCounts,
+                                std::vector<uint32_t>& newOffsets, std::vector<ListGap>& gaps) {
+    // Empty ranges sort before a range starting at the same place, so every range starts after the one before ends.
+    std::vector<size_t> Order(ranges.size());
+    std::iota(Order.begin(), Order.end(), 0);
+    std::sort(Order.begin(), Order.end(), [&ranges](size_t a, size_t b) {
+        return std::make_pair(ranges[a].first, ranges[a].second) < std::make_pair(ranges[b].first, ranges[b].second);
+    });
+
+    newOffsets.resize(ranges.size());
+    gaps.clear();
+
+    size_t Source = 0, Target = 0;
+    auto AddGap = [&](size_t end) {
+        if (end > Source)
+            gaps.push_back({ static_cast<uint32_t>(Source), static_cast<uint32_t>(Target), static_cast<uint32_t>(end - Source) });
+
+        Target += end - Source;
+        Source = end;
+    };
+
+    for (size_t s : Order) {
+        if (ranges[s].first < Source || static_cast<size_t>(ranges[s].first) + ranges[s].second > size)
+            throw std::runtime_error("Shapes' ranges of the model lists overlap or run past their end!");
+
+        AddGap(ranges[s].first);
+
+        newOffsets[s] = static_cast<uint32_t>(Target);
+        Target += newCounts[s];
+        Source += ranges[s].second;
+    }
+
+    AddGap(size);
+    return Target;
+}
+
+void GXGeometry::PartitionMatrixPalettes(uint32_t maxMatrices, uint32_t threadCount) {
+    if (maxMatrices < 3)
+        throw std::invalid_argument("Palettes must hold at least 3 matrices to fit any triangle!");
+
+    // Position.w already holds palette slots rather than matrix indices, so partitioning again would mix up palettes.
+    for (const std::shared_ptr<GXShape>& Shape : mShapes) {
+        if (!Shape->mDraws.empty())
+            throw std::runtime_error("Matrix palettes have already been partitioned; recreate the vertex array to partition again!");
+    }
+
+    // A shape's primitives grouped into draws, with vertices and indices relative to the shape.
+    struct PartitionedShape {
+        GXPrimitiveIndices Indices;
+        std::vector<ModernVertex> Vertices;
+        // The tangent frame of each copied vertex, if the model has them.
+        std::vector<glm::vec4> TangentFrames;
+        std::vector<GXShapeDraw> Draws;
+        // The first copy made of each of the shape's original vertices, or UINT32_MAX if no primitive used it.
+        std::vector<uint32_t> FirstCopy;
+    };
+
+    std::vector<PartitionedShape> Partitioned(mShapes.size());
+
+    ParallelFor(mShapes.size(), threadCount, [&](size_t s) {
+        const GXShape& Shape = *mShapes[s];
+        PartitionedShape& Out = Partitioned[s];
+
+        // Tracks which draw each of the shape's vertices was last copied into, and where.
+        std::vector<uint32_t> CopiedInDraw(Shape.mModelVertexCount, UINT32_MAX);
+        std::vector<uint32_t> CopiedVertex(Shape.mModelVertexCount, 0);
+        uint32_t DrawId = 0;
+        Out.FirstCopy.assign(Shape.mModelVertexCount, UINT32_MAX);
 
-    for (std::shared_ptr<GXShape> Shape : mShapes) {
-        std::vector<GXPrimitive*>& Primitives = Shape->GetPrimitives();
-        std::vector<EGXAttribute> AttributeTable = Shape->GetAttributeTable();
+        auto Partition = [&](EGXPrimitiveType type, const uint32_t* indices, size_t indexCount, uint32_t primitiveSize, std::vector<uint32_t>& output) {
+            // A draw being filled: its palette, and the primitives assigned to it.
+            struct OpenDraw {
+                std::vector<uint32_t> Palette;
+                std::vector<uint32_t> Primitives;
+            };
 
-        Shape->mFirstVertexOffset = static_cast<uint32_t>(mModelIndices.size());
+            std::vector<OpenDraw> Draws;
+            uint32_t Matrices[3];
 
-        // ...iterate the primitive data...
-        for (GXPrimitive* Prim : Primitives) {
-            Prim->TriangluatePrimitive();
-            std::vector<ModernVertex>& Vertices = Prim->GetVertices();
+            for (size_t p = 0; p < indexCount / primitiveSize; p++) {
+                uint32_t MatrixCount = 0;
+                for (uint32_t c = 0; c < primitiveSize; c++) {
+                    uint32_t Index;
+                    if (GetPositionMatrixIndex(mModelVertices[indices[p * primitiveSize + c]], Index) &&
+                        std::find(Matrices, Matrices + MatrixCount, Index) == Matrices + MatrixCount)
+                        Matrices[MatrixCount++] = Index;
+                }
 
-            // ...and process each vertex into a
-            // ModernVertex (containing the actual vertex data) and an index.
-            for (ModernVertex& vertex : Vertices) {
-                mModelVertices.push_back(vertex);
-                mModelIndices.push_back(static_cast<uint32_t>(index++));
+                // Pick the draw that needs the fewest new matrices to take this primitive.
+                size_t Best = SIZE_MAX;
+                uint32_t BestNew = UINT32_MAX;
+
+                for (size_t d = 0; d < Draws.size() && BestNew != 0; d++) {
+                    const std::vector<uint32_t>& Palette = Draws[d].Palette;
+
+                    uint32_t New = 0;
+                    for (uint32_t m = 0; m < MatrixCount; m++) {
+                        New += std::find(Palette.begin(), Palette.end(), Matrices[m]) == Palette.end();
+                    }
+
+                    if (Palette.size() + New <= maxMatrices && New < BestNew) {
+                        Best = d;
+                        BestNew = New;
+                    }
+                }
+
+                if (Best == SIZE_MAX) {
+                    Best = Draws.size();
+                    Draws.emplace_back();
+                }
+
+                std::vector<uint32_t>& Palette = Draws[Best].Palette;
+                for (uint32_t m = 0; m < MatrixCount; m++) {
+                    if (std::find(Palette.begin(), Palette.end(), Matrices[m]) == Palette.end())
+                        Palette.push_back(Matrices[m]);
+                }
+
+                Draws[Best].Primitives.push_back(static_cast<uint32_t>(p));
+            }
+
+            // Emit each draw's primitives with their own copies of the vertices, pointing at palette slots.
+            for (OpenDraw& Draw : Draws) {
+                GXShapeDraw ShapeDraw;
+                ShapeDraw.Type = type;
+                ShapeDraw.FirstIndex = static_cast<uint32_t>(output.size());
+                ShapeDraw.IndexCount = static_cast<uint32_t>(Draw.Primitives.size() * primitiveSize);
+
+                for (uint32_t p : Draw.Primitives) {
+                    for (uint32_t c = 0; c < primitiveSize; c++) {
+                        uint32_t Vertex = indices[p * primitiveSize + c] - Shape.mFirstModelVertex;
+
+                        if (CopiedInDraw[Vertex] != DrawId) {
+                            ModernVertex Copy = mModelVertices[Shape.mFirstModelVertex + Vertex];
+
+                            uint32_t Index;
+                            if (GetPositionMatrixIndex(Copy, Index))
+                                Copy.Position.w = static_cast<float>(std::find(Draw.Palette.begin(), Draw.Palette.end(), Index) - Draw.Palette.begin());
+
+                            CopiedInDraw[Vertex] = DrawId;
+                            CopiedVertex[Vertex] = static_cast<uint32_t>(Out.Vertices.size());
+                            if (Out.FirstCopy[Vertex] == UINT32_MAX)
+                                Out.FirstCopy[Vertex] = CopiedVertex[Vertex];
+
+                            Out.Vertices.push_back(Copy);
+                            if (!mModelTangentFrames.empty())
+                                Out.TangentFrames.push_back(mModelTangentFrames[Shape.mFirstModelVertex + Vertex]);
+                        }
+
+                        output.push_back(CopiedVertex[Vertex]);
+                    }
+                }
+
+                ShapeDraw.Palette = std::move(Draw.Palette);
+                Out.Draws.push_back(std::move(ShapeDraw));
+                DrawId++;
             }
+        };
+
+        Partition(EGXPrimitiveType::Triangles, mModelIndices.data() + Shape.mFirstVertexOffset, Shape.mVertexCount, 3, Out.Indices.Triangles);
+        Partition(EGXPrimitiveType::Lines, mModelLineIndices.data() + Shape.mFirstLineIndex, Shape.mLineIndexCount, 2, Out.Indices.Lines);
+        Partition(EGXPrimitiveType::Points, mModelPointIndices.data() + Shape.mFirstPointIndex, Shape.mPointIndexCount, 1, Out.Indices.Points);
+    });
+
+    if (mShapes.empty())
+        return;
+
+    // The model lists can also hold data outside of every shape, from AddVertices or earlier calls to
+    // CreateVertexArray, before, between or after the shapes. It keeps its place around the shapes' new ranges.
+    std::vector<std::pair<uint32_t, uint32_t>> Ranges(mShapes.size());
+    std::vector<uint32_t> NewCounts(mShapes.size());
+    std::vector<uint32_t> NewOffsets;
+    std::vector<ListGap> Gaps;
+
+    for (size_t s = 0; s < mShapes.size(); s++) {
+        Ranges[s] = { mShapes[s]->mFirstModelVertex, mShapes[s]->mModelVertexCount };
+        NewCounts[s] = static_cast<uint32_t>(Partitioned[s].Vertices.size());
+    }
+
+    const size_t VertexCount = LayOutShapeRanges(mModelVertices.size(), Ranges, NewCounts, NewOffsets, Gaps);
+
+    // Where every old vertex ends up, so indices outside of the shapes and the weld map can follow their vertices.
+    // A shape's vertex goes to its first copy; one that no primitive used keeps the shape's first vertex.
+    std::vector<uint32_t> Remap(mModelVertices.size());
+    std::vector<ModernVertex> Vertices(VertexCount);
+    std::vector<glm::vec4> TangentFrames(mModelTangentFrames.empty() ? 0 : VertexCount);
+
+    for (const ListGap& Gap : Gaps) {
+        std::copy(mModelVertices.begin() + Gap.Source, mModelVertices.begin() + Gap.Source + Gap.Count, Vertices.begin() + Gap.Target);
+        std::iota(Remap.begin() + Gap.Source, Remap.begin() + Gap.Source + Gap.Count, Gap.Target);
+
+        if (!TangentFrames.empty())
+            std::copy(mModelTangentFrames.begin() + Gap.Source, mModelTangentFrames.begin() + Gap.Source + Gap.Count, TangentFrames.begin() + Gap.Target);
+    }
+
+    for (size_t s = 0; s < mShapes.size(); s++) {
+        GXShape& Shape = *mShapes[s];
+        const std::vector<uint32_t>& FirstCopy = Partitioned[s].FirstCopy;
+
+        for (uint32_t v = 0; v < Shape.mModelVertexCount; v++) {
+            Remap[Shape.mFirstModelVertex + v] = NewOffsets[s] + (FirstCopy[v] != UINT32_MAX ? FirstCopy[v] : 0);
         }
 
-        Shape->mVertexCount = static_cast<uint32_t>(mModelIndices.size()) - Shape->mFirstVertexOffset;
+        Shape.mFirstModelVertex = NewOffsets[s];
+        Shape.mModelVertexCount = NewCounts[s];
     }
+
+    mModelVertices = std::move(Vertices);
+    mModelTangentFrames = std::move(TangentFrames);
+
+    for (auto& Entry : mVertexWeldMap) {
+        Entry.second = Remap[Entry.second];
+    }
+
+    // Lay the index lists out again the same way, since draws that share vertices got their own copies...
+    auto LayOutIndices = [&](std::vector<uint32_t>& indices, uint32_t GXShape::*first, uint32_t GXShape::*count,
+                             std::vector<uint32_t> GXPrimitiveIndices::*partitioned) {
+        for (size_t s = 0; s < mShapes.size(); s++) {
+            Ranges[s] = { mShapes[s].get()->*first, mShapes[s].get()->*count };
+            NewCounts[s] = static_cast<uint32_t>((Partitioned[s].Indices.*partitioned).size());
+        }
+
+        std::vector<uint32_t> NewIndices(LayOutShapeRanges(indices.size(), Ranges, NewCounts, NewOffsets, Gaps));
+
+        for (const ListGap& Gap : Gaps) {
+            for (uint32_t i = 0; i < Gap.Count; i++) {
+                NewIndices[Gap.Target + i] = Remap[indices[Gap.Source + i]];
+            }
+        }
+
+        for (size_t s = 0; s < mShapes.size(); s++) {
+            mShapes[s].get()->*first = NewOffsets[s];
+            mShapes[s].get()->*count = NewCounts[s];
+        }
+
+        indices = std::move(NewIndices);
+    };
+
+    LayOutIndices(mModelIndices, &GXShape::mFirstVertexOffset, &GXShape::mVertexCount, &GXPrimitiveIndices::Triangles);
+    LayOutIndices(mModelLineIndices, &GXShape::mFirstLineIndex, &GXShape::mLineIndexCount, &GXPrimitiveIndices::Lines);
+    LayOutIndices(mModelPointIndices, &GXShape::mFirstPointIndex, &GXShape::mPointIndexCount, &GXPrimitiveIndices::Points);
+
+    // ...then fill in each shape's slice of the model lists.
+    ParallelFor(mShapes.size(), threadCount, [&](size_t s) {
+        GXShape& Shape = *mShapes[s];
+        PartitionedShape& In = Partitioned[s];
+
+        std::copy(In.Vertices.begin(), In.Vertices.end(), mModelVertices.begin() + Shape.mFirstModelVertex);
+        if (!mModelTangentFrames.empty())
+            std::copy(In.TangentFrames.begin(), In.TangentFrames.end(), mModelTangentFrames.begin() + Shape.mFirstModelVertex);
+
+        auto Rebase = [&Shape](const std::vector<uint32_t>& local, uint32_t* model) {
+            for (size_t i = 0; i < local.size(); i++) {
+                model[i] = Shape.mFirstModelVertex + local[i];
+            }
+        };
+
+        Rebase(In.Indices.Triangles, mModelIndices.data() + Shape.mFirstVertexOffset);
+        Rebase(In.Indices.Lines, mModelLineIndices.data() + Shape.mFirstLineIndex);
+        Rebase(In.Indices.Points, mModelPointIndices.data() + Shape.mFirstPointIndex);
+
+        for (GXShapeDraw& Draw : In.Draws) {
+            switch (Draw.Type) {
+                case EGXPrimitiveType::Triangles:
+                    Draw.FirstIndex += Shape.mFirstVertexOffset;
+                    break;
+                case EGXPrimitiveType::Lines:
+                    Draw.FirstIndex += Shape.mFirstLineIndex;
+                    break;
+                default:
+                    Draw.FirstIndex += Shape.mFirstPointIndex;
+                    break;
+            }
+        }
+
+        Shape.mDraws = std::move(In.Draws);
+        In = PartitionedShape();
+    });
+
+    mModelMeshlets.Clear();
+    mModelLodIndices.clear();
+    for (std::shared_ptr<GXShape>& Shape : mShapes) {
+        Shape->mFirstMeshlet = 0;
+        Shape->mMeshletCount = 0;
+        Shape->mLods.clear();
+    }
+
+    RefreshVertexBuffers();
+}
+
+void GXGeometry::GatherShapeBounds() {
+    mShapeBounds.Resize(mShapes.size());
+
+    for (size_t s = 0; s < mShapes.size(); s++) {
+        mShapeBounds.Set(s, mShapes[s]->mBoundingBox, mShapes[s]->mBoundingSphere);
+    }
+}
+
+void GXGeometry::CullShapes(const GXFrustum& frustum, std::vector<uint32_t>& visibleBits) const {
+    if (mShapeBounds.Count != mShapes.size())
+        throw std::runtime_error("Shape bounds must be calculated before culling!");
+
+    visibleBits.resize((mShapes.size() + 31) / 32);
+    GXCullBounds(mShapeBounds, frustum, visibleBits.data());
+}
+
+uint32_t GXGeometry::CullShapes(const GXFrustum& frustum) {
+    std::vector<uint32_t> VisibleBits;
+    CullShapes(frustum, VisibleBits);
+
+    uint32_t VisibleCount = 0;
+    for (size_t s = 0; s < mShapes.size(); s++) {
+        bool bVisible = (VisibleBits[s / 32] >> (s % 32)) & 1;
+
+        mShapes[s]->mbIsVisible = bVisible;
+        VisibleCount += bVisible;
+    }
+
+    return VisibleCount;
+}
+
+void GXGeometry::BuildMeshlets(uint32_t maxVertices, uint32_t maxTriangles, uint32_t threadCount) {
+    std::vector<GXMeshletList> ShapeMeshlets(mShapes.size());
+
+    ParallelFor(mShapes.size(), threadCount, [&](size_t s) {
+        std::vector<std::pair<uint32_t, uint32_t>> Ranges;
+        mShapes[s]->GetTriangleRanges(Ranges);
+
+        // Meshlets never straddle two draws, so each one only needs its draw's palette.
+        for (const std::pair<uint32_t, uint32_t>& Range : Ranges) {
+            GXBuildMeshlets(mModelIndices.data() + Range.first, Range.second, mModelVertices.data(),
+                            maxVertices, maxTriangles, static_cast<uint32_t>(s), ShapeMeshlets[s]);
+        }
+    });
+
+    mModelMeshlets.Clear();
+
+    size_t MeshletCount = 0, VertexCount = 0, TriangleCount = 0;
+    for (const GXMeshletList& List : ShapeMeshlets) {
+        MeshletCount += List.Meshlets.size();
+        VertexCount += List.Vertices.size();
+        TriangleCount += List.Triangles.size();
+    }
+
+    mModelMeshlets.Meshlets.reserve(MeshletCount);
+    mModelMeshlets.Vertices.reserve(VertexCount);
+    mModelMeshlets.Triangles.reserve(TriangleCount);
+
+    // Append each shape's meshlets, moving their offsets to where their data lands in the model lists.
+    for (size_t s = 0; s < mShapes.size(); s++) {
+        GXMeshletList& List = ShapeMeshlets[s];
+        const uint32_t VertexBase = static_cast<uint32_t>(mModelMeshlets.Vertices.size());
+        const uint32_t TriangleBase = static_cast<uint32_t>(mModelMeshlets.Triangles.size() / 3);
+
+        mShapes[s]->mFirstMeshlet = static_cast<uint32_t>(mModelMeshlets.Meshlets.size());
+        mShapes[s]->mMeshletCount = static_cast<uint32_t>(List.Meshlets.size());
+
+        for (GXMeshlet& Meshlet : List.Meshlets) {
+            Meshlet.VertexOffset += VertexBase;
+            Meshlet.TriangleOffset += TriangleBase;
+            mModelMeshlets.Meshlets.push_back(Meshlet);
+        }
+
+        mModelMeshlets.Vertices.insert(mModelMeshlets.Vertices.end(), List.Vertices.begin(), List.Vertices.end());
+        mModelMeshlets.Triangles.insert(mModelMeshlets.Triangles.end(), List.Triangles.begin(), List.Triangles.end());
+        List = GXMeshletList();
+    }
+}
+
+GXVertexCacheReport GXGeometry::OptimizeVertexCache(uint32_t analysisCacheSize, uint32_t threadCount) {
+    std::vector<GXVertexCacheReport> ShapeReports(mShapes.size());
+
+    ParallelFor(mShapes.size(), threadCount, [&](size_t s) {
+        const GXShape& Shape = *mShapes[s];
+
+        std::vector<std::pair<uint32_t, uint32_t>> Ranges;
+        Shape.GetTriangleRanges(Ranges);
+
+        for (const std::pair<uint32_t, uint32_t>& Range : Ranges) {
+            uint32_t* Indices = mModelIndices.data() + Range.first;
+
+            ShapeReports[s].Before += GXAnalyzeVertexCache(Indices, Range.second, analysisCacheSize);
+            GXOptimizeVertexCache(Indices, Range.second, Shape.mFirstModelVertex, Shape.mModelVertexCount);
+            ShapeReports[s].After += GXAnalyzeVertexCache(Indices, Range.second, analysisCacheSize);
+        }
+    });
+
+    GXVertexCacheReport Report;
+    for (const GXVertexCacheReport& ShapeReport : ShapeReports) {
+        Report.Before += ShapeReport.Before;
+        Report.After += ShapeReport.After;
+    }
+
+    return Report;
+}
+
+GXVertexCacheReport GXGeometry::OptimizeOverdraw(float threshold, const std::function<bool(const GXShape&)>& shapeFilter,
+                                                 uint32_t analysisCacheSize, uint32_t threadCount) {
+    std::vector<GXVertexCacheReport> ShapeReports(mShapes.size());
+
+    ParallelFor(mShapes.size(), threadCount, [&](size_t s) {
+        const GXShape& Shape = *mShapes[s];
+        if (shapeFilter && !shapeFilter(Shape))
+            return;
+
+        std::vector<std::pair<uint32_t, uint32_t>> Ranges;
+        Shape.GetTriangleRanges(Ranges);
+
+        for (const std::pair<uint32_t, uint32_t>& Range : Ranges) {
+            uint32_t* Indices = mModelIndices.data() + Range.first;
+
+            ShapeReports[s].Before += GXAnalyzeVertexCache(Indices, Range.second, analysisCacheSize);
+            GXOptimizeOverdraw(Indices, Range.second, mModelVertices.data(), Shape.mFirstModelVertex, Shape.mModelVertexCount,
+                               threshold, analysisCacheSize);
+            ShapeReports[s].After += GXAnalyzeVertexCache(Indices, Range.second, analysisCacheSize);
+        }
+    });
+
+    GXVertexCacheReport Report;
+    for (const GXVertexCacheReport& ShapeReport : ShapeReports) {
+        Report.Before += ShapeReport.Before;
+        Report.After += ShapeReport.After;
+    }
+
+    return Report;
+}
+
+void GXGeometry::OptimizeVertexFetch(uint32_t threadCount) {
+    // Vertices outside of every shape stay where they are.
+    std::vector<uint32_t> Remap(mModelVertices.size());
+    std::iota(Remap.begin(), Remap.end(), 0);
+
+    ParallelFor(mShapes.size(), threadCount, [&](size_t s) {
+        const GXShape& Shape = *mShapes[s];
+
+        // Triangles come first since they make up almost all of a shape's fetches.
+        std::vector<uint32_t> ShapeIndices;
+        ShapeIndices.reserve(Shape.mVertexCount + Shape.mLineIndexCount + Shape.mPointIndexCount);
+        ShapeIndices.insert(ShapeIndices.end(), mModelIndices.begin() + Shape.mFirstVertexOffset,
+                            mModelIndices.begin() + Shape.mFirstVertexOffset + Shape.mVertexCount);
+        ShapeIndices.insert(ShapeIndices.end(), mModelLineIndices.begin() + Shape.mFirstLineIndex,
+                            mModelLineIndices.begin() + Shape.mFirstLineIndex + Shape.mLineIndexCount);
+        ShapeIndices.insert(ShapeIndices.end(), mModelPointIndices.begin() + Shape.mFirstPointIndex,
+                            mModelPointIndices.begin() + Shape.mFirstPointIndex + Shape.mPointIndexCount);
+
+        GXBuildVertexFetchRemap(ShapeIndices.data(), ShapeIndices.size(), Shape.mFirstModelVertex, Shape.mModelVertexCount,
+                                Remap.data() + Shape.mFirstModelVertex);
+    });
+
+    RemapModelVertices(Remap, threadCount);
+    RefreshVertexBuffers();
+}
+
+void GXGeometry::BuildLods(uint32_t maxLods, float reduction, float maxError, uint32_t threadCount) {
+    if (!(reduction > 0.0f && reduction < 1.0f))
+        throw std::invalid_argument("LOD reduction must be between 0 and 1");
+
+    // A shape's levels before they are written into the model LOD index list, with offsets relative to the level.
+    struct ShapeLods {
+        std::vector<GXShapeLod> Lods;
+        std::vector<std::vector<uint32_t>> Indices;
+    };
+
+    std::vector<ShapeLods> Built(mShapes.size());
+
+    ParallelFor(mShapes.size(), threadCount, [&](size_t s) {
+        const GXShape& Shape = *mShapes[s];
+        ShapeLods& Out = Built[s];
+
+        const float Scale = GXGetSimplifyScale(mModelVertices.data(), Shape.mFirstModelVertex, Shape.mModelVertexCount);
+
+        std::vector<std::pair<uint32_t, uint32_t>> Ranges;
+        Shape.GetTriangleRanges(Ranges);
+
+        // Simplify each range on its own, so triangles never mix vertices of two draws.
+        std::vector<std::vector<uint32_t>> Previous(Ranges.size());
+        size_t PreviousCount = 0;
+        for (size_t r = 0; r < Ranges.size(); r++) {
+            Previous[r].assign(mModelIndices.begin() + Ranges[r].first, mModelIndices.begin() + Ranges[r].first + Ranges[r].second);
+            PreviousCount += Ranges[r].second;
+        }
+
+        float Error = 0.0f;
+        for (uint32_t Level = 0; Level < maxLods && PreviousCount > 0; Level++) {
+            std::vector<std::vector<uint32_t>> Current(Ranges.size());
+            size_t CurrentCount = 0;
+            float LevelError = 0.0f;
+
+            for (size_t r = 0; r < Ranges.size(); r++) {
+                size_t Target = static_cast<size_t>(Previous[r].size() / 3 * reduction) * 3;
+                float RangeError = GXSimplifyMesh(Previous[r].data(), Previous[r].size(), mModelVertices.data(), Shape.mFirstModelVertex,
+                                                  Shape.mModelVertexCount, Target, maxError - Error, Current[r]);
+
+                GXOptimizeVertexCache(Current[r].data(), Current[r].size(), Shape.mFirstModelVertex, Shape.mModelVertexCount);
+
+                CurrentCount += Current[r].size();
+                LevelError = std::max(LevelError, RangeError);
+            }
+
+            // Errors of successive levels stack, since each is simplified from the last.
+            float TotalError = Error + LevelError;
+
+            if (CurrentCount == 0 || CurrentCount > PreviousCount * 19 / 20 || TotalError > maxError)
+                break;
+
+            GXShapeLod Lod;
+            Lod.IndexCount = static_cast<uint32_t>(CurrentCount);
+            Lod.Error = TotalError * Scale;
+
+            std::vector<uint32_t> Indices;
+            Indices.reserve(CurrentCount);
+            for (size_t r = 0; r < Ranges.size(); r++) {
+                if (!Shape.mDraws.empty()) {
+                    // Carry the palette of the draw this range came from.
+                    for (const GXShapeDraw& Draw : Shape.mDraws) {
+                        if (Draw.Type != EGXPrimitiveType::Triangles || Draw.FirstIndex != Ranges[r].first)
+                            continue;
+
+                        GXShapeDraw LodDraw = Draw;
+                        LodDraw.FirstIndex = static_cast<uint32_t>(Indices.size());
+                        LodDraw.IndexCount = static_cast<uint32_t>(Current[r].size());
+                        Lod.Draws.push_back(std::move(LodDraw));
+                        break;
+                    }
+                }
+
+                Indices.insert(Indices.end(), Current[r].begin(), Current[r].end());
+            }
+
+            Out.Lods.push_back(std::move(Lod));
+            Out.Indices.push_back(std::move(Indices));
+
+            Error = TotalError;
+            Previous = std::move(Current);
+            PreviousCount = CurrentCount;
+        }
+    });
+
+    mModelLodIndices.clear();
+    for (size_t s = 0; s < mShapes.size(); s++) {
+        GXShape& Shape = *mShapes[s];
+        Shape.mLods = std::move(Built[s].Lods);
+
+        for (size_t l = 0; l < Shape.mLods.size(); l++) {
+            GXShapeLod& Lod = Shape.mLods[l];
+            Lod.FirstIndex = static_cast<uint32_t>(mModelLodIndices.size());
+
+            for (GXShapeDraw& Draw : Lod.Draws) {
+                Draw.FirstIndex += Lod.FirstIndex;
+            }
+
+            mModelLodIndices.insert(mModelLodIndices.end(), Built[s].Indices[l].begin(), Built[s].Indices[l].end());
+        }
+    }
+}
+
+void GXGeometry::GenerateTangentFrames(uint32_t texCoordIndex, uint32_t threadCount) {
+    if (texCoordIndex >= 8)
+        throw std::invalid_argument("Tex coord index must be less than 8");
+
+    // A shape's tangent frames, followed by those of the vertices split off at its mirrored seams.
+    struct ShapeTangents {
+        std::vector<glm::vec4> Frames;
+        std::vector<uint32_t> SplitVertices;
+    };
+
+    std::vector<ShapeTangents> Generated(mShapes.size());
+
+    // Indices of split vertices point just past their shape's range until the vertex list is laid out again below.
+    ParallelFor(mShapes.size(), threadCount, [&](size_t s) {
+        const GXShape& Shape = *mShapes[s];
+        uint32_t* Indices = mModelIndices.data() + Shape.mFirstVertexOffset;
+
+        const std::vector<EGXAttribute>& Table = Shape.GetAttributeTable();
+        bool bHasNormals = std::find(Table.begin(), Table.end(), EGXAttribute::Normal) != Table.end() ||
+                           std::find(Table.begin(), Table.end(), EGXAttribute::NBT) != Table.end();
+
+        if (!bHasNormals)
+            GXGenerateSmoothNormals(mModelVertices.data(), Indices, Shape.mVertexCount, Shape.mFirstModelVertex, Shape.mModelVertexCount);
+
+        GXGenerateTangentFrames(mModelVertices.data(), Indices, Shape.mVertexCount, Shape.mFirstModelVertex, Shape.mModelVertexCount,
+                                Generated[s].Frames, Generated[s].SplitVertices, texCoordIndex);
+    });
+
+    // Grow each shape's vertex range by its split vertices, keeping data outside of the shapes in its place.
+    std::vector<std::pair<uint32_t, uint32_t>> Ranges(mShapes.size());
+    std::vector<uint32_t> NewCounts(mShapes.size());
+    std::vector<uint32_t> NewOffsets;
+    std::vector<ListGap> Gaps;
+    size_t SplitCount = 0;
+
+    for (size_t s = 0; s < mShapes.size(); s++) {
+        Ranges[s] = { mShapes[s]->mFirstModelVertex, mShapes[s]->mModelVertexCount };
+        NewCounts[s] = static_cast<uint32_t>(Generated[s].Frames.size());
+        SplitCount += Generated[s].SplitVertices.size();
+    }
+
+    const size_t VertexCount = LayOutShapeRanges(mModelVertices.size(), Ranges, NewCounts, NewOffsets, Gaps);
+
+    // Where every old vertex ends up. Split vertices keep their original in place, so nothing else needs to know of them.
+    std::vector<uint32_t> Remap(mModelVertices.size());
+    std::vector<ModernVertex> Vertices(VertexCount);
+    std::vector<glm::vec4> TangentFrames(VertexCount, glm::vec4(0.0f));
+
+    for (const ListGap& Gap : Gaps) {
+        std::copy(mModelVertices.begin() + Gap.Source, mModelVertices.begin() + Gap.Source + Gap.Count, Vertices.begin() + Gap.Target);
+        std::iota(Remap.begin() + Gap.Source, Remap.begin() + Gap.Source + Gap.Count, Gap.Target);
+    }
+
+    ParallelFor(mShapes.size(), threadCount, [&](size_t s) {
+        GXShape& Shape = *mShapes[s];
+        ShapeTangents& In = Generated[s];
+        const uint32_t OldFirst = Shape.mFirstModelVertex;
+
+        std::copy(mModelVertices.begin() + OldFirst, mModelVertices.begin() + OldFirst + Shape.mModelVertexCount, Vertices.begin() + NewOffsets[s]);
+        for (size_t k = 0; k < In.SplitVertices.size(); k++) {
+            Vertices[NewOffsets[s] + Shape.mModelVertexCount + k] = mModelVertices[In.SplitVertices[k]];
+        }
+
+        std::copy(In.Frames.begin(), In.Frames.end(), TangentFrames.begin() + NewOffsets[s]);
+        std::iota(Remap.begin() + OldFirst, Remap.begin() + OldFirst + Shape.mModelVertexCount, NewOffsets[s]);
+
+        // The shape's triangles may use its split vertices, which only a rebase finds.
+        uint32_t* Indices = mModelIndices.data() + Shape.mFirstVertexOffset;
+        for (uint32_t i = 0; i < Shape.mVertexCount; i++) {
+            Indices[i] = NewOffsets[s] + (Indices[i] - OldFirst);
+        }
+
+        Shape.mFirstModelVertex = NewOffsets[s];
+        Shape.mModelVertexCount = NewCounts[s];
+        In = ShapeTangents();
+    });
+
+    mModelVertices = std::move(Vertices);
+    mModelTangentFrames = std::move(TangentFrames);
+
+    for (auto& Entry : mVertexWeldMap) {
+        Entry.second = Remap[Entry.second];
+    }
+
+    // Triangles outside of every shape, and all lines and points, only use original vertices.
+    for (size_t s = 0; s < mShapes.size(); s++) {
+        Ranges[s] = { mShapes[s]->mFirstVertexOffset, mShapes[s]->mVertexCount };
+        NewCounts[s] = mShapes[s]->mVertexCount;
+    }
+
+    LayOutShapeRanges(mModelIndices.size(), Ranges, NewCounts, NewOffsets, Gaps);
+    for (const ListGap& Gap : Gaps) {
+        for (uint32_t i = 0; i < Gap.Count; i++) {
+            mModelIndices[Gap.Source + i] = Remap[mModelIndices[Gap.Source + i]];
+        }
+    }
+
+    for (std::vector<uint32_t>* Indices : { &mModelLineIndices, &mModelPointIndices }) {
+        for (uint32_t& Index : *Indices) {
+            Index = Remap[Index];
+        }
+    }
+
+    // Meshlets and levels of detail don't know which side of a seam their triangles are on. Without any splits,
+    // no vertex moved and they stay valid.
+    if (SplitCount > 0) {
+        mModelMeshlets.Clear();
+        mModelLodIndices.clear();
+        for (std::shared_ptr<GXShape>& Shape : mShapes) {
+            Shape->mFirstMeshlet = 0;
+            Shape->mMeshletCount = 0;
+            Shape->mLods.clear();
+        }
+    }
+
+    RefreshVertexBuffers();
+}
+
+void GXGeometry::RemapModelVertices(const std::vector<uint32_t>& remap, uint32_t threadCount) {
+    if (remap.size() != mModelVertices.size())
+        throw std::invalid_argument("Vertex remap must have one entry per model vertex!");
+
+    ParallelFor(mShapes.size(), threadCount, [&](size_t s) {
+        const GXShape& Shape = *mShapes[s];
+
+        // Shapes own disjoint vertex ranges, so each one can be permuted through its own scratch copy.
+        std::vector<ModernVertex> ShapeVertices(mModelVertices.begin() + Shape.mFirstModelVertex,
+                                                mModelVertices.begin() + Shape.mFirstModelVertex + Shape.mModelVertexCount);
+        for (uint32_t i = 0; i < Shape.mModelVertexCount; i++) {
+            mModelVertices[remap[Shape.mFirstModelVertex + i]] = ShapeVertices[i];
+        }
+
+        if (mModelTangentFrames.empty())
+            return;
+
+        std::vector<glm::vec4> ShapeFrames(mModelTangentFrames.begin() + Shape.mFirstModelVertex,
+                                           mModelTangentFrames.begin() + Shape.mFirstModelVertex + Shape.mModelVertexCount);
+        for (uint32_t i = 0; i < Shape.mModelVertexCount; i++) {
+            mModelTangentFrames[remap[Shape.mFirstModelVertex + i]] = ShapeFrames[i];
+        }
+    });
+
+    for (std::vector<uint32_t>* Indices : { &mModelIndices, &mModelLineIndices, &mModelPointIndices, &mModelLodIndices, &mModelMeshlets.Vertices }) {
+        for (uint32_t& Index : *Indices) {
+            Index = remap[Index];
+        }
+    }
+}
+
+void GXGeometry::RefreshVertexBuffers() {
+    if (!mCompactVertices.empty())
+        BuildCompactVertices();
+    if (!mQuantizedVertices.empty())
+        BuildQuantizedVertices();
+
+    const GXAttributeData& Streams = mModelStreams;
+    bool bHasStreams = !Streams.GetPositions().empty() || !Streams.GetPositionMatrixIndices().empty() || !Streams.GetNormals().empty();
+    for (uint32_t c = 0; c < 2; c++) {
+        bHasStreams |= !Streams.GetColors(c).empty();
+    }
+    for (uint32_t t = 0; t < 8; t++) {
+        bHasStreams |= !Streams.GetTexCoords(t).empty();
+    }
+
+    if (bHasStreams)
+        BuildVertexStreams();
 }
@@ -0,0 +1,382 @@
+#include "geometry/GXMeshOptimizer.hpp"
+#include "glm/geometric.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+GXVertexCacheStats GXAnalyzeVertexCache(const uint32_t* indices, size_t indexCount, uint32_t cacheSize) {
+    GXVertexCacheStats stats;
+    stats.TriangleCount = indexCount / 3;
+
+    // A FIFO cache only needs to know when each vertex was last transformed.
+    std::vector<uint32_t> fifo(cacheSize, UINT32_MAX);
+    size_t head = 0;
+
+    for (size_t i = 0; i < stats.TriangleCount * 3; i++) {
+        if (std::find(fifo.begin(), fifo.end(), indices[i]) != fifo.end())
+            continue;
+
+        if (cacheSize != 0) {
+            fifo[head] = indices[i];
+            head = (head + 1) % cacheSize;
+        }
+
+        stats.TransformedVertices++;
+    }
+
+    return stats;
+}
+
+namespace {
+    // The tuning values from Forsyth's paper.
+    const uint32_t kCacheSize = 32;
+    const float kCacheDecayPower = 1.5f;
+    const float kLastTriangleScore = 0.75f;
+    const float kValenceBoostScale = 2.0f;
+    const float kValenceBoostPower = 0.5f;
+    const uint32_t kMaxValence = 64;
+
+    // Precomputed vertex scores by cache position and by remaining valence.
+    struct ScoreTables {
+        float Cache[kCacheSize];
+        float Valence[kMaxValence + 1];
+
+        ScoreTables() {
+            for (uint32_t i = 0; i < kCacheSize; i++) {
+                if (i < 3) {
+                    // The vertices of the last triangle are in the cache no matter what, so don't favour
+                    // them so much that the optimizer only walks along strips.
+                    Cache[i] = kLastTriangleScore;
+                }
+                else {
+                    const float scaler = 1.0f / (kCacheSize - 3);
+                    Cache[i] = std::pow(1.0f - (i - 3) * scaler, kCacheDecayPower);
+                }
+            }
+
+            Valence[0] = 0.0f;
+            for (uint32_t i = 1; i <= kMaxValence; i++) {
+                // Favour vertices with few triangles left, so that lone triangles don't get left behind.
+                Valence[i] = kValenceBoostScale * std::pow(static_cast<float>(i), -kValenceBoostPower);
+            }
+        }
+    };
+
+    const ScoreTables& GetScoreTables() {
+        static const ScoreTables tables;
+        return tables;
+    }
+
+    float GetVertexScore(int32_t cachePosition, uint32_t remainingValence) {
+        if (remainingValence == 0)
+            return -1.0f;
+
+        const ScoreTables& tables = GetScoreTables();
+
+        float score = cachePosition >= 0 ? tables.Cache[cachePosition] : 0.0f;
+        return score + tables.Valence[std::min(remainingValence, kMaxValence)];
+    }
+}
+
+void GXOptimizeVertexCache(uint32_t* indices, size_t indexCount, uint32_t firstVertex, uint32_t vertexCount) {
+    const size_t triangleCount = indexCount / 3;
+    if (triangleCount < 2)
+        return;
+
+    // Work on vertex numbers relative to the start of the range.
+    std::vector<uint32_t> local(triangleCount * 3);
+    for (size_t i = 0; i < local.size(); i++) {
+        if (indices[i] < firstVertex || indices[i] - firstVertex >= vertexCount)
+            throw std::out_of_range("Index list references a vertex outside of the given range!");
+
+        local[i] = indices[i] - firstVertex;
+    }
+
+    // Build the list of triangles that use each vertex.
+    std::vector<uint32_t> valence(vertexCount, 0);
+    for (uint32_t v : local) {
+        valence[v]++;
+    }
+
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+    for (uint32_t v = 0; v < vertexCount; v++) {
+        adjacencyOffsets[v + 1] = adjacencyOffsets[v] + valence[v];
+    }
+
+    std::vector<uint32_t> adjacency(local.size());
+    std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    for (size_t t = 0; t < triangleCount; t++) {
+        for (int c = 0; c < 3; c++) {
+            adjacency[fill[local[t * 3 + c]]++] = static_cast<uint32_t>(t);
+        }
+    }
+
+    // Valence now counts the triangles of each vertex that have not been emitted yet, and the first
+    // valence[v] entries of a vertex's adjacency list are those triangles.
+    std::vector<int32_t> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScore(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; v++) {
+        vertexScore[v] = GetVertexScore(-1, valence[v]);
+    }
+
+    std::vector<bool> emitted(triangleCount, false);
+
+    std::vector<uint32_t> cache;
+    std::vector<uint32_t> newCache;
+    cache.reserve(kCacheSize + 3);
+    newCache.reserve(kCacheSize + 3);
+
+    size_t emittedCount = 0;
+    size_t cursor = 0;
+    size_t best = SIZE_MAX;
+
+    while (emittedCount < triangleCount) {
+        // When no triangle touching the cache is left, carry on with the next triangle in the original order.
+        if (best == SIZE_MAX) {
+            while (emitted[cursor]) {
+                cursor++;
+            }
+
+            best = cursor;
+        }
+
+        const uint32_t* tri = &local[best * 3];
+        for (int c = 0; c < 3; c++) {
+            indices[emittedCount * 3 + c] = tri[c] + firstVertex;
+        }
+
+        emitted[best] = true;
+        emittedCount++;
+
+        // Remove the triangle from its vertices' lists of remaining triangles.
+        for (int c = 0; c < 3; c++) {
+            uint32_t v = tri[c];
+            uint32_t* list = &adjacency[adjacencyOffsets[v]];
+
+            for (uint32_t i = 0; i < valence[v]; i++) {
+                if (list[i] == best) {
+                    std::swap(list[i], list[valence[v] - 1]);
+                    valence[v]--;
+                    break;
+                }
+            }
+        }
+
+        // Move the triangle's vertices to the front of the cache, pushing everything else back.
+        newCache.clear();
+        newCache.insert(newCache.end(), tri, tri + 3);
+        for (uint32_t v : cache) {
+            if (v != tri[0] && v != tri[1] && v != tri[2])
+                newCache.push_back(v);
+        }
+
+        for (size_t i = kCacheSize; i < newCache.size(); i++) {
+            cachePosition[newCache[i]] = -1;
+            vertexScore[newCache[i]] = GetVertexScore(-1, valence[newCache[i]]);
+        }
+
+        if (newCache.size() > kCacheSize)
+            newCache.resize(kCacheSize);
+
+        std::swap(cache, newCache);
+
+        for (size_t i = 0; i < cache.size(); i++) {
+            cachePosition[cache[i]] = static_cast<int32_t>(i);
+            vertexScore[cache[i]] = GetVertexScore(static_cast<int32_t>(i), valence[cache[i]]);
+        }
+
+        // Rescore the triangles touching the cache and pick the best one to emit next.
+        best = SIZE_MAX;
+        float bestScore = -1.0f;
+
+        for (uint32_t v : cache) {
+            for (uint32_t a = 0; a < valence[v]; a++) {
+                uint32_t t = adjacency[adjacencyOffsets[v] + a];
+                float score = vertexScore[local[t * 3]] + vertexScore[local[t * 3 + 1]] + vertexScore[local[t * 3 + 2]];
+
+                if (score > bestScore) {
+                    bestScore = score;
+                    best = t;
+                }
+            }
+        }
+    }
+}
+
+namespace {
+    // A FIFO cache simulated with per-vertex timestamps: a vertex is cached if it was transformed
+    // fewer than cacheSize misses ago.
+    class FifoCacheSimulator {
+        std::vector<uint32_t> mTimestamps;
+        uint32_t mCacheSize;
+        uint32_t mTime;
+
+    public:
+        FifoCacheSimulator(uint32_t vertexCount, uint32_t cacheSize)
+            : mTimestamps(vertexCount, 0), mCacheSize(cacheSize), mTime(cacheSize + 1) {}
+
+        // Empties the cache.
+        void Reset() { mTime += mCacheSize + 1; }
+
+        // Runs the given triangle through the cache and returns how many of its vertices missed.
+        uint32_t AddTriangle(const uint32_t* triangle) {
+            uint32_t misses = 0;
+
+            for (int c = 0; c < 3; c++) {
+                if (mTime - mTimestamps[triangle[c]] > mCacheSize) {
+                    mTimestamps[triangle[c]] = mTime++;
+                    misses++;
+                }
+            }
+
+            return misses;
+        }
+    };
+
+    // Splits the triangle range [start, end) into the smallest clusters whose cache miss ratio, each starting
+    // on an empty cache, stays within the given threshold. The start of each cluster is appended to clusters.
+    void SplitSoftClusters(const uint32_t* local, size_t start, size_t end, float threshold, FifoCacheSimulator& cache,
+                           std::vector<size_t>& clusters) {
+        cache.Reset();
+
+        uint32_t rangeMisses = 0;
+        for (size_t t = start; t < end; t++) {
+            rangeMisses += cache.AddTriangle(&local[t * 3]);
+        }
+
+        const float maxRatio = threshold * rangeMisses / (end - start);
+
+        cache.Reset();
+        clusters.push_back(start);
+
+        size_t clusterStart = start;
+        uint32_t clusterMisses = 0;
+
+        for (size_t t = start; t < end; t++) {
+            clusterMisses += cache.AddTriangle(&local[t * 3]);
+
+            if (t + 1 < end && static_cast<float>(clusterMisses) / (t + 1 - clusterStart) <= maxRatio) {
+                clusters.push_back(t + 1);
+                clusterStart = t + 1;
+                clusterMisses = 0;
+                cache.Reset();
+            }
+        }
+
+        // A short last cluster may not have settled under the threshold yet, so fold it into the one before.
+        if (clusterStart != start && static_cast<float>(clusterMisses) / (end - clusterStart) > maxRatio)
+            clusters.pop_back();
+    }
+}
+
+void GXOptimizeOverdraw(uint32_t* indices, size_t indexCount, const ModernVertex* vertices, uint32_t firstVertex, uint32_t vertexCount,
+                        float threshold, uint32_t cacheSize) {
+    if (threshold < 1.0f)
+        throw std::invalid_argument("Overdraw threshold must be at least 1!");
+
+    const size_t triangleCount = indexCount / 3;
+    if (triangleCount < 2)
+        return;
+
+    std::vector<uint32_t> local(triangleCount * 3);
+    for (size_t i = 0; i < local.size(); i++) {
+        if (indices[i] < firstVertex || indices[i] - firstVertex >= vertexCount)
+            throw std::out_of_range("Index list references a vertex outside of the given range!");
+
+        local[i] = indices[i] - firstVertex;
+    }
+
+    // Hard boundaries are where the cache ran dry on its own, so the order can change there for free.
+    FifoCacheSimulator cache(vertexCount, cacheSize);
+    std::vector<size_t> hardClusters;
+
+    for (size_t t = 0; t < triangleCount; t++) {
+        if (cache.AddTriangle(&local[t * 3]) == 3)
+            hardClusters.push_back(t);
+    }
+
+    if (hardClusters.empty() || hardClusters[0] != 0)
+        hardClusters.insert(hardClusters.begin(), 0);
+    hardClusters.push_back(triangleCount);
+
+    std::vector<size_t> clusters;
+    for (size_t i = 0; i + 1 < hardClusters.size(); i++) {
+        SplitSoftClusters(local.data(), hardClusters[i], hardClusters[i + 1], threshold, cache, clusters);
+    }
+    clusters.push_back(triangleCount);
+
+    const ModernVertex* range = vertices + firstVertex;
+
+    glm::vec3 meshCentroid(0.0f);
+    for (uint32_t v = 0; v < vertexCount; v++) {
+        meshCentroid += glm::vec3(range[v].Position);
+    }
+    meshCentroid /= static_cast<float>(vertexCount);
+
+    // Sort clusters by how far their area-weighted centroid sits out along their average normal.
+    const size_t clusterCount = clusters.size() - 1;
+    std::vector<float> sortKeys(clusterCount);
+
+    for (size_t c = 0; c < clusterCount; c++) {
+        glm::vec3 centroid(0.0f);
+        glm::vec3 normal(0.0f);
+        float area = 0.0f;
+
+        for (size_t t = clusters[c]; t < clusters[c + 1]; t++) {
+            glm::vec3 p0(range[local[t * 3]].Position);
+            glm::vec3 p1(range[local[t * 3 + 1]].Position);
+            glm::vec3 p2(range[local[t * 3 + 2]].Position);
+
+            glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+            float a = glm::length(n);
+
+            centroid += (p0 + p1 + p2) * (a / 3.0f);
+            normal += n;
+            area += a;
+        }
+
+        if (area > 0.0f)
+            centroid /= area;
+
+        float normalLength = glm::length(normal);
+        if (normalLength > 0.0f)
+            normal /= normalLength;
+
+        sortKeys[c] = glm::dot(centroid - meshCentroid, normal);
+    }
+
+    std::vector<size_t> order(clusterCount);
+    for (size_t c = 0; c < clusterCount; c++) {
+        order[c] = c;
+    }
+
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return sortKeys[a] > sortKeys[b]; });
+
+    size_t out = 0;
+    for (size_t c : order) {
+        for (size_t i = clusters[c] * 3; i < clusters[c + 1] * 3; i++) {
+            indices[out++] = local[i] + firstVertex;
+        }
+    }
+}
+
+void GXBuildVertexFetchRemap(const uint32_t* indices, size_t indexCount, uint32_t firstVertex, uint32_t vertexCount, uint32_t* remap) {
+    std::fill(remap, remap + vertexCount, UINT32_MAX);
+
+    uint32_t next = firstVertex;
+    for (size_t i = 0; i < indexCount; i++) {
+        uint32_t v = indices[i] - firstVertex;
+        if (indices[i] < firstVertex || v >= vertexCount)
+            throw std::out_of_range("Index is outside of the vertex range being remapped!");
+
+        if (remap[v] == UINT32_MAX)
+            remap[v] = next++;
+    }
+
+    for (uint32_t v = 0; v < vertexCount; v++) {
+        if (remap[v] == UINT32_MAX)
+            remap[v] = next++;
+    }
+}
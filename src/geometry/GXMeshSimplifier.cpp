@@ -0,0 +1,636 @@
+#include "geometry/GXMeshSimplifier.hpp"
+#include "glm/geometric.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <tuple>
+#include <unordered_map>
+
+// The number of attribute components that the simplifier keeps track of: tex coord 0's u and v, and color 0's rgba.
+static const int ATTRIBUTE_COUNT = 6;
+// How much each attribute component counts against the geometric error.
+static const float ATTRIBUTE_WEIGHTS[ATTRIBUTE_COUNT] = { 1.0f, 1.0f, 0.5f, 0.5f, 0.5f, 0.5f };
+// How much more the planes along open borders count than the planes of the triangles themselves.
+static const float BORDER_WEIGHT = 2.0f;
+
+namespace {
+    // The sum of squared distances to a set of weighted planes, as a symmetric matrix A, vector b and constant c,
+    // so that the error at p is p'Ap + 2b'p + c.
+    struct Quadric {
+        float A00, A11, A22, A10, A20, A21;
+        float B0, B1, B2;
+        float C;
+        // The total weight of the planes.
+        float W;
+    };
+
+    // A quadric of the squared error between each attribute and its linear interpolation across a set of weighted
+    // triangles. G and D hold the sums of each attribute's weighted gradients and offsets.
+    struct AttributeQuadric {
+        Quadric Q;
+        glm::vec3 G[ATTRIBUTE_COUNT];
+        float D[ATTRIBUTE_COUNT];
+    };
+
+    // How a position may move, from the topology around it.
+    enum class EVertexKind : uint8_t {
+        // Inside the surface, with one set of attributes. Can collapse onto any neighbour.
+        Manifold,
+        // On an open border, with one set of attributes. Can only collapse along the border.
+        Border,
+        // On an attribute seam, with two sets of attributes. Can only collapse along the seam.
+        Seam,
+        // Anything else. Never moves.
+        Locked
+    };
+
+    // One side of a triangle edge, keyed by the edge's positions.
+    struct EdgeRecord {
+        // The position ids of the edge's endpoints, with First < Second.
+        uint32_t First;
+        uint32_t Second;
+        // The vertices the triangle uses at First and Second.
+        uint32_t FirstVertex;
+        uint32_t SecondVertex;
+        // Whether the triangle runs from First to Second.
+        bool bForward;
+    };
+
+    // A possible edge collapse, moving every vertex at the source position onto the target position.
+    struct Collapse {
+        uint32_t Source;
+        uint32_t Target;
+        // The vertices at the target that the source's vertices move to, in the order of the source's wedge list.
+        uint32_t Wedges[2];
+        float Cost;
+        float GeometricError;
+        // Whether the edge lies on an open border, so collapsing it only removes one triangle.
+        bool bBorder;
+    };
+}
+
+static void AddQuadric(Quadric& q, const Quadric& r) {
+    q.A00 += r.A00; q.A11 += r.A11; q.A22 += r.A22;
+    q.A10 += r.A10; q.A20 += r.A20; q.A21 += r.A21;
+    q.B0 += r.B0; q.B1 += r.B1; q.B2 += r.B2;
+    q.C += r.C;
+    q.W += r.W;
+}
+
+static void AddAttributeQuadric(AttributeQuadric& q, const AttributeQuadric& r) {
+    AddQuadric(q.Q, r.Q);
+
+    for (int k = 0; k < ATTRIBUTE_COUNT; k++) {
+        q.G[k] += r.G[k];
+        q.D[k] += r.D[k];
+    }
+}
+
+// Returns the quadric of the plane n.p + d = 0 with the given weight. n must be unit length.
+static Quadric QuadricFromPlane(const glm::vec3& n, float d, float weight) {
+    Quadric q;
+    q.A00 = weight * n.x * n.x; q.A11 = weight * n.y * n.y; q.A22 = weight * n.z * n.z;
+    q.A10 = weight * n.y * n.x; q.A20 = weight * n.z * n.x; q.A21 = weight * n.z * n.y;
+    q.B0 = weight * n.x * d; q.B1 = weight * n.y * d; q.B2 = weight * n.z * d;
+    q.C = weight * d * d;
+    q.W = weight;
+    return q;
+}
+
+// Returns the error of the quadric at p, unnormalized by its weight.
+static float QuadricError(const Quadric& q, const glm::vec3& p) {
+    float rx = q.A00 * p.x + q.A10 * p.y + q.A20 * p.z + q.B0;
+    float ry = q.A10 * p.x + q.A11 * p.y + q.A21 * p.z + q.B1;
+    float rz = q.A20 * p.x + q.A21 * p.y + q.A22 * p.z + q.B2;
+
+    float error = p.x * rx + p.y * ry + p.z * rz + q.B0 * p.x + q.B1 * p.y + q.B2 * p.z + q.C;
+    return std::fabs(error);
+}
+
+// Returns the error of the attribute quadric for a vertex at p with the given attributes, unnormalized by its weight.
+static float AttributeQuadricError(const AttributeQuadric& q, const glm::vec3& p, const float* attributes) {
+    float error = QuadricError(q.Q, p);
+
+    for (int k = 0; k < ATTRIBUTE_COUNT; k++) {
+        const float a = attributes[k];
+        error += q.Q.W * a * a - 2.0f * a * (glm::dot(q.G[k], p) + q.D[k]);
+    }
+
+    return std::fabs(error);
+}
+
+// Returns the attribute quadric of a triangle, from its positions and the attributes at each corner.
+static AttributeQuadric AttributeQuadricFromTriangle(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2,
+                                                     const float* a0, const float* a1, const float* a2, float weight) {
+    AttributeQuadric q;
+    std::memset(&q, 0, sizeof(q));
+    q.Q.W = weight;
+
+    // Solve for the gradient in the plane of the triangle that reproduces the attribute at all three corners.
+    glm::vec3 p10 = p1 - p0;
+    glm::vec3 p20 = p2 - p0;
+    float d00 = glm::dot(p10, p10);
+    float d01 = glm::dot(p10, p20);
+    float d11 = glm::dot(p20, p20);
+    float denom = d00 * d11 - d01 * d01;
+    float invDenom = denom != 0.0f ? 1.0f / denom : 0.0f;
+
+    glm::vec3 gradient1 = (p10 * d11 - p20 * d01) * invDenom;
+    glm::vec3 gradient2 = (p20 * d00 - p10 * d01) * invDenom;
+
+    for (int k = 0; k < ATTRIBUTE_COUNT; k++) {
+        glm::vec3 g = gradient1 * (a1[k] - a0[k]) + gradient2 * (a2[k] - a0[k]);
+        float d = a0[k] - glm::dot(p0, g);
+
+        q.Q.A00 += weight * g.x * g.x; q.Q.A11 += weight * g.y * g.y; q.Q.A22 += weight * g.z * g.z;
+        q.Q.A10 += weight * g.y * g.x; q.Q.A20 += weight * g.z * g.x; q.Q.A21 += weight * g.z * g.y;
+        q.Q.B0 += weight * g.x * d; q.Q.B1 += weight * g.y * d; q.Q.B2 += weight * g.z * d;
+        q.Q.C += weight * d * d;
+
+        q.G[k] = g * weight;
+        q.D[k] = d * weight;
+    }
+
+    return q;
+}
+
+float GXGetSimplifyScale(const ModernVertex* vertices, uint32_t firstVertex, uint32_t vertexCount) {
+    if (vertexCount == 0)
+        return 0.0f;
+
+    glm::vec3 min(vertices[firstVertex].Position);
+    glm::vec3 max(vertices[firstVertex].Position);
+
+    for (uint32_t v = firstVertex + 1; v < firstVertex + vertexCount; v++) {
+        min = glm::min(min, glm::vec3(vertices[v].Position));
+        max = glm::max(max, glm::vec3(vertices[v].Position));
+    }
+
+    glm::vec3 extent = max - min;
+    return std::max(extent.x, std::max(extent.y, extent.z));
+}
+
+float GXSimplifyMesh(const uint32_t* indices, size_t indexCount, const ModernVertex* vertices, uint32_t firstVertex, uint32_t vertexCount,
+                     size_t targetIndexCount, float targetError, std::vector<uint32_t>& output) {
+    // Work on indices relative to the vertex range, and on positions scaled to fit in a unit cube.
+    // Bit-identical vertices are one and the same wedge, so unwelded input is welded here: otherwise every
+    // triangle would see its own copy of each corner, and nearly every position would look like a seam.
+    std::unordered_map<ModernVertex, uint32_t, ModernVertexHash, ModernVertexBitwiseEqual> weldMap;
+    weldMap.reserve(vertexCount);
+
+    std::vector<uint32_t> weldRemap(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; v++) {
+        weldRemap[v] = weldMap.emplace(vertices[firstVertex + v], v).first->second;
+    }
+
+    std::vector<uint32_t> triangles(indices, indices + indexCount / 3 * 3);
+    for (uint32_t& index : triangles) {
+        index = weldRemap[index - firstVertex];
+    }
+
+    float scale = GXGetSimplifyScale(vertices, firstVertex, vertexCount);
+    float invScale = scale > 0.0f ? 1.0f / scale : 1.0f;
+
+    std::vector<glm::vec3> positions(vertexCount);
+    std::vector<float> attributes(static_cast<size_t>(vertexCount) * ATTRIBUTE_COUNT);
+    for (uint32_t v = 0; v < vertexCount; v++) {
+        const ModernVertex& vertex = vertices[firstVertex + v];
+        positions[v] = (glm::vec3(vertex.Position) - glm::vec3(vertices[firstVertex].Position)) * invScale;
+
+        const float values[ATTRIBUTE_COUNT] = { vertex.TexCoords[0].x, vertex.TexCoords[0].y,
+                                                vertex.Colors[0].r, vertex.Colors[0].g, vertex.Colors[0].b, vertex.Colors[0].a };
+        for (int k = 0; k < ATTRIBUTE_COUNT; k++) {
+            attributes[static_cast<size_t>(v) * ATTRIBUTE_COUNT + k] = values[k] * ATTRIBUTE_WEIGHTS[k];
+        }
+    }
+
+    // Give every vertex the id of the first vertex sharing its position, and link the vertices sharing a position
+    // into a circular wedge list. Positions are compared bitwise, which keeps the sort well-defined for any input.
+    auto PositionKey = [&](uint32_t v) {
+        uint32_t key[3];
+        std::memcpy(key, &vertices[firstVertex + v].Position, sizeof(key));
+        return std::make_tuple(key[0], key[1], key[2], v);
+    };
+
+    std::vector<uint32_t> order(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; v++) {
+        order[v] = v;
+    }
+
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return PositionKey(a) < PositionKey(b);
+    });
+
+    std::vector<uint32_t> positionIds(vertexCount);
+    std::vector<uint32_t> wedges(vertexCount);
+    for (uint32_t i = 0; i < vertexCount; i++) {
+        bool bSamePosition = i > 0 && std::memcmp(&vertices[firstVertex + order[i]].Position, &vertices[firstVertex + order[i - 1]].Position,
+                                                  sizeof(float) * 3) == 0;
+
+        positionIds[order[i]] = bSamePosition ? positionIds[order[i - 1]] : order[i];
+        wedges[order[i]] = order[i];
+
+        if (bSamePosition) {
+            // Splice the vertex into its position's list, right after the first vertex.
+            uint32_t first = positionIds[order[i]];
+            wedges[order[i]] = wedges[first];
+            wedges[first] = order[i];
+        }
+    }
+
+    // Triangles with two corners at the same position have no surface to preserve, and would block the collapses around them.
+    size_t kept = 0;
+    for (size_t t = 0; t < triangles.size() / 3; t++) {
+        uint32_t a = triangles[t * 3 + 0];
+        uint32_t b = triangles[t * 3 + 1];
+        uint32_t c = triangles[t * 3 + 2];
+
+        if (positionIds[a] == positionIds[b] || positionIds[b] == positionIds[c] || positionIds[c] == positionIds[a])
+            continue;
+
+        triangles[kept++] = a;
+        triangles[kept++] = b;
+        triangles[kept++] = c;
+    }
+
+    triangles.resize(kept);
+
+    std::vector<uint8_t> used(vertexCount);
+    std::vector<EdgeRecord> edges;
+    std::vector<uint32_t> triangleOffsets(vertexCount + 1);
+    std::vector<uint32_t> positionTriangles;
+
+    // Gathers the edges of the current triangles, grouped by their endpoints' positions, and rebuilds the list of
+    // triangles around each position.
+    auto BuildAdjacency = [&]() {
+        const size_t triangleCount = triangles.size() / 3;
+
+        std::fill(used.begin(), used.end(), 0);
+        edges.clear();
+        edges.reserve(triangles.size());
+
+        std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0);
+
+        for (size_t t = 0; t < triangleCount; t++) {
+            for (int c = 0; c < 3; c++) {
+                uint32_t v0 = triangles[t * 3 + c];
+                uint32_t v1 = triangles[t * 3 + (c + 1) % 3];
+                uint32_t p0 = positionIds[v0];
+                uint32_t p1 = positionIds[v1];
+
+                used[v0] = 1;
+                triangleOffsets[p0 + 1]++;
+
+                if (p0 < p1)
+                    edges.push_back({ p0, p1, v0, v1, true });
+                else
+                    edges.push_back({ p1, p0, v1, v0, false });
+            }
+        }
+
+        std::sort(edges.begin(), edges.end(), [](const EdgeRecord& a, const EdgeRecord& b) {
+            return std::tie(a.First, a.Second, a.FirstVertex, a.SecondVertex, a.bForward) <
+                   std::tie(b.First, b.Second, b.FirstVertex, b.SecondVertex, b.bForward);
+        });
+
+        for (uint32_t p = 0; p < vertexCount; p++) {
+            triangleOffsets[p + 1] += triangleOffsets[p];
+        }
+
+        positionTriangles.resize(triangleOffsets[vertexCount]);
+        std::vector<uint32_t> cursor(triangleOffsets.begin(), triangleOffsets.end() - 1);
+        for (size_t t = 0; t < triangleCount; t++) {
+            for (int c = 0; c < 3; c++) {
+                positionTriangles[cursor[positionIds[triangles[t * 3 + c]]]++] = static_cast<uint32_t>(t);
+            }
+        }
+    };
+
+    // Whether the group of edge records describes an open border edge, an attribute seam, or topology too complicated to collapse.
+    auto IsBorder = [](const EdgeRecord*, size_t count) { return count == 1; };
+    auto IsSeam = [](const EdgeRecord* group, size_t count) {
+        return count == 2 && group[0].bForward != group[1].bForward &&
+               (group[0].FirstVertex != group[1].FirstVertex || group[0].SecondVertex != group[1].SecondVertex);
+    };
+    auto IsComplex = [](const EdgeRecord* group, size_t count) {
+        return count > 2 || (count == 2 && group[0].bForward == group[1].bForward);
+    };
+
+    BuildAdjacency();
+
+    // Classify every position from the topology of the original triangles.
+    std::vector<EVertexKind> kinds(vertexCount, EVertexKind::Locked);
+    {
+        std::vector<uint8_t> borderEdges(vertexCount);
+        std::vector<uint8_t> seamEdges(vertexCount);
+        std::vector<uint8_t> complex(vertexCount);
+
+        for (size_t i = 0; i < edges.size();) {
+            size_t count = 1;
+            while (i + count < edges.size() && edges[i + count].First == edges[i].First && edges[i + count].Second == edges[i].Second) {
+                count++;
+            }
+
+            const EdgeRecord& edge = edges[i];
+            if (IsComplex(&edge, count)) {
+                complex[edge.First] = complex[edge.Second] = 1;
+            }
+            else if (IsBorder(&edge, count)) {
+                borderEdges[edge.First] = std::min(borderEdges[edge.First] + 1, 255);
+                borderEdges[edge.Second] = std::min(borderEdges[edge.Second] + 1, 255);
+            }
+            else if (IsSeam(&edge, count)) {
+                seamEdges[edge.First] = std::min(seamEdges[edge.First] + 1, 255);
+                seamEdges[edge.Second] = std::min(seamEdges[edge.Second] + 1, 255);
+            }
+
+            i += count;
+        }
+
+        for (uint32_t v = 0; v < vertexCount; v++) {
+            if (positionIds[v] != v || complex[v])
+                continue;
+
+            uint32_t wedgeCount = 0;
+            uint32_t w = v;
+            do {
+                wedgeCount += used[w];
+                w = wedges[w];
+            } while (w != v);
+
+            if (wedgeCount == 1 && borderEdges[v] == 0 && seamEdges[v] == 0)
+                kinds[v] = EVertexKind::Manifold;
+            else if (wedgeCount == 1 && borderEdges[v] == 2 && seamEdges[v] == 0)
+                kinds[v] = EVertexKind::Border;
+            else if (wedgeCount == 2 && borderEdges[v] == 0 && seamEdges[v] == 2)
+                kinds[v] = EVertexKind::Seam;
+        }
+    }
+
+    // Build the quadrics from the original triangles: plane quadrics per position, with extra planes along open borders
+    // to keep their shape, and attribute quadrics per vertex.
+    std::vector<Quadric> positionQuadrics(vertexCount);
+    std::vector<AttributeQuadric> attributeQuadrics(vertexCount);
+    std::memset(positionQuadrics.data(), 0, sizeof(Quadric) * positionQuadrics.size());
+    std::memset(attributeQuadrics.data(), 0, sizeof(AttributeQuadric) * attributeQuadrics.size());
+
+    for (size_t t = 0; t < triangles.size() / 3; t++) {
+        const uint32_t* tri = &triangles[t * 3];
+        const glm::vec3& p0 = positions[tri[0]];
+        const glm::vec3& p1 = positions[tri[1]];
+        const glm::vec3& p2 = positions[tri[2]];
+
+        glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+        float area = glm::length(normal);
+        if (area == 0.0f)
+            continue;
+
+        normal /= area;
+
+        Quadric plane = QuadricFromPlane(normal, -glm::dot(normal, p0), area);
+        AttributeQuadric attribute = AttributeQuadricFromTriangle(p0, p1, p2, &attributes[tri[0] * ATTRIBUTE_COUNT],
+                                                                  &attributes[tri[1] * ATTRIBUTE_COUNT], &attributes[tri[2] * ATTRIBUTE_COUNT], area);
+
+        for (int c = 0; c < 3; c++) {
+            AddQuadric(positionQuadrics[positionIds[tri[c]]], plane);
+            AddAttributeQuadric(attributeQuadrics[tri[c]], attribute);
+        }
+    }
+
+    for (size_t i = 0; i < edges.size();) {
+        size_t count = 1;
+        while (i + count < edges.size() && edges[i + count].First == edges[i].First && edges[i + count].Second == edges[i].Second) {
+            count++;
+        }
+
+        const EdgeRecord& edge = edges[i];
+        i += count;
+
+        if (!IsBorder(&edge, count))
+            continue;
+
+        // The border plane contains the edge and is perpendicular to its triangle.
+        uint32_t t = UINT32_MAX;
+        for (uint32_t o = triangleOffsets[edge.First]; o < triangleOffsets[edge.First + 1]; o++) {
+            const uint32_t* tri = &triangles[positionTriangles[o] * 3];
+            if (positionIds[tri[0]] == edge.Second || positionIds[tri[1]] == edge.Second || positionIds[tri[2]] == edge.Second) {
+                t = positionTriangles[o];
+                break;
+            }
+        }
+
+        if (t == UINT32_MAX)
+            continue;
+
+        const uint32_t* tri = &triangles[t * 3];
+        glm::vec3 normal = glm::cross(positions[tri[1]] - positions[tri[0]], positions[tri[2]] - positions[tri[0]]);
+        glm::vec3 direction = positions[edge.SecondVertex] - positions[edge.FirstVertex];
+        float lengthSquared = glm::dot(direction, direction);
+
+        glm::vec3 planeNormal = glm::cross(direction, normal);
+        float planeLength = glm::length(planeNormal);
+        if (planeLength == 0.0f)
+            continue;
+
+        planeNormal /= planeLength;
+
+        Quadric plane = QuadricFromPlane(planeNormal, -glm::dot(planeNormal, positions[edge.FirstVertex]), lengthSquared * BORDER_WEIGHT);
+        AddQuadric(positionQuadrics[edge.First], plane);
+        AddQuadric(positionQuadrics[edge.Second], plane);
+    }
+
+    // Returns whether moving source onto target would flip any of the triangles around source that survive.
+    auto WouldFlip = [&](uint32_t source, uint32_t target) {
+        const glm::vec3& to = positions[target];
+
+        for (uint32_t o = triangleOffsets[source]; o < triangleOffsets[source + 1]; o++) {
+            const uint32_t* tri = &triangles[positionTriangles[o] * 3];
+
+            glm::vec3 corners[3];
+            glm::vec3 moved[3];
+            bool bHasTarget = false;
+            for (int c = 0; c < 3; c++) {
+                uint32_t p = positionIds[tri[c]];
+                bHasTarget |= p == target;
+                corners[c] = positions[tri[c]];
+                moved[c] = p == source ? to : corners[c];
+            }
+
+            if (bHasTarget)
+                continue;
+
+            glm::vec3 before = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+            glm::vec3 after = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+
+            // Reject collapses that turn a triangle by more than about 75 degrees, or make it degenerate.
+            if (glm::dot(before, after) <= 0.25f * glm::length(before) * glm::length(after))
+                return true;
+        }
+
+        return false;
+    };
+
+    // Fills in the collapse of source onto target along the given edge, and returns whether it is allowed.
+    auto EvaluateCollapse = [&](uint32_t source, uint32_t target, const EdgeRecord* group, size_t count, Collapse& collapse) {
+        const EVertexKind kind = kinds[source];
+        const EVertexKind targetKind = kinds[target];
+
+        if (kind == EVertexKind::Locked)
+            return false;
+        if (kind == EVertexKind::Border && (!IsBorder(group, count) || (targetKind != EVertexKind::Border && targetKind != EVertexKind::Locked)))
+            return false;
+        if (kind == EVertexKind::Seam && (!IsSeam(group, count) || (targetKind != EVertexKind::Seam && targetKind != EVertexKind::Locked)))
+            return false;
+
+        collapse.Source = source;
+        collapse.Target = target;
+        collapse.bBorder = IsBorder(group, count);
+
+        const glm::vec3& to = positions[target];
+        const Quadric& quadric = positionQuadrics[source];
+        float geometric = QuadricError(quadric, to);
+        float attribute = 0.0f;
+
+        // Every vertex at the source in use must move to a vertex at the target that it shares an edge with.
+        uint32_t wedgeIndex = 0;
+        uint32_t w = source;
+        do {
+            if (used[w]) {
+                if (wedgeIndex == 2)
+                    return false;
+
+                uint32_t moveTo = UINT32_MAX;
+                for (size_t r = 0; r < count && moveTo == UINT32_MAX; r++) {
+                    if (group[r].FirstVertex == w)
+                        moveTo = group[r].SecondVertex;
+                    else if (group[r].SecondVertex == w)
+                        moveTo = group[r].FirstVertex;
+                }
+
+                if (moveTo == UINT32_MAX)
+                    return false;
+
+                collapse.Wedges[wedgeIndex++] = moveTo;
+                attribute += AttributeQuadricError(attributeQuadrics[w], to, &attributes[moveTo * ATTRIBUTE_COUNT]);
+            }
+
+            w = wedges[w];
+        } while (w != source);
+
+        float invWeight = quadric.W > 0.0f ? 1.0f / quadric.W : 0.0f;
+        collapse.GeometricError = geometric * invWeight;
+        collapse.Cost = (geometric + attribute) * invWeight;
+        return true;
+    };
+
+    const float errorLimit = targetError * targetError;
+    float maxError = 0.0f;
+
+    std::vector<Collapse> collapses;
+    std::vector<uint32_t> collapseRemap(vertexCount);
+    std::vector<uint8_t> locked(vertexCount);
+
+    while (triangles.size() > targetIndexCount) {
+        collapses.clear();
+
+        for (size_t i = 0; i < edges.size();) {
+            size_t count = 1;
+            while (i + count < edges.size() && edges[i + count].First == edges[i].First && edges[i + count].Second == edges[i].Second) {
+                count++;
+            }
+
+            const EdgeRecord* group = &edges[i];
+            i += count;
+
+            if (IsComplex(group, count))
+                continue;
+
+            Collapse forward;
+            Collapse backward;
+            bool bForward = EvaluateCollapse(group->First, group->Second, group, count, forward);
+            bool bBackward = EvaluateCollapse(group->Second, group->First, group, count, backward);
+
+            if (bForward && (!bBackward || forward.Cost <= backward.Cost))
+                collapses.push_back(forward);
+            else if (bBackward)
+                collapses.push_back(backward);
+        }
+
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) {
+            return std::tie(a.Cost, a.Source, a.Target) < std::tie(b.Cost, b.Source, b.Target);
+        });
+
+        for (uint32_t v = 0; v < vertexCount; v++) {
+            collapseRemap[v] = v;
+        }
+        std::fill(locked.begin(), locked.end(), 0);
+
+        const size_t trianglesToRemove = (triangles.size() - targetIndexCount + 2) / 3;
+        size_t removed = 0;
+        size_t applied = 0;
+
+        for (const Collapse& collapse : collapses) {
+            if (removed >= trianglesToRemove)
+                break;
+            if (collapse.GeometricError > errorLimit || locked[collapse.Source] || locked[collapse.Target])
+                continue;
+            if (WouldFlip(collapse.Source, collapse.Target))
+                continue;
+
+            uint32_t wedgeIndex = 0;
+            uint32_t w = collapse.Source;
+            do {
+                if (used[w]) {
+                    collapseRemap[w] = collapse.Wedges[wedgeIndex];
+                    AddAttributeQuadric(attributeQuadrics[collapse.Wedges[wedgeIndex]], attributeQuadrics[w]);
+                    wedgeIndex++;
+                }
+
+                w = wedges[w];
+            } while (w != collapse.Source);
+
+            AddQuadric(positionQuadrics[collapse.Target], positionQuadrics[collapse.Source]);
+
+            // Triangles around the source change shape, so nothing else touching them may move in this pass.
+            for (uint32_t o = triangleOffsets[collapse.Source]; o < triangleOffsets[collapse.Source + 1]; o++) {
+                const uint32_t* tri = &triangles[positionTriangles[o] * 3];
+                for (int c = 0; c < 3; c++) {
+                    locked[positionIds[tri[c]]] = 1;
+                }
+            }
+
+            maxError = std::max(maxError, collapse.GeometricError);
+            removed += collapse.bBorder ? 1 : 2;
+            applied++;
+        }
+
+        if (applied == 0)
+            break;
+
+        // Apply the collapses and drop the triangles that became degenerate.
+        size_t write = 0;
+        for (size_t t = 0; t < triangles.size() / 3; t++) {
+            uint32_t a = collapseRemap[triangles[t * 3 + 0]];
+            uint32_t b = collapseRemap[triangles[t * 3 + 1]];
+            uint32_t c = collapseRemap[triangles[t * 3 + 2]];
+
+            if (positionIds[a] == positionIds[b] || positionIds[b] == positionIds[c] || positionIds[c] == positionIds[a])
+                continue;
+
+            triangles[write++] = a;
+            triangles[write++] = b;
+            triangles[write++] = c;
+        }
+
+        triangles.resize(write);
+        BuildAdjacency();
+    }
+
+    output.resize(triangles.size());
+    for (size_t i = 0; i < triangles.size(); i++) {
+        output[i] = triangles[i] + firstVertex;
+    }
+
+    return std::sqrt(maxError);
+}
@@ -0,0 +1,193 @@
+#include "geometry/GXMeshlet.hpp"
+#include "glm/geometric.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+bool GXMeshlet::IsBackfacing(const glm::vec3& cameraPosition) const {
+    // Without a useful cone, some triangle may always face the camera.
+    if (!(ConeCutoff < 1.0f))
+        return false;
+
+    glm::vec3 view = ConeApex - cameraPosition;
+    float distance = glm::length(view);
+
+    // A camera on the apex has no direction to test.
+    if (distance == 0.0f)
+        return false;
+
+    // The camera is looking along the cone from behind every triangle's plane.
+    return glm::dot(view, ConeAxis) >= ConeCutoff * distance;
+}
+
+namespace {
+    // Computes a sphere enclosing all of the given vertices using Ritter's method.
+    void CalculateBoundingSphere(const ModernVertex* vertices, const uint32_t* ids, uint32_t count, glm::vec3& center, float& radius) {
+        // Start from the widest pair of extreme points along the three axes.
+        uint32_t minIds[3] = { ids[0], ids[0], ids[0] };
+        uint32_t maxIds[3] = { ids[0], ids[0], ids[0] };
+
+        for (uint32_t i = 1; i < count; i++) {
+            const glm::vec4& p = vertices[ids[i]].Position;
+
+            for (int a = 0; a < 3; a++) {
+                if (p[a] < vertices[minIds[a]].Position[a])
+                    minIds[a] = ids[i];
+                if (p[a] > vertices[maxIds[a]].Position[a])
+                    maxIds[a] = ids[i];
+            }
+        }
+
+        int widest = 0;
+        float widestDistance = -1.0f;
+        for (int a = 0; a < 3; a++) {
+            glm::vec3 d = glm::vec3(vertices[maxIds[a]].Position) - glm::vec3(vertices[minIds[a]].Position);
+            float distance = glm::dot(d, d);
+
+            if (distance > widestDistance) {
+                widestDistance = distance;
+                widest = a;
+            }
+        }
+
+        glm::vec3 p0(vertices[minIds[widest]].Position);
+        glm::vec3 p1(vertices[maxIds[widest]].Position);
+        center = (p0 + p1) * 0.5f;
+        radius = glm::length(p1 - p0) * 0.5f;
+
+        // Grow the sphere just enough to take in every point left outside of it.
+        for (uint32_t i = 0; i < count; i++) {
+            glm::vec3 p(vertices[ids[i]].Position);
+            float distance = glm::length(p - center);
+
+            if (distance > radius) {
+                float grow = (distance - radius) * 0.5f;
+                center += (p - center) * (grow / distance);
+                radius += grow;
+            }
+        }
+    }
+
+    // Fills in the bounding sphere and normal cone of the given meshlet.
+    void CalculateMeshletBounds(const ModernVertex* vertices, const uint32_t* meshletVertices, const uint8_t* triangles, GXMeshlet& meshlet) {
+        CalculateBoundingSphere(vertices, meshletVertices, meshlet.VertexCount, meshlet.Center, meshlet.Radius);
+
+        std::vector<glm::vec3> normals;
+        std::vector<glm::vec3> corners;
+        normals.reserve(meshlet.TriangleCount);
+        corners.reserve(meshlet.TriangleCount);
+
+        glm::vec3 axis(0.0f);
+        for (uint32_t t = 0; t < meshlet.TriangleCount; t++) {
+            glm::vec3 p0(vertices[meshletVertices[triangles[t * 3]]].Position);
+            glm::vec3 p1(vertices[meshletVertices[triangles[t * 3 + 1]]].Position);
+            glm::vec3 p2(vertices[meshletVertices[triangles[t * 3 + 2]]].Position);
+
+            glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+            float length = glm::length(n);
+            if (length == 0.0f)
+                continue;
+
+            normals.push_back(n / length);
+            corners.push_back(p0);
+            axis += normals.back();
+        }
+
+        meshlet.ConeApex = meshlet.Center;
+        meshlet.ConeAxis = glm::vec3(0.0f);
+        meshlet.ConeCutoff = 1.0f;
+
+        float axisLength = glm::length(axis);
+        if (normals.empty() || axisLength == 0.0f)
+            return;
+
+        axis /= axisLength;
+
+        float minDot = 1.0f;
+        for (const glm::vec3& n : normals) {
+            minDot = std::min(minDot, glm::dot(n, axis));
+        }
+
+        // Past about 84 degrees from the axis, the cone would almost never cull anything.
+        if (minDot <= 0.1f)
+            return;
+
+        // Move the apex back along the axis until it is behind every triangle's plane.
+        float maxT = 0.0f;
+        for (size_t i = 0; i < normals.size(); i++) {
+            float t = glm::dot(meshlet.Center - corners[i], normals[i]) / glm::dot(axis, normals[i]);
+            maxT = std::max(maxT, t);
+        }
+
+        meshlet.ConeApex = meshlet.Center - axis * maxT;
+        meshlet.ConeAxis = axis;
+        meshlet.ConeCutoff = std::sqrt(1.0f - minDot * minDot);
+    }
+}
+
+void GXBuildMeshlets(const uint32_t* indices, size_t indexCount, const ModernVertex* vertices, uint32_t maxVertices, uint32_t maxTriangles,
+                     uint32_t shapeIndex, GXMeshletList& output) {
+    if (maxVertices < 3 || maxVertices > 256)
+        throw std::invalid_argument("Meshlets must allow between 3 and 256 vertices!");
+    if (maxTriangles < 1)
+        throw std::invalid_argument("Meshlets must allow at least one triangle!");
+
+    const size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0)
+        return;
+
+    const uint32_t firstVertex = *std::min_element(indices, indices + triangleCount * 3);
+    const uint32_t lastVertex = *std::max_element(indices, indices + triangleCount * 3);
+
+    // Maps the vertices of the meshlet being built to their local index, or -1 if they aren't in it.
+    std::vector<int16_t> localIndices(static_cast<size_t>(lastVertex - firstVertex) + 1, -1);
+
+    GXMeshlet current;
+    current.ShapeIndex = shapeIndex;
+    current.VertexOffset = static_cast<uint32_t>(output.Vertices.size());
+    current.TriangleOffset = static_cast<uint32_t>(output.Triangles.size() / 3);
+
+    auto Finish = [&]() {
+        for (size_t i = current.VertexOffset; i < output.Vertices.size(); i++) {
+            localIndices[output.Vertices[i] - firstVertex] = -1;
+        }
+
+        CalculateMeshletBounds(vertices, output.Vertices.data() + current.VertexOffset,
+                               output.Triangles.data() + static_cast<size_t>(current.TriangleOffset) * 3, current);
+        output.Meshlets.push_back(current);
+
+        current = GXMeshlet();
+        current.ShapeIndex = shapeIndex;
+        current.VertexOffset = static_cast<uint32_t>(output.Vertices.size());
+        current.TriangleOffset = static_cast<uint32_t>(output.Triangles.size() / 3);
+    };
+
+    for (size_t t = 0; t < triangleCount; t++) {
+        const uint32_t* triangle = &indices[t * 3];
+
+        uint32_t newVertices = 0;
+        for (int c = 0; c < 3; c++) {
+            bool repeated = (c > 0 && triangle[c] == triangle[0]) || (c > 1 && triangle[c] == triangle[1]);
+            if (!repeated && localIndices[triangle[c] - firstVertex] < 0)
+                newVertices++;
+        }
+
+        if (current.VertexCount + newVertices > maxVertices || current.TriangleCount == maxTriangles)
+            Finish();
+
+        for (int c = 0; c < 3; c++) {
+            int16_t& local = localIndices[triangle[c] - firstVertex];
+            if (local < 0) {
+                local = static_cast<int16_t>(current.VertexCount++);
+                output.Vertices.push_back(triangle[c]);
+            }
+
+            output.Triangles.push_back(static_cast<uint8_t>(local));
+        }
+
+        current.TriangleCount++;
+    }
+
+    Finish();
+}
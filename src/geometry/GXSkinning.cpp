@@ -0,0 +1,193 @@
+#include "geometry/GXSkinning.hpp"
+#include "util/GXSimd.hpp"
+#include "glm/geometric.hpp"
+#include "glm/matrix.hpp"
+
+#include <cmath>
+
+void GXSkinPalette::SetMatrices(const glm::mat4* matrices, size_t count) {
+    mPositionMatrices.assign(matrices, matrices + count);
+    mNormalMatrices.resize(count);
+
+    for (size_t i = 0; i < count; i++) {
+        // Only the upper 3x3 applies to normals; the translation column is left at zero.
+        glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(matrices[i])));
+        mNormalMatrices[i] = glm::mat4(normalMatrix);
+        mNormalMatrices[i][3] = glm::vec4(0.0f);
+    }
+}
+
+// Returns the palette slot that the given vertex uses, or -1 if it should be left untransformed.
+// If a draw palette is given, the vertex's index is a slot in it, and the matrix index stored there selects the matrix.
+static inline ptrdiff_t GetPaletteSlot(const ModernVertex& vertex, size_t paletteSize, const std::vector<uint32_t>* drawPalette) {
+    const float index = vertex.Position.w;
+
+    if (drawPalette != nullptr) {
+        // Written so that NaN fails the test too.
+        if (!(index >= 0.0f && index < static_cast<float>(drawPalette->size())))
+            return -1;
+
+        const uint32_t matrix = (*drawPalette)[static_cast<size_t>(index)];
+        return matrix < paletteSize ? static_cast<ptrdiff_t>(matrix) : -1;
+    }
+
+    // Written so that NaN fails the test too.
+    if (!(index >= 0.0f && index < static_cast<float>(paletteSize)))
+        return -1;
+
+    return static_cast<ptrdiff_t>(index);
+}
+
+// Skins one vertex, reading vertices[id] and writing positions[id] and normals[id].
+static inline void SkinVertex(const ModernVertex* vertices, size_t id, const glm::mat4* positionMatrices, const glm::mat4* normalMatrices,
+                              size_t paletteSize, glm::vec3* positions, glm::vec3* normals, const std::vector<uint32_t>* drawPalette) {
+    const ModernVertex& vertex = vertices[id];
+    const ptrdiff_t slot = GetPaletteSlot(vertex, paletteSize, drawPalette);
+
+    if (slot < 0) {
+        positions[id] = glm::vec3(vertex.Position);
+        if (normals != nullptr)
+            normals[id] = vertex.Normal;
+
+        return;
+    }
+
+    positions[id] = glm::vec3(positionMatrices[slot] * glm::vec4(glm::vec3(vertex.Position), 1.0f));
+
+    if (normals == nullptr)
+        return;
+
+    glm::vec3 normal = glm::vec3(normalMatrices[slot] * glm::vec4(vertex.Normal, 0.0f));
+    float length = glm::length(normal);
+    normals[id] = length > 0.0f ? normal / length : normal;
+}
+
+#if defined(LIBFLIPPER_SSE2)
+namespace {
+    // Loaded for lanes without a matrix, whose results are thrown away.
+    const glm::mat4 kPlaceholderMatrix(1.0f);
+}
+
+// Transforms four vectors in SoA form, each by its own matrix: lane l of x, y and z is multiplied by matrices[l],
+// whose fourth column is added when translate is set. Lanes whose matrix is null are left as they are.
+static inline void TransformFour(const glm::mat4* const matrices[4], bool translate, __m128& x, __m128& y, __m128& z) {
+    // Column c of the four matrices, transposed so that each register holds one row of it across the lanes.
+    __m128 columns[4][4];
+    for (int c = 0; c < (translate ? 4 : 3); c++) {
+        for (int l = 0; l < 4; l++) {
+            columns[c][l] = _mm_loadu_ps(&(matrices[l] != nullptr ? *matrices[l] : kPlaceholderMatrix)[c][0]);
+        }
+
+        _MM_TRANSPOSE4_PS(columns[c][0], columns[c][1], columns[c][2], columns[c][3]);
+    }
+
+    // Lanes without a matrix keep their input exactly, even if it isn't finite.
+    const __m128 keep = _mm_castsi128_ps(_mm_setr_epi32(matrices[0] ? 0 : -1, matrices[1] ? 0 : -1, matrices[2] ? 0 : -1, matrices[3] ? 0 : -1));
+
+    __m128* in[3] = { &x, &y, &z };
+    __m128 out[3];
+    for (int r = 0; r < 3; r++) {
+        out[r] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(columns[0][r], x), _mm_mul_ps(columns[1][r], y)), _mm_mul_ps(columns[2][r], z));
+        if (translate)
+            out[r] = _mm_add_ps(out[r], columns[3][r]);
+
+        out[r] = _mm_or_ps(_mm_andnot_ps(keep, out[r]), _mm_and_ps(keep, *in[r]));
+    }
+
+    x = out[0];
+    y = out[1];
+    z = out[2];
+}
+
+// Skins four vertices at once, reading vertices[ids[l]] and writing positions[ids[l]] and normals[ids[l]].
+static inline void SkinFour(const ModernVertex* vertices, const size_t ids[4], const glm::mat4* positionMatrices, const glm::mat4* normalMatrices,
+                            size_t paletteSize, glm::vec3* positions, glm::vec3* normals, const std::vector<uint32_t>* drawPalette) {
+    // Results are written back as three floats.
+    auto Store3 = [](float* dst, __m128 v) {
+        _mm_storel_pi(reinterpret_cast<__m64*>(dst), v);
+        _mm_store_ss(dst + 2, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2)));
+    };
+
+    const glm::mat4* positionLanes[4];
+    const glm::mat4* normalLanes[4];
+    for (int l = 0; l < 4; l++) {
+        const ptrdiff_t slot = GetPaletteSlot(vertices[ids[l]], paletteSize, drawPalette);
+        positionLanes[l] = slot >= 0 ? &positionMatrices[slot] : nullptr;
+        normalLanes[l] = slot >= 0 ? &normalMatrices[slot] : nullptr;
+    }
+
+    __m128 x = _mm_loadu_ps(&vertices[ids[0]].Position.x);
+    __m128 y = _mm_loadu_ps(&vertices[ids[1]].Position.x);
+    __m128 z = _mm_loadu_ps(&vertices[ids[2]].Position.x);
+    __m128 w = _mm_loadu_ps(&vertices[ids[3]].Position.x);
+    _MM_TRANSPOSE4_PS(x, y, z, w);
+
+    TransformFour(positionLanes, true, x, y, z);
+
+    w = _mm_setzero_ps();
+    _MM_TRANSPOSE4_PS(x, y, z, w);
+    Store3(&positions[ids[0]].x, x);
+    Store3(&positions[ids[1]].x, y);
+    Store3(&positions[ids[2]].x, z);
+    Store3(&positions[ids[3]].x, w);
+
+    if (normals == nullptr)
+        return;
+
+    __m128 nx = _mm_setr_ps(vertices[ids[0]].Normal.x, vertices[ids[1]].Normal.x, vertices[ids[2]].Normal.x, vertices[ids[3]].Normal.x);
+    __m128 ny = _mm_setr_ps(vertices[ids[0]].Normal.y, vertices[ids[1]].Normal.y, vertices[ids[2]].Normal.y, vertices[ids[3]].Normal.y);
+    __m128 nz = _mm_setr_ps(vertices[ids[0]].Normal.z, vertices[ids[1]].Normal.z, vertices[ids[2]].Normal.z, vertices[ids[3]].Normal.z);
+    TransformFour(normalLanes, false, nx, ny, nz);
+
+    // Renormalize the lanes that were transformed and have a length, and leave the rest as they are.
+    __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)), _mm_mul_ps(nz, nz)));
+    __m128 transformed = _mm_castsi128_ps(_mm_setr_epi32(normalLanes[0] ? -1 : 0, normalLanes[1] ? -1 : 0, normalLanes[2] ? -1 : 0, normalLanes[3] ? -1 : 0));
+    __m128 renormalize = _mm_and_ps(transformed, _mm_cmpgt_ps(length, _mm_setzero_ps()));
+    __m128 divisor = _mm_or_ps(_mm_and_ps(renormalize, length), _mm_andnot_ps(renormalize, _mm_set1_ps(1.0f)));
+
+    nx = _mm_div_ps(nx, divisor);
+    ny = _mm_div_ps(ny, divisor);
+    nz = _mm_div_ps(nz, divisor);
+
+    w = _mm_setzero_ps();
+    _MM_TRANSPOSE4_PS(nx, ny, nz, w);
+    Store3(&normals[ids[0]].x, nx);
+    Store3(&normals[ids[1]].x, ny);
+    Store3(&normals[ids[2]].x, nz);
+    Store3(&normals[ids[3]].x, w);
+}
+#endif
+
+// Skins count vertices, the i-th of which is getId(i).
+template<typename GetId>
+static void SkinVerticesImpl(const ModernVertex* vertices, size_t count, GetId getId, const GXSkinPalette& palette, glm::vec3* positions,
+                             glm::vec3* normals, const std::vector<uint32_t>* drawPalette) {
+    const glm::mat4* positionMatrices = palette.GetPositionMatrices().data();
+    const glm::mat4* normalMatrices = palette.GetNormalMatrices().data();
+    const size_t paletteSize = palette.GetSize();
+
+    size_t i = 0;
+
+#if defined(LIBFLIPPER_SSE2)
+    // Four vertices at a time, transposed so that each lane holds one vertex and each matrix row is a few
+    // multiplies and adds across all four.
+    for (; i + 4 <= count; i += 4) {
+        const size_t ids[4] = { getId(i), getId(i + 1), getId(i + 2), getId(i + 3) };
+        SkinFour(vertices, ids, positionMatrices, normalMatrices, paletteSize, positions, normals, drawPalette);
+    }
+#endif
+
+    for (; i < count; i++) {
+        SkinVertex(vertices, getId(i), positionMatrices, normalMatrices, paletteSize, positions, normals, drawPalette);
+    }
+}
+
+void GXSkinVertices(const ModernVertex* vertices, size_t count, const GXSkinPalette& palette, glm::vec3* positions, glm::vec3* normals,
+                    const std::vector<uint32_t>* drawPalette) {
+    SkinVerticesImpl(vertices, count, [](size_t i) { return i; }, palette, positions, normals, drawPalette);
+}
+
+void GXSkinVertices(const ModernVertex* vertices, const uint32_t* ids, size_t count, const GXSkinPalette& palette, glm::vec3* positions,
+                    glm::vec3* normals, const std::vector<uint32_t>* drawPalette) {
+    SkinVerticesImpl(vertices, count, [ids](size_t i) { return static_cast<size_t>(ids[i]); }, palette, positions, normals, drawPalette);
+}
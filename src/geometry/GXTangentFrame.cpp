@@ -0,0 +1,261 @@
+#include "geometry/GXTangentFrame.hpp"
+#include "util/GXSimd.hpp"
+#include "glm/geometric.hpp"
+#include "glm/gtc/quaternion.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <tuple>
+#include <vector>
+
+// The smallest magnitude w is allowed to have, so its sign survives quantization to 16-bit signed normalized values.
+static const float TANGENT_FRAME_BIAS = 1.0f / 32767.0f;
+
+// Returns a unit vector perpendicular to the given unit vector.
+static glm::vec3 GetPerpendicular(const glm::vec3& n) {
+    // Cross with whichever axis is least parallel to n.
+    glm::vec3 axis = std::fabs(n.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    return glm::normalize(glm::cross(n, axis));
+}
+
+glm::vec4 GXEncodeTangentFrame(const glm::vec3& normal, const glm::vec3& tangent, float handedness) {
+    glm::mat3 basis(tangent, glm::cross(normal, tangent), normal);
+    glm::quat q = glm::normalize(glm::quat_cast(basis));
+
+    // q and -q are the same rotation, so w can always be made positive, leaving its sign free for the handedness.
+    glm::vec4 frame(q.x, q.y, q.z, q.w);
+    if (frame.w < 0.0f)
+        frame = -frame;
+
+    if (frame.w < TANGENT_FRAME_BIAS) {
+        float xyzLength = glm::length(glm::vec3(frame));
+        float scale = xyzLength > 0.0f ? std::sqrt(1.0f - TANGENT_FRAME_BIAS * TANGENT_FRAME_BIAS) / xyzLength : 0.0f;
+
+        frame = glm::vec4(glm::vec3(frame) * scale, TANGENT_FRAME_BIAS);
+    }
+
+    return handedness < 0.0f ? -frame : frame;
+}
+
+void GXDecodeTangentFrame(const glm::vec4& frame, glm::vec3& normal, glm::vec3& tangent, glm::vec3& bitangent) {
+    float handedness = frame.w < 0.0f ? -1.0f : 1.0f;
+
+    glm::quat q = glm::normalize(glm::quat(frame.w, frame.x, frame.y, frame.z));
+    glm::mat3 basis = glm::mat3_cast(q);
+
+    tangent = basis[0];
+    normal = basis[2];
+    bitangent = glm::cross(normal, tangent) * handedness;
+}
+
+// Writes the unnormalized normal of each triangle, whose length is twice the triangle's area.
+static void CalculateFaceNormals(const ModernVertex* vertices, const uint32_t* indices, size_t triangleCount, glm::vec3* normals) {
+    size_t t = 0;
+
+#if defined(LIBFLIPPER_SSE2)
+    // Four triangles at a time, with each component of each corner gathered into its own register.
+    for (; t + 4 <= triangleCount; t += 4) {
+        const uint32_t* tri = indices + t * 3;
+
+        __m128 p[3][3];
+        for (int c = 0; c < 3; c++) {
+            const glm::vec4& a = vertices[tri[c]].Position;
+            const glm::vec4& b = vertices[tri[3 + c]].Position;
+            const glm::vec4& d = vertices[tri[6 + c]].Position;
+            const glm::vec4& e = vertices[tri[9 + c]].Position;
+
+            p[c][0] = _mm_set_ps(e.x, d.x, b.x, a.x);
+            p[c][1] = _mm_set_ps(e.y, d.y, b.y, a.y);
+            p[c][2] = _mm_set_ps(e.z, d.z, b.z, a.z);
+        }
+
+        __m128 e1x = _mm_sub_ps(p[1][0], p[0][0]);
+        __m128 e1y = _mm_sub_ps(p[1][1], p[0][1]);
+        __m128 e1z = _mm_sub_ps(p[1][2], p[0][2]);
+        __m128 e2x = _mm_sub_ps(p[2][0], p[0][0]);
+        __m128 e2y = _mm_sub_ps(p[2][1], p[0][1]);
+        __m128 e2z = _mm_sub_ps(p[2][2], p[0][2]);
+
+        alignas(16) float nx[4];
+        alignas(16) float ny[4];
+        alignas(16) float nz[4];
+        _mm_store_ps(nx, _mm_sub_ps(_mm_mul_ps(e1y, e2z), _mm_mul_ps(e1z, e2y)));
+        _mm_store_ps(ny, _mm_sub_ps(_mm_mul_ps(e1z, e2x), _mm_mul_ps(e1x, e2z)));
+        _mm_store_ps(nz, _mm_sub_ps(_mm_mul_ps(e1x, e2y), _mm_mul_ps(e1y, e2x)));
+
+        for (int i = 0; i < 4; i++) {
+            normals[t + i] = glm::vec3(nx[i], ny[i], nz[i]);
+        }
+    }
+#endif
+
+    for (; t < triangleCount; t++) {
+        const uint32_t* tri = indices + t * 3;
+
+        glm::vec3 p0(vertices[tri[0]].Position);
+        glm::vec3 p1(vertices[tri[1]].Position);
+        glm::vec3 p2(vertices[tri[2]].Position);
+
+        normals[t] = glm::cross(p1 - p0, p2 - p0);
+    }
+}
+
+void GXGenerateSmoothNormals(ModernVertex* vertices, const uint32_t* indices, size_t indexCount, uint32_t firstVertex, uint32_t vertexCount) {
+    const size_t triangleCount = indexCount / 3;
+
+    std::vector<glm::vec3> faceNormals(triangleCount);
+    CalculateFaceNormals(vertices, indices, triangleCount, faceNormals.data());
+
+    // Give every vertex the id of the group of vertices sharing its position. Positions are compared bitwise,
+    // which keeps the sort well-defined for any input.
+    auto PositionKey = [&](uint32_t v) {
+        uint32_t key[3];
+        std::memcpy(key, &vertices[firstVertex + v].Position, sizeof(key));
+        return std::make_tuple(key[0], key[1], key[2]);
+    };
+
+    std::vector<uint32_t> order(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; v++) {
+        order[v] = v;
+    }
+
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return PositionKey(a) < PositionKey(b);
+    });
+
+    std::vector<uint32_t> group(vertexCount);
+    uint32_t groupCount = 0;
+    for (uint32_t i = 0; i < vertexCount; i++) {
+        if (i > 0 && PositionKey(order[i]) != PositionKey(order[i - 1]))
+            groupCount++;
+
+        group[order[i]] = groupCount;
+    }
+
+    std::vector<glm::vec3> groupNormals(vertexCount > 0 ? groupCount + 1 : 0, glm::vec3(0.0f));
+    for (size_t t = 0; t < triangleCount; t++) {
+        for (int c = 0; c < 3; c++) {
+            groupNormals[group[indices[t * 3 + c] - firstVertex]] += faceNormals[t];
+        }
+    }
+
+    for (uint32_t v = 0; v < vertexCount; v++) {
+        const glm::vec3& sum = groupNormals[group[v]];
+        float length = glm::length(sum);
+
+        vertices[firstVertex + v].Normal = length > 0.0f ? sum / length : glm::vec3(0.0f);
+    }
+}
+
+void GXGenerateTangentFrames(const ModernVertex* vertices, uint32_t* indices, size_t indexCount, uint32_t firstVertex, uint32_t vertexCount,
+                             std::vector<glm::vec4>& frames, std::vector<uint32_t>& splitVertices, uint32_t texCoordIndex) {
+    const size_t triangleCount = indexCount / 3;
+
+    // The unit normal that each vertex's frame is built around.
+    std::vector<glm::vec3> normals(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; v++) {
+        const glm::vec3& n = vertices[firstVertex + v].Normal;
+        float length = glm::length(n);
+
+        normals[v] = length > 0.0f ? n / length : glm::vec3(0.0f, 0.0f, 1.0f);
+    }
+
+    // What each triangle corner adds to its vertex: the projected tangent, already weighted, and the weight signed
+    // by the handedness. Corners of triangles without a usable mapping add nothing and have no handedness.
+    std::vector<glm::vec3> cornerTangents(triangleCount * 3, glm::vec3(0.0f));
+    std::vector<float> cornerWeights(triangleCount * 3, 0.0f);
+
+    for (size_t t = 0; t < triangleCount; t++) {
+        const uint32_t* tri = indices + t * 3;
+
+        glm::vec3 p[3];
+        glm::vec2 uv[3];
+        for (int c = 0; c < 3; c++) {
+            p[c] = glm::vec3(vertices[tri[c]].Position);
+            uv[c] = glm::vec2(vertices[tri[c]].TexCoords[texCoordIndex]);
+        }
+
+        glm::vec3 e1 = p[1] - p[0];
+        glm::vec3 e2 = p[2] - p[0];
+        glm::vec2 d1 = uv[1] - uv[0];
+        glm::vec2 d2 = uv[2] - uv[0];
+
+        // Twice the signed area of the triangle in texture space.
+        float area = d1.x * d2.y - d2.x * d1.y;
+        if (std::fabs(area) < 1e-12f)
+            continue;
+
+        glm::vec3 sdir = (e1 * d2.y - e2 * d1.y) / area;
+        glm::vec3 tdir = (e2 * d1.x - e1 * d2.x) / area;
+
+        for (int c = 0; c < 3; c++) {
+            const glm::vec3& n = normals[tri[c] - firstVertex];
+
+            // Project the texture-space tangent onto the vertex's tangent plane, as MikkTSpace does before weighting.
+            glm::vec3 tangent = sdir - n * glm::dot(n, sdir);
+            float tangentLength = glm::length(tangent);
+            if (tangentLength <= 0.0f)
+                continue;
+
+            // Weight by the triangle's angle at this corner.
+            glm::vec3 a = p[(c + 1) % 3] - p[c];
+            glm::vec3 b = p[(c + 2) % 3] - p[c];
+            float lengths = glm::length(a) * glm::length(b);
+            if (lengths <= 0.0f)
+                continue;
+
+            float angle = std::acos(glm::clamp(glm::dot(a, b) / lengths, -1.0f, 1.0f));
+            if (angle <= 0.0f)
+                continue;
+
+            cornerTangents[t * 3 + c] = tangent * (angle / tangentLength);
+            cornerWeights[t * 3 + c] = glm::dot(glm::cross(n, sdir), tdir) < 0.0f ? -angle : angle;
+        }
+    }
+
+    // Vertices used with both handedness signs sit on a mirrored seam. Their left-handed corners move to a copy.
+    std::vector<uint8_t> signs(vertexCount, 0);
+    for (size_t i = 0; i < triangleCount * 3; i++) {
+        if (cornerWeights[i] != 0.0f)
+            signs[indices[i] - firstVertex] |= cornerWeights[i] < 0.0f ? 2 : 1;
+    }
+
+    splitVertices.clear();
+    std::vector<uint32_t> copies(vertexCount, UINT32_MAX);
+    for (uint32_t v = 0; v < vertexCount; v++) {
+        if (signs[v] != 3)
+            continue;
+
+        copies[v] = vertexCount + static_cast<uint32_t>(splitVertices.size());
+        splitVertices.push_back(firstVertex + v);
+    }
+
+    const size_t frameCount = vertexCount + splitVertices.size();
+    std::vector<glm::vec3> tangents(frameCount, glm::vec3(0.0f));
+    std::vector<float> handedness(frameCount, 0.0f);
+
+    for (size_t i = 0; i < triangleCount * 3; i++) {
+        uint32_t v = indices[i] - firstVertex;
+        if (cornerWeights[i] < 0.0f && copies[v] != UINT32_MAX) {
+            v = copies[v];
+            indices[i] = firstVertex + v;
+        }
+
+        tangents[v] += cornerTangents[i];
+        handedness[v] += cornerWeights[i];
+    }
+
+    frames.resize(frameCount);
+    for (size_t f = 0; f < frameCount; f++) {
+        const glm::vec3& n = normals[f < vertexCount ? f : splitVertices[f - vertexCount] - firstVertex];
+
+        // The projected tangents are only perpendicular up to rounding, so orthogonalize their sum once more.
+        glm::vec3 tangent = tangents[f] - n * glm::dot(n, tangents[f]);
+        float length = glm::length(tangent);
+
+        tangent = length > 1e-6f ? tangent / length : GetPerpendicular(n);
+
+        frames[f] = GXEncodeTangentFrame(n, tangent, handedness[f] < 0.0f ? -1.0f : 1.0f);
+    }
+}
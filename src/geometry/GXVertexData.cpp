@@ -1,4 +1,37 @@
 #include "geometry/GXVertexData.hpp"
+#include "util/GXSimd.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+// The hashing and bitwise comparison below treat ModernVertex as a flat array of floats.
+static_assert(sizeof(ModernVertex) == sizeof(float) * 39, "ModernVertex must not contain padding");
+
+size_t GXAttributeData::GetArraySize(EGXAttribute attribute) const {
+    uint32_t attrAsInt = (uint32_t)attribute;
+
+    switch (attribute) {
+        case EGXAttribute::Position:
+            return mPositions.size();
+        case EGXAttribute::Normal:
+        case EGXAttribute::NBT:
+            return mNormals.size();
+        case EGXAttribute::Color0:
+        case EGXAttribute::Color1:
+            return mColors[attrAsInt - (uint32_t)EGXAttribute::Color0].size();
+        case EGXAttribute::TexCoord0:
+        case EGXAttribute::TexCoord1:
+        case EGXAttribute::TexCoord2:
+        case EGXAttribute::TexCoord3:
+        case EGXAttribute::TexCoord4:
+        case EGXAttribute::TexCoord5:
+        case EGXAttribute::TexCoord6:
+        case EGXAttribute::TexCoord7:
+            return mTexCoords[attrAsInt - (uint32_t)EGXAttribute::TexCoord0].size();
+        default:
+            return SIZE_MAX;
+    }
+}
 
 GXVertex::GXVertex() {
     for (uint32_t i = 0; i < (uint32_t)EGXAttribute::Attribute_Max; i++) {
@@ -42,12 +75,43 @@ void GXVertex::SetIndex(EGXAttribute attribute, uint16_t value) {
 }
 
 bool GXVertex::operator==(const GXVertex& b) const {
-    for (uint32_t i = 0; i < (uint32_t)EGXAttribute::Attribute_Max; i++) {
-        if (AttributeIndices[i] != b.AttributeIndices[i])
-            return false;
+#ifdef LIBFLIPPER_SSE2
+    static_assert(sizeof(AttributeIndices) == 52, "GXVertex comparison assumes 26 attribute indices");
+
+    // Compare the first 48 bytes in three 16-byte blocks, then the remaining 4 bytes.
+    const __m128i* lhs = reinterpret_cast<const __m128i*>(AttributeIndices);
+    const __m128i* rhs = reinterpret_cast<const __m128i*>(b.AttributeIndices);
+
+    __m128i eq = _mm_and_si128(
+        _mm_cmpeq_epi8(_mm_loadu_si128(lhs + 0), _mm_loadu_si128(rhs + 0)),
+        _mm_and_si128(
+            _mm_cmpeq_epi8(_mm_loadu_si128(lhs + 1), _mm_loadu_si128(rhs + 1)),
+            _mm_cmpeq_epi8(_mm_loadu_si128(lhs + 2), _mm_loadu_si128(rhs + 2))));
+
+    if (_mm_movemask_epi8(eq) != 0xFFFF)
+        return false;
+
+    return std::memcmp(AttributeIndices + 24, b.AttributeIndices + 24, 4) == 0;
+#else
+    return std::memcmp(AttributeIndices, b.AttributeIndices, sizeof(AttributeIndices)) == 0;
+#endif
+}
+
+size_t GXVertexHash::operator()(const GXVertex& v) const {
+    // The index tuple hashed a word at a time, as two 16-bit indices per word.
+    static const uint32_t WORD_COUNT = (uint32_t)EGXAttribute::Attribute_Max / 2;
+    static_assert(sizeof(uint32_t) * WORD_COUNT == sizeof(GXVertex::AttributeIndices), "Index tuples must fill a whole number of words");
+
+    uint32_t words[WORD_COUNT];
+    std::memcpy(words, v.AttributeIndices, sizeof(words));
+
+    uint64_t hash = 0;
+    for (uint32_t w : words) {
+        hash = (hash ^ w) * 0x9E3779B97F4A7C15ull;
+        hash ^= hash >> 29;
     }
 
-    return true;
+    return static_cast<size_t>(hash);
 }
 
 bool ModernVertex::operator==(const ModernVertex& b) const {
@@ -73,3 +137,244 @@ bool ModernVertex::operator==(const ModernVertex& b) const {
 
     return true;
 }
+
+size_t ModernVertexHash::operator()(const ModernVertex& v) const {
+    uint32_t words[sizeof(ModernVertex) / sizeof(uint32_t)];
+    std::memcpy(words, &v, sizeof(ModernVertex));
+
+    // FNV-1a over 32-bit words, followed by a final avalanche so the low bits are usable as a bucket index.
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (uint32_t w : words) {
+        hash ^= w;
+        hash *= 0x100000001B3ull;
+    }
+
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDull;
+    hash ^= hash >> 33;
+
+    return static_cast<size_t>(hash);
+}
+
+bool ModernVertexBitwiseEqual::operator()(const ModernVertex& a, const ModernVertex& b) const {
+    return std::memcmp(&a, &b, sizeof(ModernVertex)) == 0;
+}
+
+GXPackedVertexFormat::GXPackedVertexFormat() : mStride(4) {
+    for (uint32_t i = 0; i < (uint32_t)EGXAttribute::Attribute_Max; i++) {
+        mSlots[i] = UINT8_MAX;
+    }
+}
+
+GXPackedVertexFormat::GXPackedVertexFormat(const std::vector<EGXAttribute>& vat) : GXPackedVertexFormat() {
+    bool enabled[(uint32_t)EGXAttribute::Attribute_Max] = {};
+
+    for (EGXAttribute attribute : vat) {
+        if ((uint32_t)attribute < (uint32_t)EGXAttribute::Attribute_Max)
+            enabled[(uint32_t)attribute] = true;
+    }
+
+    if (enabled[(uint32_t)EGXAttribute::Position])
+        enabled[(uint32_t)EGXAttribute::PositionMatrixIdx] = true;
+
+    // Pack in attribute order, so that tables listing the same attributes in a different order share a format.
+    for (uint32_t i = 0; i < (uint32_t)EGXAttribute::Attribute_Max; i++) {
+        if (!enabled[i])
+            continue;
+
+        mSlots[i] = static_cast<uint8_t>(mAttributes.size());
+        mAttributes.push_back((EGXAttribute)i);
+    }
+
+    mStride = std::max<uint32_t>(4, (static_cast<uint32_t>(mAttributes.size()) + 3) / 4 * 4);
+}
+
+uint8_t GXPackedVertexFormat::GetSlot(EGXAttribute attribute) const {
+    if ((uint32_t)attribute >= (uint32_t)EGXAttribute::Attribute_Max)
+        return UINT8_MAX;
+
+    return mSlots[(uint32_t)attribute];
+}
+
+void GXPackedVertexFormat::Pack(const GXVertex& vertex, uint16_t* key) const {
+    size_t i = 0;
+
+    for (; i < mAttributes.size(); i++) {
+        key[i] = vertex.GetIndex(mAttributes[i]);
+    }
+
+    // Padding is always the same, so that it doesn't affect comparisons.
+    for (; i < mStride; i++) {
+        key[i] = UINT16_MAX;
+    }
+}
+
+GXVertex GXPackedVertexFormat::Unpack(const uint16_t* key) const {
+    GXVertex vertex;
+
+    for (size_t i = 0; i < mAttributes.size(); i++) {
+        vertex.SetIndex(mAttributes[i], key[i]);
+    }
+
+    return vertex;
+}
+
+GXPackedVertexTable::GXPackedVertexTable(uint32_t stride) : mStride(stride), mCount(0) {
+    if (mStride == 0 || mStride % 4 != 0)
+        throw std::invalid_argument("Packed vertex keys must be a multiple of 4 words long!");
+}
+
+uint32_t GXPackedVertexTable::HashKey(const uint16_t* key, uint32_t stride) {
+    uint64_t hash = 0;
+
+    for (uint32_t i = 0; i < stride; i += 4) {
+        uint64_t word;
+        std::memcpy(&word, key + i, sizeof(word));
+
+        hash = (hash ^ word) * 0x9E3779B97F4A7C15ull;
+        hash ^= hash >> 32;
+    }
+
+    return static_cast<uint32_t>(hash);
+}
+
+bool GXPackedVertexTable::KeysEqual(const uint16_t* a, const uint16_t* b) const {
+    uint64_t wa[2], wb[2];
+
+    switch (mStride) {
+        case 4:
+            std::memcpy(wa, a, 8);
+            std::memcpy(wb, b, 8);
+            return wa[0] == wb[0];
+        case 8:
+            std::memcpy(wa, a, 16);
+            std::memcpy(wb, b, 16);
+            return ((wa[0] ^ wb[0]) | (wa[1] ^ wb[1])) == 0;
+        default:
+            return std::memcmp(a, b, mStride * sizeof(uint16_t)) == 0;
+    }
+}
+
+void GXPackedVertexTable::Rehash(size_t bucketCount) {
+    std::vector<Bucket> buckets(bucketCount, Bucket { UINT32_MAX, 0 });
+    const size_t mask = bucketCount - 1;
+
+    for (const Bucket& bucket : mBuckets) {
+        if (bucket.Id == UINT32_MAX)
+            continue;
+
+        size_t slot = bucket.Hash & mask;
+        while (buckets[slot].Id != UINT32_MAX) {
+            slot = (slot + 1) & mask;
+        }
+
+        buckets[slot] = bucket;
+    }
+
+    mBuckets = std::move(buckets);
+}
+
+void GXPackedVertexTable::Reserve(size_t count) {
+    // Keep the table at most half full.
+    size_t bucketCount = 16;
+    while (bucketCount < count * 2) {
+        bucketCount *= 2;
+    }
+
+    if (bucketCount > mBuckets.size())
+        Rehash(bucketCount);
+
+    mKeys.reserve(count * mStride);
+}
+
+uint32_t GXPackedVertexTable::Insert(const uint16_t* key, bool& inserted) {
+    if ((static_cast<size_t>(mCount) + 1) * 2 > mBuckets.size())
+        Rehash(std::max<size_t>(16, mBuckets.size() * 2));
+
+    const uint32_t hash = HashKey(key, mStride);
+    const size_t mask = mBuckets.size() - 1;
+
+    size_t slot = hash & mask;
+    while (mBuckets[slot].Id != UINT32_MAX) {
+        if (mBuckets[slot].Hash == hash && KeysEqual(GetKey(mBuckets[slot].Id), key)) {
+            inserted = false;
+            return mBuckets[slot].Id;
+        }
+
+        slot = (slot + 1) & mask;
+    }
+
+    mBuckets[slot] = Bucket { mCount, hash };
+    mKeys.insert(mKeys.end(), key, key + mStride);
+
+    inserted = true;
+    return mCount++;
+}
+
+uint32_t GXPackedVertexTable::Find(const uint16_t* key) const {
+    if (mBuckets.empty())
+        return UINT32_MAX;
+
+    const uint32_t hash = HashKey(key, mStride);
+    const size_t mask = mBuckets.size() - 1;
+
+    for (size_t slot = hash & mask; mBuckets[slot].Id != UINT32_MAX; slot = (slot + 1) & mask) {
+        if (mBuckets[slot].Hash == hash && KeysEqual(GetKey(mBuckets[slot].Id), key))
+            return mBuckets[slot].Id;
+    }
+
+    return UINT32_MAX;
+}
+
+void GXPackedVertexTable::Clear(uint32_t stride) {
+    if (stride == 0 || stride % 4 != 0)
+        throw std::invalid_argument("Packed vertex keys must be a multiple of 4 words long!");
+
+    mStride = stride;
+    mKeys.clear();
+    mBuckets.clear();
+    mCount = 0;
+}
+
+void GXVertexCache::SetAttributeTable(const std::vector<EGXAttribute>& vat) {
+    if (vat == mVertexAttributeTable && !mFormat.GetAttributes().empty())
+        return;
+
+    mVertexAttributeTable = vat;
+    mFormat = GXPackedVertexFormat(vat);
+    mTuples.Clear(mFormat.GetStride());
+    mIndices.clear();
+}
+
+uint32_t GXVertexCache::GetIndex(const GXVertex& vertex) {
+    uint16_t key[(uint32_t)EGXAttribute::Attribute_Max + 3];
+    mFormat.Pack(vertex, key);
+
+    return GetIndex(key);
+}
+
+uint32_t GXVertexCache::GetIndex(const uint16_t* key) {
+    bool inserted;
+    uint32_t tuple = mTuples.Insert(key, inserted);
+
+    if (inserted) {
+        mIndices.push_back(static_cast<uint32_t>(mVertices.size()));
+        mVertices.push_back(GXVertexToModern(*mAttributes, mVertexAttributeTable, mFormat.Unpack(key)));
+    }
+
+    return mIndices[tuple];
+}
+
+void GXVertexCache::GetIndices(const std::vector<GXVertex>& vertices, std::vector<uint32_t>& indices) {
+    indices.reserve(indices.size() + vertices.size());
+
+    for (const GXVertex& vertex : vertices) {
+        indices.push_back(GetIndex(vertex));
+    }
+}
+
+void GXVertexCache::Clear() {
+    mTuples.Clear(mFormat.GetStride());
+    mIndices.clear();
+    mVertices.clear();
+}
@@ -0,0 +1,358 @@
+#include "geometry/GXVertexLayout.hpp"
+#include "glm/common.hpp"
+#include "glm/gtc/packing.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+
+uint32_t GXVertexLayout::GetFormatSize(EGXVertexElementFormat format) {
+    switch (format) {
+        case EGXVertexElementFormat::Float1:
+        case EGXVertexElementFormat::UInt32:
+        case EGXVertexElementFormat::OctahedralSNorm16x2:
+        case EGXVertexElementFormat::UNorm8x4:
+        case EGXVertexElementFormat::Half2:
+            return 4;
+        case EGXVertexElementFormat::Float2:
+        case EGXVertexElementFormat::UNorm16x4:
+        case EGXVertexElementFormat::SNorm16x4:
+            return 8;
+        case EGXVertexElementFormat::Float3:
+            return 12;
+        case EGXVertexElementFormat::Float4:
+            return 16;
+        default:
+            return 0;
+    }
+}
+
+uint32_t GXVertexLayout::GetFormatComponentCount(EGXVertexElementFormat format) {
+    switch (format) {
+        case EGXVertexElementFormat::Float1:
+        case EGXVertexElementFormat::UInt32:
+            return 1;
+        case EGXVertexElementFormat::Float2:
+        case EGXVertexElementFormat::OctahedralSNorm16x2:
+        case EGXVertexElementFormat::Half2:
+            return 2;
+        case EGXVertexElementFormat::Float3:
+            return 3;
+        case EGXVertexElementFormat::Float4:
+        case EGXVertexElementFormat::UNorm16x4:
+        case EGXVertexElementFormat::UNorm8x4:
+        case EGXVertexElementFormat::SNorm16x4:
+            return 4;
+        default:
+            return 0;
+    }
+}
+
+GXVertexLayout GXVertexLayout::FromAttributeTables(const std::vector<const std::vector<EGXAttribute>*>& tables, bool quantized,
+                                                   bool tangentFrames) {
+    bool enabled[(uint32_t)EGXAttribute::Attribute_Max] = {};
+
+    for (const std::vector<EGXAttribute>* vat : tables) {
+        for (EGXAttribute attribute : *vat) {
+            if (attribute == EGXAttribute::NBT)
+                attribute = EGXAttribute::Normal;
+
+            if ((uint32_t)attribute < (uint32_t)EGXAttribute::Attribute_Max)
+                enabled[(uint32_t)attribute] = true;
+        }
+    }
+
+    const EGXVertexElementFormat positionFormat = quantized ? EGXVertexElementFormat::UNorm16x4 : EGXVertexElementFormat::Float3;
+    const EGXVertexElementFormat normalFormat = quantized ? EGXVertexElementFormat::OctahedralSNorm16x2 : EGXVertexElementFormat::Float3;
+    const EGXVertexElementFormat colorFormat = quantized ? EGXVertexElementFormat::UNorm8x4 : EGXVertexElementFormat::Float4;
+    const EGXVertexElementFormat texCoordFormat = quantized ? EGXVertexElementFormat::Half2 : EGXVertexElementFormat::Float2;
+
+    GXVertexLayout layout;
+
+    if (enabled[(uint32_t)EGXAttribute::Position])
+        layout.AddElement(EGXAttribute::Position, positionFormat);
+    if (enabled[(uint32_t)EGXAttribute::PositionMatrixIdx])
+        layout.AddElement(EGXAttribute::PositionMatrixIdx, EGXVertexElementFormat::UInt32);
+    if (enabled[(uint32_t)EGXAttribute::Normal])
+        layout.AddElement(EGXAttribute::Normal, normalFormat);
+    if (tangentFrames)
+        layout.AddElement(EGXAttribute::NBT, quantized ? EGXVertexElementFormat::SNorm16x4 : EGXVertexElementFormat::Float4);
+
+    for (uint32_t i = 0; i < 2; i++) {
+        if (enabled[(uint32_t)EGXAttribute::Color0 + i])
+            layout.AddElement((EGXAttribute)((uint32_t)EGXAttribute::Color0 + i), colorFormat);
+    }
+
+    // GX tex coords have at most two components; the third component of ModernVertex::TexCoords is unused.
+    for (uint32_t i = 0; i < 8; i++) {
+        if (enabled[(uint32_t)EGXAttribute::TexCoord0 + i])
+            layout.AddElement((EGXAttribute)((uint32_t)EGXAttribute::TexCoord0 + i), texCoordFormat);
+    }
+
+    return layout;
+}
+
+void GXVertexLayout::AddElement(EGXAttribute attribute, EGXVertexElementFormat format) {
+    mElements.emplace_back(attribute, format, mStride);
+    mStride += GetFormatSize(format);
+}
+
+void GXVertexLayout::AlignStride(uint32_t alignment) {
+    mStride = (mStride + alignment - 1) / alignment * alignment;
+}
+
+const GXVertexElement* GXVertexLayout::FindElement(EGXAttribute attribute) const {
+    for (const GXVertexElement& element : mElements) {
+        if (element.Attribute == attribute)
+            return &element;
+    }
+
+    return nullptr;
+}
+
+// Returns the offset of the given attribute's data within a ModernVertex.
+static size_t GetModernVertexOffset(EGXAttribute attribute) {
+    uint32_t attrAsInt = (uint32_t)attribute;
+
+    switch (attribute) {
+        case EGXAttribute::Position:
+        case EGXAttribute::PositionMatrixIdx:
+            return offsetof(ModernVertex, Position);
+        case EGXAttribute::Normal:
+            return offsetof(ModernVertex, Normal);
+        case EGXAttribute::Color0:
+        case EGXAttribute::Color1:
+            return offsetof(ModernVertex, Colors) + sizeof(glm::vec4) * (attrAsInt - (uint32_t)EGXAttribute::Color0);
+        case EGXAttribute::TexCoord0:
+        case EGXAttribute::TexCoord1:
+        case EGXAttribute::TexCoord2:
+        case EGXAttribute::TexCoord3:
+        case EGXAttribute::TexCoord4:
+        case EGXAttribute::TexCoord5:
+        case EGXAttribute::TexCoord6:
+        case EGXAttribute::TexCoord7:
+            return offsetof(ModernVertex, TexCoords) + sizeof(glm::vec3) * (attrAsInt - (uint32_t)EGXAttribute::TexCoord0);
+        default:
+            throw std::invalid_argument("Vertex layout contains an attribute that ModernVertex does not store!");
+    }
+}
+
+GXDequantizationParams GXCalculateDequantizationParams(const ModernVertex* vertices, size_t count) {
+    GXDequantizationParams params;
+
+    if (count == 0)
+        return params;
+
+    glm::vec3 min(vertices[0].Position);
+    glm::vec3 max(vertices[0].Position);
+
+    for (size_t i = 1; i < count; i++) {
+        min = glm::min(min, glm::vec3(vertices[i].Position));
+        max = glm::max(max, glm::vec3(vertices[i].Position));
+    }
+
+    params.PositionOffset = min;
+    params.PositionScale = max - min;
+
+    return params;
+}
+
+// Returns the position matrix index stored in the given Position.w. Anything that isn't a valid index, including
+// negative values and NaN, becomes UINT16_MAX, the same as a vertex without a position matrix index.
+static uint32_t GetPositionMatrixIndex(float w) {
+    // Written so that NaN fails the test too.
+    if (!(w >= 0.0f && w < static_cast<float>(UINT16_MAX)))
+        return UINT16_MAX;
+
+    return static_cast<uint32_t>(w);
+}
+
+// Returns the given value in the range [0, 1] as a 16-bit unsigned normalized value.
+static uint16_t QuantizeUNorm16(float value) {
+    return static_cast<uint16_t>(std::lround(glm::clamp(value, 0.0f, 1.0f) * 65535.0f));
+}
+
+// Returns the given value in the range [-1, 1] as a 16-bit signed normalized value.
+static int16_t QuantizeSNorm16(float value) {
+    return static_cast<int16_t>(std::lround(glm::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+// Returns the given value in the range [0, 1] as an 8-bit unsigned normalized value.
+static uint8_t QuantizeUNorm8(float value) {
+    return static_cast<uint8_t>(std::lround(glm::clamp(value, 0.0f, 1.0f) * 255.0f));
+}
+
+// Maps the given direction onto the octahedron, unfolded into the range [-1, 1] on both axes.
+static glm::vec2 EncodeOctahedral(const glm::vec3& n) {
+    float length = std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+    if (length == 0.0f)
+        return glm::vec2(0.0f, 0.0f);
+
+    glm::vec2 p(n.x / length, n.y / length);
+
+    if (n.z < 0.0f) {
+        glm::vec2 folded((1.0f - std::fabs(p.y)) * (p.x >= 0.0f ? 1.0f : -1.0f),
+                         (1.0f - std::fabs(p.x)) * (p.y >= 0.0f ? 1.0f : -1.0f));
+        p = folded;
+    }
+
+    return p;
+}
+
+void GXPackVertices(const ModernVertex* vertices, size_t count, const GXVertexLayout& layout, std::vector<uint8_t>& output,
+                    const GXDequantizationParams* params, const glm::vec4* tangentFrames) {
+    // How a single element is moved out of a ModernVertex and into a packed vertex.
+    enum class EOpKind {
+        Copy,
+        FloatToUInt,
+        QuantizePosition,
+        EncodeNormal,
+        QuantizeColor,
+        HalfTexCoord,
+        QuantizeTangentFrame
+    };
+
+    // A single conversion out of a ModernVertex, or the vertex's tangent frame, and into a packed vertex.
+    struct PackOp {
+        EOpKind Kind;
+        size_t Source;
+        uint32_t Destination;
+        uint32_t Size;
+        bool bTangentFrame;
+    };
+
+    // Resolve every element to a conversion up front, so the per-vertex loop doesn't branch on attributes.
+    std::vector<PackOp> ops;
+    for (const GXVertexElement& element : layout.GetElements()) {
+        // Tangent frames aren't part of ModernVertex, and are read from their own array.
+        if (element.Attribute == EGXAttribute::NBT) {
+            if (tangentFrames == nullptr)
+                throw std::invalid_argument("Packing the NBT attribute requires tangent frames!");
+
+            EOpKind kind = element.Format == EGXVertexElementFormat::SNorm16x4 ? EOpKind::QuantizeTangentFrame : EOpKind::Copy;
+            ops.push_back({ kind, 0, element.Offset, GXVertexLayout::GetFormatSize(element.Format), true });
+            continue;
+        }
+
+        size_t source = GetModernVertexOffset(element.Attribute);
+
+        switch (element.Format) {
+            case EGXVertexElementFormat::UInt32:
+                if (element.Attribute != EGXAttribute::PositionMatrixIdx)
+                    throw std::invalid_argument("Only the position matrix index can be packed as an integer!");
+
+                // The position matrix index is stored in the w component of the position.
+                ops.push_back({ EOpKind::FloatToUInt, source + sizeof(float) * 3, element.Offset, 4, false });
+                break;
+            case EGXVertexElementFormat::UNorm16x4:
+                if (params == nullptr)
+                    throw std::invalid_argument("Quantized positions require dequantization parameters!");
+
+                ops.push_back({ EOpKind::QuantizePosition, source, element.Offset, 8, false });
+                break;
+            case EGXVertexElementFormat::OctahedralSNorm16x2:
+                ops.push_back({ EOpKind::EncodeNormal, source, element.Offset, 4, false });
+                break;
+            case EGXVertexElementFormat::UNorm8x4:
+                ops.push_back({ EOpKind::QuantizeColor, source, element.Offset, 4, false });
+                break;
+            case EGXVertexElementFormat::Half2:
+                ops.push_back({ EOpKind::HalfTexCoord, source, element.Offset, 4, false });
+                break;
+            case EGXVertexElementFormat::SNorm16x4:
+                ops.push_back({ EOpKind::QuantizeTangentFrame, source, element.Offset, 8, false });
+                break;
+            default:
+                ops.push_back({ EOpKind::Copy, source, element.Offset, GXVertexLayout::GetFormatSize(element.Format), false });
+                break;
+        }
+    }
+
+    glm::vec3 positionOffset(0.0f);
+    glm::vec3 positionInvScale(0.0f);
+    if (params != nullptr) {
+        positionOffset = params->PositionOffset;
+
+        for (int c = 0; c < 3; c++) {
+            positionInvScale[c] = params->PositionScale[c] != 0.0f ? 1.0f / params->PositionScale[c] : 0.0f;
+        }
+    }
+
+    const uint32_t stride = layout.GetStride();
+    size_t start = output.size();
+    output.resize(start + count * stride);
+
+    uint8_t* dst = output.data() + start;
+    for (size_t i = 0; i < count; i++, dst += stride) {
+        const uint8_t* vertex = reinterpret_cast<const uint8_t*>(&vertices[i]);
+        const uint8_t* frame = tangentFrames != nullptr ? reinterpret_cast<const uint8_t*>(tangentFrames + i) : nullptr;
+
+        for (const PackOp& op : ops) {
+            const uint8_t* src = op.bTangentFrame ? frame : vertex;
+
+            float value[4];
+            std::memcpy(value, src + op.Source, op.Kind == EOpKind::Copy ? op.Size : sizeof(float) * 3);
+
+            switch (op.Kind) {
+                case EOpKind::Copy:
+                    std::memcpy(dst + op.Destination, value, op.Size);
+                    break;
+                case EOpKind::FloatToUInt:
+                {
+                    uint32_t asInt = GetPositionMatrixIndex(value[0]);
+                    std::memcpy(dst + op.Destination, &asInt, sizeof(asInt));
+                    break;
+                }
+                case EOpKind::QuantizePosition:
+                {
+                    uint16_t packed[4] = { 0, 0, 0, 0 };
+                    for (int c = 0; c < 3; c++) {
+                        packed[c] = QuantizeUNorm16((value[c] - positionOffset[c]) * positionInvScale[c]);
+                    }
+
+                    std::memcpy(dst + op.Destination, packed, sizeof(packed));
+                    break;
+                }
+                case EOpKind::EncodeNormal:
+                {
+                    glm::vec2 oct = EncodeOctahedral(glm::vec3(value[0], value[1], value[2]));
+                    int16_t packed[2] = { QuantizeSNorm16(oct.x), QuantizeSNorm16(oct.y) };
+
+                    std::memcpy(dst + op.Destination, packed, sizeof(packed));
+                    break;
+                }
+                case EOpKind::QuantizeColor:
+                {
+                    std::memcpy(value + 3, src + op.Source + sizeof(float) * 3, sizeof(float));
+
+                    uint8_t packed[4];
+                    for (int c = 0; c < 4; c++) {
+                        packed[c] = QuantizeUNorm8(value[c]);
+                    }
+
+                    std::memcpy(dst + op.Destination, packed, sizeof(packed));
+                    break;
+                }
+                case EOpKind::HalfTexCoord:
+                {
+                    uint16_t packed[2] = { glm::packHalf1x16(value[0]), glm::packHalf1x16(value[1]) };
+                    std::memcpy(dst + op.Destination, packed, sizeof(packed));
+                    break;
+                }
+                case EOpKind::QuantizeTangentFrame:
+                {
+                    std::memcpy(value + 3, src + op.Source + sizeof(float) * 3, sizeof(float));
+
+                    int16_t packed[4];
+                    for (int c = 0; c < 4; c++) {
+                        packed[c] = QuantizeSNorm16(value[c]);
+                    }
+
+                    std::memcpy(dst + op.Destination, packed, sizeof(packed));
+                    break;
+                }
+            }
+        }
+    }
+}
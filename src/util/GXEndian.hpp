@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+
+// Helpers for reading the big-endian data used by the GameCube.
+
+// Reads a big-endian 16-bit value from the given address.
+inline uint16_t ReadBE16(const uint8_t* data) {
+    return static_cast<uint16_t>((data[0] << 8) | data[1]);
+}
+
+// Reads a big-endian 32-bit value from the given address.
+inline uint32_t ReadBE32(const uint8_t* data) {
+    return (static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16) |
+           (static_cast<uint32_t>(data[2]) << 8) | static_cast<uint32_t>(data[3]);
+}
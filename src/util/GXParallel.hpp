@@ -0,0 +1,89 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+// Returns the number of threads to use for the given requested count, where 0 means one per hardware thread.
+inline uint32_t ResolveThreadCount(uint32_t requested) {
+    if (requested != 0)
+        return requested;
+
+    uint32_t hardware = std::thread::hardware_concurrency();
+    return hardware != 0 ? hardware : 1;
+}
+
+// Calls func(i) for every i in [0, count), spread across up to threadCount threads (0 for one per hardware thread).
+// Items are handed out one at a time, so items of very different cost still balance across threads.
+// The first exception thrown by func is rethrown on the calling thread once all threads have finished.
+// Threads that can't be started are skipped, and the remaining ones take over their share.
+template<typename Func>
+void ParallelFor(size_t count, uint32_t threadCount, Func func) {
+    size_t workers = std::min<size_t>(ResolveThreadCount(threadCount), count);
+
+    if (workers <= 1) {
+        for (size_t i = 0; i < count; i++) {
+            func(i);
+        }
+
+        return;
+    }
+
+    std::atomic<size_t> next(0);
+    std::exception_ptr error;
+    std::mutex errorMutex;
+
+    auto worker = [&]() {
+        for (size_t i = next++; i < count; i = next++) {
+            try {
+                func(i);
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!error)
+                    error = std::current_exception();
+
+                // Stop handing out work once something has failed.
+                next = count;
+            }
+        }
+    };
+
+    // Joins every started thread on the way out, so that nothing below can destroy a joinable std::thread.
+    struct ThreadJoiner {
+        std::vector<std::thread> Threads;
+
+        ~ThreadJoiner() {
+            for (std::thread& thread : Threads) {
+                thread.join();
+            }
+        }
+    } joiner;
+
+    joiner.Threads.reserve(workers - 1);
+    for (size_t t = 1; t < workers; t++) {
+        // If the system runs out of threads, the ones already started and this one share the work instead.
+        try {
+            joiner.Threads.emplace_back(worker);
+        }
+        catch (const std::system_error&) {
+            break;
+        }
+    }
+
+    worker();
+
+    for (std::thread& thread : joiner.Threads) {
+        thread.join();
+    }
+    joiner.Threads.clear();
+
+    if (error)
+        std::rethrow_exception(error);
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+// Detects which SIMD instruction sets the library is being compiled for.
+// Every vectorized code path in the library must also provide a scalar fallback.
+// Defining LIBFLIPPER_NO_SIMD compiles only the scalar fallbacks, so they can be tested on any machine.
+
+#if !defined(LIBFLIPPER_NO_SIMD)
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LIBFLIPPER_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(__SSSE3__) || defined(__AVX2__)
+#define LIBFLIPPER_SSSE3 1
+#include <tmmintrin.h>
+#endif
+
+#if defined(__AVX2__)
+#define LIBFLIPPER_AVX2 1
+#include <immintrin.h>
+#endif
+
+#endif
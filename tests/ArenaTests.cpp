@@ -0,0 +1,36 @@
+#include "TestCommon.hpp"
+
+// Copies of arena primitives live on the heap or the stack, so they must not be marked as owned by the arena;
+// otherwise a shape holding a heap copy would never free it.
+static void TestCopiesAreNotArenaOwned() {
+    std::shared_ptr<GXGeometryArena> arena = GXGeometryArena::Create();
+
+    GXPrimitive* primitive = arena->CreatePrimitive(EGXPrimitiveType::Triangles);
+    primitive->GetVertices().resize(3);
+    CHECK(primitive->IsArenaOwned());
+
+    GXPrimitive* copy = new GXPrimitive(*primitive);
+    CHECK(!copy->IsArenaOwned() && copy->GetVertices().size() == 3);
+
+    GXPrimitive moved(std::move(*copy));
+    CHECK(!moved.IsArenaOwned() && moved.GetVertices().size() == 3);
+
+    // Assignment keeps each primitive's own ownership.
+    *copy = *primitive;
+    CHECK(!copy->IsArenaOwned());
+
+    GXPrimitive* target = arena->CreatePrimitive(EGXPrimitiveType::Points);
+    *target = moved;
+    CHECK(target->IsArenaOwned() && target->GetType() == EGXPrimitiveType::Triangles);
+
+    // The shape frees the heap copy, and leaves the arena primitives to the arena.
+    std::shared_ptr<GXShape> shape = arena->CreateShape();
+    shape->GetPrimitives() = { primitive, copy, target };
+}
+
+int main() {
+    TestCopiesAreNotArenaOwned();
+
+    std::puts("ArenaTests passed");
+    return 0;
+}
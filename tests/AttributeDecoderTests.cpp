@@ -0,0 +1,224 @@
+#include "SimdTestCommon.hpp"
+
+#include <cmath>
+
+// Returns the given number of random bytes.
+static std::vector<uint8_t> GetRandomBytes(std::mt19937& random, size_t count) {
+    std::vector<uint8_t> bytes(count);
+    for (uint8_t& b : bytes) {
+        b = static_cast<uint8_t>(random());
+    }
+
+    return bytes;
+}
+
+// Decodes one big-endian component of the given type, one byte at a time, with integers divided by 2^shift.
+static float ReferenceComponent(const uint8_t* src, EGXComponentType type, uint32_t shift) {
+    switch (type) {
+        case EGXComponentType::Unsigned8:
+            return std::ldexp(static_cast<float>(src[0]), -static_cast<int>(shift));
+        case EGXComponentType::Signed8:
+            return std::ldexp(static_cast<float>(static_cast<int8_t>(src[0])), -static_cast<int>(shift));
+        case EGXComponentType::Unsigned16:
+            return std::ldexp(static_cast<float>((src[0] << 8) | src[1]), -static_cast<int>(shift));
+        case EGXComponentType::Signed16:
+            return std::ldexp(static_cast<float>(static_cast<int16_t>((src[0] << 8) | src[1])), -static_cast<int>(shift));
+        default:
+        {
+            uint32_t bits = (static_cast<uint32_t>(src[0]) << 24) | (src[1] << 16) | (src[2] << 8) | src[3];
+
+            float value;
+            std::memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+    }
+}
+
+// Returns the size of a component of the given type, in bytes.
+static uint32_t ReferenceComponentSize(EGXComponentType type) {
+    switch (type) {
+        case EGXComponentType::Unsigned8:
+        case EGXComponentType::Signed8:
+            return 1;
+        case EGXComponentType::Unsigned16:
+        case EGXComponentType::Signed16:
+            return 2;
+        default:
+            return 4;
+    }
+}
+
+// Returns whether two float arrays hold the same bits.
+static bool SameBits(const float* a, const float* b, size_t count) {
+    return count == 0 || std::memcmp(a, b, count * sizeof(float)) == 0;
+}
+
+// Every attribute, component type and shift must decode to the same bits as the reference, for counts that
+// exercise both the vector loops and their scalar tails.
+static void TestComponentsMatchReference() {
+    struct ArrayCase {
+        EGXAttribute Attribute;
+        EGXComponentCount Count;
+        // The number of components each element stores, and how many of them are kept.
+        uint32_t SourceComponents;
+        uint32_t UsedComponents;
+    };
+
+    const ArrayCase cases[] = {
+        { EGXAttribute::Position, EGXComponentCount::Position_XY, 2, 2 },
+        { EGXAttribute::Position, EGXComponentCount::Position_XYZ, 3, 3 },
+        { EGXAttribute::Normal, EGXComponentCount::Normal_XYZ, 3, 3 },
+        { EGXAttribute::Normal, EGXComponentCount::Normal_NBT, 9, 3 },
+        { EGXAttribute::TexCoord0, EGXComponentCount::TexCoord_U, 1, 1 },
+        { EGXAttribute::TexCoord3, EGXComponentCount::TexCoord_UV, 2, 2 },
+    };
+
+    const EGXComponentType types[] = {
+        EGXComponentType::Unsigned8, EGXComponentType::Signed8, EGXComponentType::Unsigned16, EGXComponentType::Signed16, EGXComponentType::Float
+    };
+
+    // Shifts past 31 don't fit GX's 5-bit field, and only their low 5 bits are used.
+    const uint8_t shifts[] = { 0, 1, 7, 14, 31, 37, 255 };
+    const size_t counts[] = { 0, 1, 3, 7, 8, 9, 15, 16, 17, 33, 67 };
+
+    std::mt19937 random(7);
+
+    for (const ArrayCase& c : cases) {
+        for (EGXComponentType type : types) {
+            for (uint8_t shift : shifts) {
+                for (size_t count : counts) {
+                    GXVertexAttributeFormat format(c.Attribute, c.Count, type, shift);
+                    const uint32_t componentSize = ReferenceComponentSize(type);
+                    CHECK(GXGetAttributeElementSize(format) == c.SourceComponents * componentSize);
+
+                    std::vector<uint8_t> data = GetRandomBytes(random, count * c.SourceComponents * componentSize);
+
+                    // Normals ignore the format's shift, as the hardware does.
+                    uint32_t usedShift = shift & 31;
+                    if (c.Attribute == EGXAttribute::Normal && type != EGXComponentType::Float)
+                        usedShift = componentSize == 1 ? 6 : 14;
+
+                    // Start from one existing element, to check that decoding appends.
+                    GXAttributeData attributes;
+                    float* decoded = nullptr;
+                    uint32_t stride = 0;
+
+                    std::vector<float> expected;
+                    auto AddExpected = [&](uint32_t destComponents) {
+                        expected.assign(destComponents, 0.5f);
+                        for (size_t i = 0; i < count; i++) {
+                            for (uint32_t d = 0; d < destComponents; d++) {
+                                if (d >= c.UsedComponents) {
+                                    expected.push_back(0.0f);
+                                    continue;
+                                }
+
+                                const uint8_t* src = data.data() + (i * c.SourceComponents + d) * componentSize;
+                                expected.push_back(ReferenceComponent(src, type, usedShift));
+                            }
+                        }
+                    };
+
+                    if (c.Attribute == EGXAttribute::Position) {
+                        attributes.GetPositions().push_back(glm::vec4(0.5f));
+                        GXDecodeAttributeArray(data.data(), count, format, attributes);
+                        decoded = &attributes.GetPositions()[0].x;
+                        stride = 4;
+                        CHECK(attributes.GetPositions().size() == count + 1);
+                    }
+                    else if (c.Attribute == EGXAttribute::Normal) {
+                        attributes.GetNormals().push_back(glm::vec3(0.5f));
+                        GXDecodeAttributeArray(data.data(), count, format, attributes);
+                        decoded = &attributes.GetNormals()[0].x;
+                        stride = 3;
+                        CHECK(attributes.GetNormals().size() == count + 1);
+                    }
+                    else {
+                        uint32_t channel = (uint32_t)c.Attribute - (uint32_t)EGXAttribute::TexCoord0;
+                        attributes.GetTexCoords(channel).push_back(glm::vec3(0.5f));
+                        GXDecodeAttributeArray(data.data(), count, format, attributes);
+                        decoded = &attributes.GetTexCoords(channel)[0].x;
+                        stride = 3;
+                        CHECK(attributes.GetTexCoords(channel).size() == count + 1);
+                    }
+
+                    AddExpected(stride);
+                    CHECK(SameBits(decoded, expected.data(), expected.size()));
+                }
+            }
+        }
+    }
+}
+
+// Every color format must decode to the same colors as reading its channels one at a time, for counts that
+// exercise both the vector loops and their scalar tails.
+static void TestColorsMatchReference() {
+    // The size of each format in bytes, then the shift and bit count of each channel in RGBA order.
+    struct ColorCase {
+        EGXComponentType Type;
+        uint32_t Size;
+        uint32_t Shift[4];
+        uint32_t Bits[4];
+    };
+
+    const ColorCase cases[] = {
+        { EGXComponentType::RGB565, 2, { 11, 5, 0, 0 }, { 5, 6, 5, 0 } },
+        { EGXComponentType::RGB8, 3, { 16, 8, 0, 0 }, { 8, 8, 8, 0 } },
+        { EGXComponentType::RGBX8, 4, { 24, 16, 8, 0 }, { 8, 8, 8, 0 } },
+        { EGXComponentType::RGBA4, 2, { 12, 8, 4, 0 }, { 4, 4, 4, 4 } },
+        { EGXComponentType::RGBA6, 3, { 18, 12, 6, 0 }, { 6, 6, 6, 6 } },
+        { EGXComponentType::RGBA8, 4, { 24, 16, 8, 0 }, { 8, 8, 8, 8 } },
+    };
+
+    const size_t counts[] = { 0, 1, 3, 4, 5, 7, 8, 9, 15, 16, 17, 33, 67 };
+
+    std::mt19937 random(8);
+
+    for (const ColorCase& c : cases) {
+        for (size_t count : counts) {
+            GXVertexAttributeFormat format(EGXAttribute::Color1, EGXComponentCount::Color_RGBA, c.Type, 0);
+            CHECK(GXGetAttributeElementSize(format) == c.Size);
+
+            std::vector<uint8_t> data = GetRandomBytes(random, count * c.Size);
+
+            GXAttributeData attributes;
+            attributes.GetColors(1).push_back(glm::vec4(0.5f));
+            GXDecodeAttributeArray(data.data(), count, format, attributes);
+
+            const std::vector<glm::vec4>& colors = attributes.GetColors(1);
+            CHECK(colors.size() == count + 1 && colors[0] == glm::vec4(0.5f));
+
+            for (size_t i = 0; i < count; i++) {
+                uint32_t packed = 0;
+                for (uint32_t b = 0; b < c.Size; b++) {
+                    packed = (packed << 8) | data[i * c.Size + b];
+                }
+
+                for (int channel = 0; channel < 4; channel++) {
+                    float expected = 1.0f;
+                    if (c.Bits[channel] != 0) {
+                        uint32_t max = (1u << c.Bits[channel]) - 1;
+                        expected = static_cast<float>((packed >> c.Shift[channel]) & max) / static_cast<float>(max);
+                    }
+
+                    // Vector paths multiply by the reciprocal of the channel's maximum instead of dividing by it.
+                    CHECK(std::fabs(colors[i + 1][channel] - expected) <= 1e-6f);
+                }
+            }
+        }
+    }
+}
+
+int main() {
+    const char* path = GetSimdPath();
+    if (path == nullptr) {
+        std::puts("AttributeDecoderTests skipped: this machine can't run the SIMD path they were built for");
+        return 77;
+    }
+
+    TestComponentsMatchReference();
+    TestColorsMatchReference();
+
+    std::printf("AttributeDecoderTests passed on the %s path\n", path);
+    return 0;
+}
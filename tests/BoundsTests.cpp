@@ -0,0 +1,337 @@
+#include "SimdTestCommon.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+// Returns count vertices at random positions, with matrix indices in Position.w that must not affect any bounds.
+static std::vector<ModernVertex> GetRandomVertices(std::mt19937& random, size_t count) {
+    std::uniform_real_distribution<float> coordinate(-100.0f, 100.0f);
+
+    std::vector<ModernVertex> vertices(count);
+    for (ModernVertex& vertex : vertices) {
+        vertex.Position = glm::vec4(coordinate(random), coordinate(random), coordinate(random), static_cast<float>(random() % 1000) * 1e6f);
+    }
+
+    return vertices;
+}
+
+// Returns whether a is within a relative tolerance of b.
+static bool Near(float a, float b, float tolerance) {
+    return std::fabs(a - b) <= tolerance * std::max(1.0f, std::fabs(b));
+}
+
+const size_t COUNTS[] = { 0, 1, 2, 3, 4, 5, 7, 8, 9, 16, 17, 33, 67 };
+
+// Accumulating bounds must grow the given box to exactly the vertices' extremes, and add up the same positions as a
+// plain loop, for counts that exercise both the vector loops and their scalar tails.
+static void TestAccumulateBoundsMatchesReference() {
+    std::mt19937 random(17);
+
+    for (size_t count : COUNTS) {
+        std::vector<ModernVertex> vertices = GetRandomVertices(random, count);
+
+        // Start from bounds left by an earlier call, as CalculateCenterOfMass does for every primitive.
+        glm::vec3 sum(1.0f, 2.0f, 3.0f);
+        GXBoundingBox box(glm::vec3(-1.0f), glm::vec3(1.0f));
+        GXAccumulateBounds(vertices.data(), vertices.size(), sum, box);
+
+        glm::vec3 expectedSum(1.0f, 2.0f, 3.0f);
+        GXBoundingBox expectedBox(glm::vec3(-1.0f), glm::vec3(1.0f));
+        for (const ModernVertex& vertex : vertices) {
+            for (int a = 0; a < 3; a++) {
+                expectedSum[a] += vertex.Position[a];
+                expectedBox.Min[a] = std::min(expectedBox.Min[a], vertex.Position[a]);
+                expectedBox.Max[a] = std::max(expectedBox.Max[a], vertex.Position[a]);
+            }
+        }
+
+        CHECK(box.Min == expectedBox.Min && box.Max == expectedBox.Max);
+
+        // The vector paths add in a different order, so allow for rounding.
+        for (int a = 0; a < 3; a++) {
+            CHECK(Near(sum[a], expectedSum[a], 1e-4f));
+        }
+
+        // An empty box takes the vertices' extremes as they are.
+        glm::vec3 emptySum(0.0f);
+        GXBoundingBox empty;
+        GXAccumulateBounds(vertices.data(), vertices.size(), emptySum, empty);
+        CHECK(empty.IsEmpty() == (count == 0));
+    }
+}
+
+// The largest squared distance must match a plain loop, for counts that exercise both the vector loops and their tails.
+static void TestMaxDistanceMatchesReference() {
+    std::mt19937 random(17);
+    const glm::vec3 center(3.0f, -5.0f, 10.0f);
+
+    for (size_t count : COUNTS) {
+        std::vector<ModernVertex> vertices = GetRandomVertices(random, count);
+
+        float expected = 0.0f;
+        for (const ModernVertex& vertex : vertices) {
+            glm::vec3 d = glm::vec3(vertex.Position) - center;
+            expected = std::max(expected, d.x * d.x + d.y * d.y + d.z * d.z);
+        }
+
+        CHECK(Near(GXCalculateMaxDistanceSquared(vertices.data(), vertices.size(), center), expected, 1e-6f));
+    }
+}
+
+// Every shape's bounds must be the extremes, average and enclosing sphere of its vertices, whether they are calculated
+// while flattening or afterwards, and must be gathered for culling.
+static void TestShapeBoundsEncloseVertices() {
+    GXGeometry flattened, calculated;
+    BuildRandomModel(flattened, 17, 40);
+    BuildRandomModel(calculated, 17, 40);
+
+    GXVertexArrayOptions options;
+    options.WeldVertices = true;
+    calculated.CreateVertexArray(options);
+    calculated.CalculateShapeBounds(4);
+
+    options.CalculateBounds = true;
+    flattened.CreateVertexArray(options);
+
+    CHECK(flattened.GetShapeBounds().Count == flattened.GetShapes().size());
+    CHECK(calculated.GetShapeBounds().Count == calculated.GetShapes().size());
+
+    const std::vector<ModernVertex>& vertices = flattened.GetModelVertices();
+    for (size_t s = 0; s < flattened.GetShapes().size(); s++) {
+        const GXShape& shape = *flattened.GetShapes()[s];
+        const GXShape& other = *calculated.GetShapes()[s];
+
+        uint32_t first, count;
+        shape.GetModelVertexRange(first, count);
+
+        const GXBoundingBox& box = shape.GetBoundingBox();
+        const GXBoundingSphere& sphere = shape.GetBoundingSphere();
+        CHECK(box.Min == other.GetBoundingBox().Min && box.Max == other.GetBoundingBox().Max);
+        CHECK(sphere.Center == other.GetBoundingSphere().Center && sphere.Radius == other.GetBoundingSphere().Radius);
+        CHECK(shape.GetCenterOfMass() == other.GetCenterOfMass());
+
+        if (count == 0) {
+            CHECK(box.IsEmpty());
+            continue;
+        }
+
+        glm::vec3 min(vertices[first].Position), max(vertices[first].Position), sum(0.0f);
+        for (uint32_t v = first; v < first + count; v++) {
+            glm::vec3 p(vertices[v].Position);
+            min = glm::vec3(std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z));
+            max = glm::vec3(std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z));
+            sum += p;
+
+            glm::vec3 d = p - sphere.Center;
+            CHECK(std::sqrt(d.x * d.x + d.y * d.y + d.z * d.z) <= sphere.Radius * 1.0001f + 1e-5f);
+        }
+
+        CHECK(box.Min == min && box.Max == max && sphere.Center == box.GetCenter());
+
+        glm::vec3 average = sum / static_cast<float>(count);
+        for (int a = 0; a < 3; a++) {
+            CHECK(std::fabs(shape.GetCenterOfMass()[a] - average[a]) <= 1e-4f * std::max(1.0f, std::fabs(average[a])));
+        }
+
+        // The gathered arrays hold the box by its centre and extents.
+        const GXBoundsArray& bounds = flattened.GetShapeBounds();
+        CHECK(bounds.CenterX[s] == box.GetCenter().x && bounds.ExtentY[s] == box.GetExtents().y && bounds.Radius[s] >= sphere.Radius);
+    }
+}
+
+// Returns whether the given point is inside every plane of the frustum.
+static bool Inside(const GXFrustum& frustum, const glm::vec3& p) {
+    for (const glm::vec4& plane : frustum.Planes) {
+        if (plane.x * p.x + plane.y * p.y + plane.z * p.z + plane.w < 0.0f)
+            return false;
+    }
+
+    return true;
+}
+
+// The planes of a perspective frustum must keep the points in front of the camera and between the clip planes,
+// in both clip-space depth conventions.
+static void TestFrustumFromMatrix() {
+    const glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 10.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+    for (bool zeroToOne : { false, true }) {
+        glm::mat4 projection = zeroToOne ? glm::perspectiveRH_ZO(glm::radians(90.0f), 1.0f, 1.0f, 100.0f)
+                                         : glm::perspectiveRH_NO(glm::radians(90.0f), 1.0f, 1.0f, 100.0f);
+        GXFrustum frustum = GXFrustum::FromMatrix(projection * view, zeroToOne);
+
+        for (const glm::vec4& plane : frustum.Planes) {
+            CHECK(std::fabs(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z - 1.0f) <= 1e-5f);
+        }
+
+        CHECK(Inside(frustum, glm::vec3(0.0f)));
+        CHECK(Inside(frustum, glm::vec3(0.0f, 0.0f, 8.5f)));
+        CHECK(Inside(frustum, glm::vec3(0.0f, 0.0f, -89.0f)));
+        CHECK(Inside(frustum, glm::vec3(9.0f, -9.0f, 0.0f)));
+
+        CHECK(!Inside(frustum, glm::vec3(0.0f, 0.0f, 9.5f)));
+        CHECK(!Inside(frustum, glm::vec3(0.0f, 0.0f, 20.0f)));
+        CHECK(!Inside(frustum, glm::vec3(0.0f, 0.0f, -91.0f)));
+        CHECK(!Inside(frustum, glm::vec3(11.0f, 0.0f, 0.0f)));
+        CHECK(!Inside(frustum, glm::vec3(0.0f, -11.0f, 0.0f)));
+    }
+}
+
+// Batch culling must match testing each object on its own: an object is culled when its box or its sphere is
+// entirely behind some plane. Empty objects and padding are always culled.
+static void TestCullBoundsMatchesReference() {
+    const glm::mat4 viewProjection = glm::perspectiveRH_NO(glm::radians(60.0f), 1.5f, 0.5f, 50.0f) *
+                                     glm::lookAt(glm::vec3(3.0f, 2.0f, 20.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    const GXFrustum frustum = GXFrustum::FromMatrix(viewProjection);
+
+    std::mt19937 random(18);
+    std::uniform_real_distribution<float> coordinate(-40.0f, 40.0f);
+    std::uniform_real_distribution<float> size(0.0f, 8.0f);
+
+    for (size_t count : COUNTS) {
+        GXBoundsArray bounds;
+        bounds.Resize(count);
+        CHECK(bounds.CenterX.size() % 4 == 0 && bounds.CenterX.size() >= count);
+
+        std::vector<GXBoundingBox> boxes(count);
+        std::vector<GXBoundingSphere> spheres(count);
+        for (size_t i = 0; i < count; i++) {
+            glm::vec3 center(coordinate(random), coordinate(random), coordinate(random));
+            glm::vec3 extents(size(random), size(random), size(random));
+
+            // Every seventh object is empty.
+            if (i % 7 != 3)
+                boxes[i] = GXBoundingBox(center - extents, center + extents);
+
+            // Spheres centred off the box are widened to its centre when stored.
+            spheres[i] = GXBoundingSphere(center + glm::vec3(0.0f, size(random) * 0.1f, 0.0f), size(random) * 1.8f);
+            bounds.Set(i, boxes[i], spheres[i]);
+        }
+
+        std::vector<uint32_t> visibleBits((count + 31) / 32 + 1, 0xFFFFFFFF);
+        GXCullBounds(bounds, frustum, visibleBits.data());
+
+        // Only the words for count objects are written.
+        CHECK(visibleBits.back() == 0xFFFFFFFF);
+
+        for (size_t i = 0; i < visibleBits.size() * 32 - 32; i++) {
+            bool visible = (visibleBits[i / 32] >> (i % 32)) & 1;
+
+            bool expected = false;
+            if (i < count && !boxes[i].IsEmpty()) {
+                glm::vec3 center = boxes[i].GetCenter();
+                glm::vec3 extents = boxes[i].GetExtents();
+                glm::vec3 offset = spheres[i].Center - center;
+                double radius = spheres[i].Radius + std::sqrt(static_cast<double>(glm::dot(offset, offset)));
+
+                expected = true;
+                for (const glm::vec4& plane : frustum.Planes) {
+                    double distance = static_cast<double>(plane.x) * center.x + static_cast<double>(plane.y) * center.y +
+                                      static_cast<double>(plane.z) * center.z + plane.w;
+                    double reach = std::fabs(static_cast<double>(plane.x)) * extents.x + std::fabs(static_cast<double>(plane.y)) * extents.y +
+                                   std::fabs(static_cast<double>(plane.z)) * extents.z;
+
+                    if (distance + std::min(reach, radius) < 0.0)
+                        expected = false;
+                }
+            }
+
+            CHECK(visible == expected);
+        }
+    }
+}
+
+// Returns whether every vertex of the given shape is behind the same plane of the frustum.
+static bool CertainlyOutside(const GXGeometry& geometry, const GXShape& shape, const GXFrustum& frustum) {
+    uint32_t first, count;
+    shape.GetModelVertexRange(first, count);
+
+    for (const glm::vec4& plane : frustum.Planes) {
+        bool allBehind = true;
+        for (uint32_t v = first; v < first + count && allBehind; v++) {
+            const glm::vec4& p = geometry.GetModelVertices()[v].Position;
+            allBehind = plane.x * p.x + plane.y * p.y + plane.z * p.z + plane.w < 0.0f;
+        }
+
+        if (allBehind)
+            return true;
+    }
+
+    return false;
+}
+
+// Culling a model's shapes must set their visible flags to the batch result, keep every shape with a vertex inside
+// the frustum, and cull shapes far outside of it. An instance's model matrix moves the frustum into model space.
+static void TestCullShapes() {
+    GXGeometry geometry;
+    BuildRandomModel(geometry, 18, 40);
+
+    GXVertexArrayOptions options;
+    options.WeldVertices = true;
+    geometry.CreateVertexArray(options);
+
+    GXFrustum frustum = GXFrustum::FromMatrix(glm::ortho(-1.0f, 1.0f, -1.0f, 1.0f, -100.0f, 100.0f));
+
+    bool bThrew = false;
+    try {
+        geometry.CullShapes(frustum);
+    }
+    catch (const std::runtime_error&) {
+        bThrew = true;
+    }
+    CHECK(bThrew);
+
+    geometry.CalculateShapeBounds();
+
+    // Most shapes lie in their own plane z = s, so a slab of z values keeps only the shapes that reach into it.
+    const glm::mat4 projection = glm::ortho(-100.0f, 100.0f, -100.0f, 100.0f, -100.0f, 100.0f);
+    const glm::mat4 models[] = { glm::mat4(1.0f), glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -20.0f)) };
+
+    for (const glm::mat4& model : models) {
+        const glm::mat4 slab = glm::ortho(-100.0f, 100.0f, -100.0f, 100.0f, -20.5f, -10.5f) * model;
+        frustum = GXFrustum::FromMatrix(slab);
+
+        std::vector<uint32_t> visibleBits;
+        geometry.CullShapes(frustum, visibleBits);
+        CHECK(visibleBits.size() == (geometry.GetShapes().size() + 31) / 32);
+
+        uint32_t visibleCount = geometry.CullShapes(frustum);
+        uint32_t culled = 0;
+        uint32_t counted = 0;
+
+        for (size_t s = 0; s < geometry.GetShapes().size(); s++) {
+            const GXShape& shape = *geometry.GetShapes()[s];
+            bool visible = (visibleBits[s / 32] >> (s % 32)) & 1;
+
+            CHECK(shape.GetVisible() == visible);
+            CHECK(visible || CertainlyOutside(geometry, shape, frustum));
+
+            counted += visible;
+            culled += !visible;
+        }
+
+        CHECK(visibleCount == counted && counted > 0 && culled > 0);
+    }
+
+    // Everything is inside a frustum that encloses the whole model.
+    CHECK(geometry.CullShapes(GXFrustum::FromMatrix(projection)) == geometry.GetShapes().size());
+}
+
+int main() {
+    const char* path = GetSimdPath();
+    if (path == nullptr) {
+        std::puts("BoundsTests skipped: this machine can't run the SIMD path they were built for");
+        return 77;
+    }
+
+    TestAccumulateBoundsMatchesReference();
+    TestMaxDistanceMatchesReference();
+    TestShapeBoundsEncloseVertices();
+    TestFrustumFromMatrix();
+    TestCullBoundsMatchesReference();
+    TestCullShapes();
+
+    std::printf("BoundsTests passed on the %s path\n", path);
+    return 0;
+}
@@ -0,0 +1,66 @@
+#include "TestCommon.hpp"
+
+// Feeding a model's primitives through a builder must give exactly what CreateVertexArray gives for them,
+// with and without welding, for primitives stored as vertices and in index form.
+static void TestBuilderMatchesCreateVertexArray() {
+    for (bool weld : { false, true }) {
+        GXGeometry flattened, built;
+        BuildRandomModel(flattened, 4, 30);
+        built.GetAttributeData() = flattened.GetAttributeData();
+
+        // Both models start with loose triangles, which each must leave where they are.
+        std::vector<ModernVertex> loose(6);
+        for (size_t i = 0; i < loose.size(); i++) {
+            loose[i].Position = glm::vec4(static_cast<float>(i % 3), 9.0f, 9.0f, 0.0f);
+        }
+
+        flattened.AddVertices(loose);
+        built.AddVertices(loose.data(), loose.size());
+
+        GXVertexArrayOptions options;
+        options.WeldVertices = weld;
+        flattened.CreateVertexArray(options);
+
+        GXGeometryBuilder builder(built, weld);
+        for (const std::shared_ptr<GXShape>& shape : flattened.GetShapes()) {
+            builder.BeginShape(shape->GetAttributeTable());
+
+            for (const GXPrimitive* primitive : shape->GetPrimitives()) {
+                if (primitive->IsIndexed())
+                    builder.AddPrimitive(*primitive);
+                else
+                    builder.AddPrimitive(primitive->GetType(), primitive->GetVertices());
+            }
+        }
+
+        builder.EndShape();
+
+        CHECK(flattened.GetModelIndices().size() > 6);
+        CHECK(SameFlattenedModel(flattened, built));
+    }
+}
+
+// Appending a vertex count that isn't a whole number of triangles must be refused.
+static void TestAddVerticesRejectsPartialTriangles() {
+    GXGeometry geometry;
+    std::vector<ModernVertex> vertices(4);
+
+    bool bThrew = false;
+    try {
+        geometry.AddVertices(vertices);
+    }
+    catch (const std::invalid_argument&) {
+        bThrew = true;
+    }
+
+    CHECK(bThrew);
+    CHECK(geometry.GetModelIndices().empty() && geometry.GetModelVertices().empty());
+}
+
+int main() {
+    TestBuilderMatchesCreateVertexArray();
+    TestAddVerticesRejectsPartialTriangles();
+
+    std::puts("BuilderTests passed");
+    return 0;
+}
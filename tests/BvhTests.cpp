@@ -0,0 +1,88 @@
+#include "TestCommon.hpp"
+
+// Fills the model with a single shape made of the given triangles, and flattens it.
+static void BuildTriangles(GXGeometry& geometry, const std::vector<glm::vec3>& corners) {
+    std::vector<ModernVertex> vertices(corners.size());
+    for (size_t i = 0; i < corners.size(); i++) {
+        vertices[i].Position = glm::vec4(corners[i], 0.0f);
+    }
+
+    std::shared_ptr<GXShape> shape = std::make_shared<GXShape>();
+    shape->GetAttributeTable() = { EGXAttribute::Position };
+
+    GXPrimitive* primitive = new GXPrimitive(EGXPrimitiveType::Triangles);
+    primitive->GetVertices() = vertices;
+    shape->GetPrimitives().push_back(primitive);
+
+    geometry.GetShapes().push_back(shape);
+    geometry.CreateVertexArray();
+}
+
+// An axis-aligned ray starting on the plane of a box face must still enter the box, rather than being lost to NaN
+// from multiplying zero by an infinite inverse direction.
+static void TestAxisAlignedRayOnBoxFace() {
+    GXGeometry geometry;
+    BuildTriangles(geometry, { glm::vec3(2, 0, 0), glm::vec3(2, 0, 2), glm::vec3(4, 0, 1),
+                               glm::vec3(-3, 1, -3), glm::vec3(-3, 1, -2), glm::vec3(-2, 1, -3) });
+
+    GXBvh bvh;
+    bvh.Build(geometry);
+
+    GXBvhHit hit;
+    CHECK(bvh.Raycast(glm::vec3(2, 5, 1), glm::vec3(0, -1, 0), 100.0f, hit));
+    CHECK(hit.Triangle == 0 && hit.Distance == 5.0f);
+
+    CHECK(bvh.Raycast(glm::vec3(3, 5, 1), glm::vec3(0, -1, 0), 100.0f, hit));
+    CHECK(bvh.Raycast(glm::vec3(-3, 5, -2.5f), glm::vec3(0, -1, 0), 100.0f, hit));
+    CHECK(hit.Triangle == 1 && hit.Distance == 4.0f);
+
+    CHECK(!bvh.Raycast(glm::vec3(1.5f, 5, 1), glm::vec3(0, -1, 0), 100.0f, hit));
+}
+
+// The hierarchy must come out the same on any number of threads, so that results never depend on the machine.
+static void TestThreadCountDoesNotChangeNodes() {
+    std::mt19937 random(19);
+    std::uniform_real_distribution<float> coordinate(-50.0f, 50.0f);
+    std::uniform_real_distribution<float> offset(-2.0f, 2.0f);
+
+    std::vector<glm::vec3> corners;
+    for (int t = 0; t < 20000; t++) {
+        glm::vec3 center(coordinate(random), coordinate(random), coordinate(random));
+        for (int c = 0; c < 3; c++) {
+            corners.push_back(center + glm::vec3(offset(random), offset(random), offset(random)));
+        }
+    }
+
+    GXGeometry geometry;
+    BuildTriangles(geometry, corners);
+
+    GXBvh single;
+    single.Build(geometry, 1);
+    CHECK(single.GetTriangleCount() == 20000 && single.GetNodes().size() > 1000);
+
+    for (uint32_t threads : { 2u, 4u, 7u, 0u }) {
+        GXBvh threaded;
+        threaded.Build(geometry, threads);
+
+        const std::vector<GXBvhNode>& a = single.GetNodes();
+        const std::vector<GXBvhNode>& b = threaded.GetNodes();
+        CHECK(a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(GXBvhNode)) == 0);
+
+        for (int r = 0; r < 64; r++) {
+            glm::vec3 origin(coordinate(random), coordinate(random), 100.0f);
+
+            GXBvhHit hitA, hitB;
+            bool bHitA = single.Raycast(origin, glm::vec3(0.0f, 0.0f, -1.0f), 200.0f, hitA);
+            bool bHitB = threaded.Raycast(origin, glm::vec3(0.0f, 0.0f, -1.0f), 200.0f, hitB);
+            CHECK(bHitA == bHitB && hitA.Triangle == hitB.Triangle && hitA.Distance == hitB.Distance);
+        }
+    }
+}
+
+int main() {
+    TestAxisAlignedRayOnBoxFace();
+    TestThreadCountDoesNotChangeNodes();
+
+    std::puts("BvhTests passed");
+    return 0;
+}
@@ -0,0 +1,137 @@
+#include "TestCommon.hpp"
+
+#include <stdexcept>
+
+// The vertex descriptor the tests decode with: a direct position matrix index, 8-bit position indices
+// and 16-bit color indices, for a vertex stride of 4 bytes.
+static std::vector<GXVertexDescriptor> GetDescriptors() {
+    return {
+        GXVertexDescriptor(EGXAttribute::Color0, EGXAttributeIndexType::Index16),
+        GXVertexDescriptor(EGXAttribute::Position, EGXAttributeIndexType::Index8),
+        GXVertexDescriptor(EGXAttribute::PositionMatrixIdx, EGXAttributeIndexType::Direct)
+    };
+}
+
+// Fills the attribute data with four positions and two colors.
+static void FillAttributes(GXAttributeData& attributes) {
+    for (uint32_t i = 0; i < 4; i++) {
+        attributes.GetPositions().push_back(glm::vec4(static_cast<float>(i), 1.0f, 2.0f, 0.0f));
+    }
+    for (uint32_t i = 0; i < 2; i++) {
+        attributes.GetColors(0).push_back(glm::vec4(static_cast<float>(i), 0.0f, 0.0f, 1.0f));
+    }
+}
+
+// Appends a vertex in the layout of GetDescriptors: matrix index, position index, then big-endian color index.
+static void AddVertex(std::vector<uint8_t>& list, uint8_t matrix, uint8_t position, uint16_t color) {
+    list.insert(list.end(), { matrix, position, static_cast<uint8_t>(color >> 8), static_cast<uint8_t>(color & 0xFF) });
+}
+
+// Returns a display list holding a NOP, a BP register load and one triangle, whose last vertex uses the given position index.
+static std::vector<uint8_t> MakeTriangleList(uint8_t lastPosition) {
+    std::vector<uint8_t> list = { 0x00, 0x61, 0x12, 0x34, 0x56, 0x78 };
+
+    list.insert(list.end(), { static_cast<uint8_t>(EGXPrimitiveType::Triangles), 0x00, 0x03 });
+    AddVertex(list, 3, 0, 1);
+    AddVertex(list, 6, 1, 0);
+    AddVertex(list, 9, lastPosition, 1);
+
+    return list;
+}
+
+// Returns whether calling the given function throws std::out_of_range.
+template<typename Func>
+static bool ThrowsOutOfRange(Func func) {
+    try {
+        func();
+    }
+    catch (const std::out_of_range&) {
+        return true;
+    }
+
+    return false;
+}
+
+// A well-formed list decodes into the attributes it stores, in index form and converted.
+static void TestDecodeTriangle() {
+    GXDisplayListDecoder decoder(GetDescriptors());
+    CHECK(decoder.GetVertexStride() == 4);
+
+    std::vector<uint8_t> list = MakeTriangleList(2);
+
+    std::vector<GXDisplayListPrimitive> primitives;
+    decoder.Decode(list.data(), list.size(), primitives);
+
+    CHECK(primitives.size() == 1 && primitives[0].Type == EGXPrimitiveType::Triangles && primitives[0].Vertices.size() == 3);
+    CHECK(primitives[0].Vertices[2].GetIndex(EGXAttribute::PositionMatrixIdx) == 9);
+    CHECK(primitives[0].Vertices[2].GetIndex(EGXAttribute::Position) == 2);
+    CHECK(primitives[0].Vertices[2].GetIndex(EGXAttribute::Color0) == 1);
+
+    GXAttributeData attributes;
+    FillAttributes(attributes);
+    GXVertexCache cache(attributes);
+
+    GXShape shape;
+    decoder.DecodeShape(list.data(), list.size(), cache, shape);
+
+    CHECK(shape.GetPrimitives().size() == 1);
+    const std::vector<ModernVertex>& vertices = shape.GetPrimitives()[0]->GetVertices();
+    CHECK(vertices.size() == 3);
+    CHECK(vertices[1].Position == glm::vec4(1.0f, 1.0f, 2.0f, 6.0f));
+    CHECK(vertices[1].Colors[0] == glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+}
+
+// An index past the end of its attribute array must throw on every path, rather than be read.
+static void TestOutOfRangeIndexThrows() {
+    GXDisplayListDecoder decoder(GetDescriptors());
+    std::vector<uint8_t> list = MakeTriangleList(4);
+
+    GXAttributeData attributes;
+    FillAttributes(attributes);
+
+    std::vector<GXDisplayListPrimitive> primitives;
+    CHECK(ThrowsOutOfRange([&] { decoder.Decode(list.data(), list.size(), primitives, &attributes); }));
+
+    GXVertexCache cache(attributes);
+    GXShape converted;
+    CHECK(ThrowsOutOfRange([&] { decoder.DecodeShape(list.data(), list.size(), cache, converted); }));
+
+    GXShape indexed;
+    CHECK(ThrowsOutOfRange([&] { decoder.DecodeShape(list.data(), list.size(), indexed, nullptr, &attributes); }));
+
+    // Without attribute data to check against, the index is caught once the vertex array converts it.
+    GXGeometry geometry;
+    FillAttributes(geometry.GetAttributeData());
+
+    std::shared_ptr<GXShape> shape = std::make_shared<GXShape>();
+    decoder.DecodeShape(list.data(), list.size(), *shape);
+    geometry.GetShapes().push_back(shape);
+
+    CHECK(ThrowsOutOfRange([&] { geometry.CreateVertexArray(); }));
+}
+
+// Opcode 0x88 has a primitive's bit pattern but isn't a GX primitive type, so it must not be decoded as one.
+static void TestUnknownPrimitiveOpcodeThrows() {
+    GXDisplayListDecoder decoder(GetDescriptors());
+    std::vector<uint8_t> list = { 0x88, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00 };
+
+    std::vector<GXDisplayListPrimitive> primitives;
+    bool bThrew = false;
+    try {
+        decoder.Decode(list.data(), list.size(), primitives);
+    }
+    catch (const std::runtime_error&) {
+        bThrew = true;
+    }
+
+    CHECK(bThrew && primitives.empty());
+}
+
+int main() {
+    TestDecodeTriangle();
+    TestOutOfRangeIndexThrows();
+    TestUnknownPrimitiveOpcodeThrows();
+
+    std::puts("DisplayListTests passed");
+    return 0;
+}
@@ -0,0 +1,115 @@
+#include "TestCommon.hpp"
+
+// Returns a vertex at the given position, using the given position matrix index.
+static ModernVertex MakeVertex(float x, float y, uint32_t matrix) {
+    ModernVertex vertex;
+    vertex.Position = glm::vec4(x, y, 0.0f, static_cast<float>(matrix));
+    return vertex;
+}
+
+// Adds a shape to the model through a builder, made of a strip of quads whose corners use a different matrix each.
+static void AddSkinnedShape(GXGeometry& geometry, float y, uint32_t quadCount) {
+    GXGeometryBuilder builder(geometry);
+    builder.BeginShape({ EGXAttribute::PositionMatrixIdx, EGXAttribute::Position });
+
+    std::vector<ModernVertex> strip;
+    for (uint32_t i = 0; i <= quadCount; i++) {
+        strip.push_back(MakeVertex(static_cast<float>(i), y, i * 3));
+        strip.push_back(MakeVertex(static_cast<float>(i), y + 1.0f, i * 3));
+    }
+
+    builder.AddPrimitive(EGXPrimitiveType::TriangleStrips, strip);
+}
+
+// Returns the positions of the model's triangle corners, in order.
+static std::vector<glm::vec3> GetTrianglePositions(const GXGeometry& geometry, uint32_t first, uint32_t count) {
+    std::vector<glm::vec3> positions;
+    for (uint32_t i = first; i < first + count; i++) {
+        positions.push_back(glm::vec3(geometry.GetModelVertices()[geometry.GetModelIndices()[i]].Position));
+    }
+
+    return positions;
+}
+
+// Data that AddVertices puts between two shapes must survive partitioning, and must keep welding onto itself.
+static void TestLooseTrianglesBetweenShapesSurvive() {
+    GXGeometry geometry;
+    AddSkinnedShape(geometry, 0.0f, 6);
+
+    std::vector<ModernVertex> loose = { MakeVertex(20, 20, 0), MakeVertex(21, 20, 0), MakeVertex(20, 21, 0) };
+    uint32_t looseOffset = geometry.AddVertices(loose);
+
+    AddSkinnedShape(geometry, 5.0f, 6);
+
+    uint32_t firstB, countB;
+    geometry.GetShapes()[1]->GetVertexOffsetAndCount(firstB, countB);
+    std::vector<glm::vec3> shapeB = GetTrianglePositions(geometry, firstB, countB);
+
+    geometry.PartitionMatrixPalettes(3);
+
+    std::vector<glm::vec3> loosePositions = { glm::vec3(20, 20, 0), glm::vec3(21, 20, 0), glm::vec3(20, 21, 0) };
+    uint32_t firstA, countA;
+    geometry.GetShapes()[0]->GetVertexOffsetAndCount(firstA, countA);
+    CHECK(firstA + countA + 3 == static_cast<uint32_t>(geometry.GetModelIndices().size()) - countB);
+    CHECK(GetTrianglePositions(geometry, firstA + countA, 3) == loosePositions);
+    CHECK(looseOffset == firstA + countA);
+
+    geometry.GetShapes()[1]->GetVertexOffsetAndCount(firstB, countB);
+    CHECK(GetTrianglePositions(geometry, firstB, countB) == shapeB);
+
+    // Adding the same vertices again must weld them onto the loose triangle, not onto whatever moved into its place.
+    uint32_t again = geometry.AddVertices(loose);
+    CHECK(GetTrianglePositions(geometry, again, 3) == loosePositions);
+    CHECK(std::equal(geometry.GetModelIndices().begin() + again, geometry.GetModelIndices().end(), geometry.GetModelIndices().begin() + firstA + countA));
+}
+
+// Skinning must give the same positions for every triangle corner whether or not the palettes have been partitioned,
+// and partitioning twice must be refused rather than reading palette slots as matrix indices.
+static void TestSkinningFollowsDrawPalettes() {
+    GXGeometry geometry;
+    AddSkinnedShape(geometry, 0.0f, 8);
+
+    std::vector<glm::mat4> matrices(3 * 9);
+    for (size_t m = 0; m < matrices.size(); m++) {
+        matrices[m] = glm::mat4(1.0f);
+        matrices[m][3] = glm::vec4(0.0f, 0.0f, static_cast<float>(m), 1.0f);
+    }
+
+    GXSkinPalette palette;
+    palette.SetMatrices(matrices);
+
+    // Returns the skinned position of every triangle corner, in order.
+    auto SkinCorners = [&]() {
+        std::vector<glm::vec3> positions, normals, corners;
+        geometry.SkinVertices(palette, positions, normals);
+
+        for (uint32_t index : geometry.GetModelIndices()) {
+            corners.push_back(positions[index]);
+        }
+
+        return corners;
+    };
+
+    std::vector<glm::vec3> before = SkinCorners();
+    geometry.PartitionMatrixPalettes(3);
+
+    CHECK(geometry.GetShapes()[0]->GetDraws().size() > 1);
+    CHECK(SkinCorners() == before);
+
+    bool bThrew = false;
+    try {
+        geometry.PartitionMatrixPalettes(3);
+    }
+    catch (const std::runtime_error&) {
+        bThrew = true;
+    }
+    CHECK(bThrew);
+}
+
+int main() {
+    TestLooseTrianglesBetweenShapesSurvive();
+    TestSkinningFollowsDrawPalettes();
+
+    std::puts("MatrixPaletteTests passed");
+    return 0;
+}
@@ -0,0 +1,253 @@
+#include "TestCommon.hpp"
+
+#include <algorithm>
+#include <array>
+
+// A triangle by the positions of its corners, rotated so the smallest comes first, which keeps its winding.
+typedef std::array<float, 9> TriangleKey;
+
+// Fills the model with shapeCount shapes, each a size by size grid of quads whose triangles are in random order,
+// and flattens it with welding so the triangles share their vertices.
+static void BuildShuffledGrids(GXGeometry& geometry, uint32_t seed, size_t shapeCount, uint32_t size) {
+    std::mt19937 random(seed);
+
+    for (size_t s = 0; s < shapeCount; s++) {
+        std::vector<std::array<ModernVertex, 3>> triangles;
+
+        for (uint32_t y = 0; y < size; y++) {
+            for (uint32_t x = 0; x < size; x++) {
+                ModernVertex corners[4];
+                for (uint32_t c = 0; c < 4; c++) {
+                    corners[c].Position = glm::vec4(static_cast<float>(x + c % 2), static_cast<float>(y + c / 2), static_cast<float>(s), 0.0f);
+                    corners[c].Normal = glm::vec3(0.0f, 0.0f, 1.0f);
+                }
+
+                triangles.push_back({ corners[0], corners[1], corners[2] });
+                triangles.push_back({ corners[2], corners[1], corners[3] });
+            }
+        }
+
+        std::shuffle(triangles.begin(), triangles.end(), random);
+
+        std::shared_ptr<GXShape> shape = std::make_shared<GXShape>();
+        shape->GetAttributeTable() = { EGXAttribute::Position, EGXAttribute::Normal };
+
+        GXPrimitive* primitive = new GXPrimitive(EGXPrimitiveType::Triangles);
+        for (const std::array<ModernVertex, 3>& triangle : triangles) {
+            primitive->GetVertices().insert(primitive->GetVertices().end(), triangle.begin(), triangle.end());
+        }
+        shape->GetPrimitives().push_back(primitive);
+
+        geometry.GetShapes().push_back(shape);
+    }
+
+    GXVertexArrayOptions options;
+    options.WeldVertices = true;
+    geometry.CreateVertexArray(options);
+}
+
+// Returns the sorted triangles of the given shape, by position, after checking that every index stays in the
+// shape's model vertex range.
+static std::vector<TriangleKey> GetShapeTriangles(const GXGeometry& geometry, size_t s) {
+    const GXShape& shape = *geometry.GetShapes()[s];
+
+    uint32_t offset, count, firstVertex, vertexCount;
+    shape.GetVertexOffsetAndCount(offset, count);
+    shape.GetModelVertexRange(firstVertex, vertexCount);
+    CHECK(count % 3 == 0);
+
+    std::vector<TriangleKey> triangles;
+    for (uint32_t t = offset; t < offset + count; t += 3) {
+        std::array<glm::vec3, 3> corners;
+        for (uint32_t c = 0; c < 3; c++) {
+            uint32_t index = geometry.GetModelIndices()[t + c];
+            CHECK(index >= firstVertex && index < firstVertex + vertexCount);
+            corners[c] = glm::vec3(geometry.GetModelVertices()[index].Position);
+        }
+
+        auto Less = [](const glm::vec3& a, const glm::vec3& b) {
+            return a.x != b.x ? a.x < b.x : a.y != b.y ? a.y < b.y : a.z < b.z;
+        };
+        std::rotate(corners.begin(), std::min_element(corners.begin(), corners.end(), Less), corners.end());
+
+        TriangleKey key;
+        for (uint32_t c = 0; c < 3; c++) {
+            key[c * 3 + 0] = corners[c].x;
+            key[c * 3 + 1] = corners[c].y;
+            key[c * 3 + 2] = corners[c].z;
+        }
+        triangles.push_back(key);
+    }
+
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+// Returns the sorted triangles of every shape.
+static std::vector<std::vector<TriangleKey>> GetModelTriangles(const GXGeometry& geometry) {
+    std::vector<std::vector<TriangleKey>> triangles;
+    for (size_t s = 0; s < geometry.GetShapes().size(); s++) {
+        triangles.push_back(GetShapeTriangles(geometry, s));
+    }
+
+    return triangles;
+}
+
+// Returns the simulated cache behaviour of every shape's triangles, each starting on an empty cache.
+static GXVertexCacheStats AnalyzeModel(const GXGeometry& geometry, uint32_t cacheSize) {
+    GXVertexCacheStats stats;
+    for (const std::shared_ptr<GXShape>& shape : geometry.GetShapes()) {
+        uint32_t offset, count;
+        shape->GetVertexOffsetAndCount(offset, count);
+        stats += GXAnalyzeVertexCache(geometry.GetModelIndices().data() + offset, count, cacheSize);
+    }
+
+    return stats;
+}
+
+// Optimizing shuffled grids must keep every shape's triangles, and bring the cache miss ratio down close to ideal.
+static void TestVertexCacheLowersACMR() {
+    GXGeometry geometry;
+    BuildShuffledGrids(geometry, 13, 3, 24);
+
+    std::vector<std::vector<TriangleKey>> before = GetModelTriangles(geometry);
+    GXVertexCacheStats analyzed = AnalyzeModel(geometry, 16);
+
+    GXVertexCacheReport report = geometry.OptimizeVertexCache(16);
+
+    CHECK(report.Before.TriangleCount == 3 * 24 * 24 * 2 && report.After.TriangleCount == report.Before.TriangleCount);
+    CHECK(report.Before.TransformedVertices == analyzed.TransformedVertices);
+    CHECK(report.After.TransformedVertices == AnalyzeModel(geometry, 16).TransformedVertices);
+
+    // Random order misses on nearly every vertex; a grid can get close to 0.5.
+    CHECK(report.Before.GetACMR() > 2.0f);
+    CHECK(report.After.GetACMR() < 0.8f);
+
+    CHECK(GetModelTriangles(geometry) == before);
+}
+
+// Every shape of a mixed model must keep its triangles and stay within its ranges, on any number of threads.
+static void TestVertexCacheKeepsShapes() {
+    GXGeometry single, threaded;
+    BuildRandomModel(single, 13);
+    BuildRandomModel(threaded, 13);
+
+    GXVertexArrayOptions options;
+    options.WeldVertices = true;
+    single.CreateVertexArray(options);
+    threaded.CreateVertexArray(options);
+
+    std::vector<std::vector<TriangleKey>> before = GetModelTriangles(single);
+
+    GXVertexCacheReport report = single.OptimizeVertexCache(16, 1);
+    threaded.OptimizeVertexCache(16, 4);
+
+    CHECK(GetModelTriangles(single) == before);
+    CHECK(report.After.TransformedVertices == AnalyzeModel(single, 16).TransformedVertices);
+    CHECK(SameFlattenedModel(single, threaded));
+}
+
+// The fetch remap must be a permutation of the vertex range that numbers vertices by first use, then the unused
+// ones in their old order.
+static void TestFetchRemapIsFirstUseOrder() {
+    const uint32_t indices[] = { 17, 12, 15, 15, 12, 10, 19, 17, 10 };
+    uint32_t remap[10];
+    GXBuildVertexFetchRemap(indices, 9, 10, 10, remap);
+
+    const uint32_t expected[] = { 13, 15, 11, 16, 17, 12, 18, 10, 19, 14 };
+    CHECK(std::equal(remap, remap + 10, expected));
+}
+
+// Renumbering every shape's vertices must keep its triangles and vertices, keep them in the shape's range, and leave
+// the indices numbering vertices in the order they are first used.
+static void TestVertexFetchRemapsShapes() {
+    GXGeometry geometry;
+    BuildRandomModel(geometry, 14);
+
+    GXVertexArrayOptions options;
+    options.WeldVertices = true;
+    geometry.CreateVertexArray(options);
+    geometry.OptimizeVertexCache();
+
+    std::vector<std::vector<TriangleKey>> triangles = GetModelTriangles(geometry);
+    std::vector<ModernVertex> vertices = geometry.GetModelVertices();
+
+    geometry.OptimizeVertexFetch(4);
+
+    CHECK(GetModelTriangles(geometry) == triangles);
+
+    for (const std::shared_ptr<GXShape>& shape : geometry.GetShapes()) {
+        uint32_t offset, count, firstVertex, vertexCount;
+        shape->GetVertexOffsetAndCount(offset, count);
+        shape->GetModelVertexRange(firstVertex, vertexCount);
+
+        // The same vertices, only in a different order.
+        auto Less = [](const ModernVertex& a, const ModernVertex& b) { return std::memcmp(&a, &b, sizeof(ModernVertex)) < 0; };
+        std::vector<ModernVertex> oldRange(vertices.begin() + firstVertex, vertices.begin() + firstVertex + vertexCount);
+        std::vector<ModernVertex> newRange(geometry.GetModelVertices().begin() + firstVertex,
+                                           geometry.GetModelVertices().begin() + firstVertex + vertexCount);
+        std::sort(oldRange.begin(), oldRange.end(), Less);
+        std::sort(newRange.begin(), newRange.end(), Less);
+        CHECK(SameVertices(oldRange, newRange));
+
+        // Each triangle index is either one seen before or the next unused vertex.
+        uint32_t next = firstVertex;
+        for (uint32_t i = offset; i < offset + count; i++) {
+            uint32_t index = geometry.GetModelIndices()[i];
+            CHECK(index <= next);
+            if (index == next)
+                next++;
+        }
+    }
+}
+
+// Reordering for overdraw must keep every shape's triangles and hold the cache miss ratio within the threshold,
+// and must leave filtered out shapes untouched.
+static void TestOverdrawKeepsACMRWithinThreshold() {
+    const float thresholds[] = { 1.0f, 1.05f, 1.5f };
+
+    for (float threshold : thresholds) {
+        GXGeometry geometry;
+        BuildShuffledGrids(geometry, 15, 3, 24);
+        geometry.OptimizeVertexCache();
+
+        std::vector<std::vector<TriangleKey>> triangles = GetModelTriangles(geometry);
+        std::vector<uint32_t> indices = geometry.GetModelIndices();
+
+        const GXShape* skipped = geometry.GetShapes()[1].get();
+        GXVertexCacheReport report = geometry.OptimizeOverdraw(threshold, [&](const GXShape& shape) { return &shape != skipped; }, 16, 4);
+
+        CHECK(GetModelTriangles(geometry) == triangles);
+        CHECK(report.Before.TriangleCount == 2 * 24 * 24 * 2 && report.After.TriangleCount == report.Before.TriangleCount);
+        CHECK(report.After.GetACMR() <= report.Before.GetACMR() * threshold);
+
+        uint32_t offset, count;
+        skipped->GetVertexOffsetAndCount(offset, count);
+        CHECK(std::equal(indices.begin() + offset, indices.begin() + offset + count, geometry.GetModelIndices().begin() + offset));
+    }
+
+    GXGeometry geometry;
+    BuildRandomModel(geometry, 15);
+
+    GXVertexArrayOptions options;
+    options.WeldVertices = true;
+    geometry.CreateVertexArray(options);
+    geometry.OptimizeVertexCache();
+
+    std::vector<std::vector<TriangleKey>> triangles = GetModelTriangles(geometry);
+    GXVertexCacheReport report = geometry.OptimizeOverdraw(1.05f);
+
+    CHECK(GetModelTriangles(geometry) == triangles);
+    CHECK(report.After.GetACMR() <= report.Before.GetACMR() * 1.05f);
+}
+
+int main() {
+    TestVertexCacheLowersACMR();
+    TestVertexCacheKeepsShapes();
+    TestFetchRemapIsFirstUseOrder();
+    TestVertexFetchRemapsShapes();
+    TestOverdrawKeepsACMRWithinThreshold();
+
+    std::puts("MeshOptimizerTests passed");
+    return 0;
+}
@@ -0,0 +1,161 @@
+#include "TestCommon.hpp"
+#include "glm/geometric.hpp"
+
+#include <cmath>
+
+// Fills the model with one shape per given height, each a size by size grid of quads in the plane z = height
+// facing +z, and flattens it with welding so the triangles share their vertices.
+static void BuildGrids(GXGeometry& geometry, const std::vector<float>& heights, uint32_t size) {
+    for (float height : heights) {
+        std::shared_ptr<GXShape> shape = std::make_shared<GXShape>();
+        shape->GetAttributeTable() = { EGXAttribute::Position };
+
+        GXPrimitive* primitive = new GXPrimitive(EGXPrimitiveType::Quads);
+        for (uint32_t y = 0; y < size; y++) {
+            for (uint32_t x = 0; x < size; x++) {
+                const uint32_t corners[4][2] = { { x, y }, { x + 1, y }, { x + 1, y + 1 }, { x, y + 1 } };
+                for (const uint32_t* corner : corners) {
+                    ModernVertex vertex;
+                    vertex.Position = glm::vec4(static_cast<float>(corner[0]), static_cast<float>(corner[1]), height, 0.0f);
+                    primitive->GetVertices().push_back(vertex);
+                }
+            }
+        }
+        shape->GetPrimitives().push_back(primitive);
+
+        geometry.GetShapes().push_back(shape);
+    }
+
+    GXVertexArrayOptions options;
+    options.WeldVertices = true;
+    geometry.CreateVertexArray(options);
+}
+
+// Every meshlet must stay within its limits and its shape's vertex range, enclose its vertices in its sphere,
+// and the meshlets of a shape must hold its triangles in order.
+static void CheckMeshlets(const GXGeometry& geometry, uint32_t maxVertices, uint32_t maxTriangles) {
+    const GXMeshletList& list = geometry.GetModelMeshlets();
+    const std::vector<ModernVertex>& vertices = geometry.GetModelVertices();
+
+    for (size_t s = 0; s < geometry.GetShapes().size(); s++) {
+        const GXShape& shape = *geometry.GetShapes()[s];
+
+        uint32_t offset, count, firstVertex, vertexCount, firstMeshlet, meshletCount;
+        shape.GetVertexOffsetAndCount(offset, count);
+        shape.GetModelVertexRange(firstVertex, vertexCount);
+        shape.GetMeshletRange(firstMeshlet, meshletCount);
+
+        std::vector<uint32_t> indices;
+        for (uint32_t m = firstMeshlet; m < firstMeshlet + meshletCount; m++) {
+            const GXMeshlet& meshlet = list.Meshlets[m];
+            CHECK(meshlet.ShapeIndex == s);
+            CHECK(meshlet.VertexCount >= 3 && meshlet.VertexCount <= maxVertices);
+            CHECK(meshlet.TriangleCount >= 1 && meshlet.TriangleCount <= maxTriangles);
+
+            for (uint32_t v = 0; v < meshlet.VertexCount; v++) {
+                uint32_t index = list.Vertices[meshlet.VertexOffset + v];
+                CHECK(index >= firstVertex && index < firstVertex + vertexCount);
+
+                float distance = glm::length(glm::vec3(vertices[index].Position) - meshlet.Center);
+                CHECK(distance <= meshlet.Radius * 1.0001f + 1e-5f);
+            }
+
+            for (uint32_t t = 0; t < meshlet.TriangleCount * 3; t++) {
+                uint8_t local = list.Triangles[(meshlet.TriangleOffset * 3) + t];
+                CHECK(local < meshlet.VertexCount);
+                indices.push_back(list.Vertices[meshlet.VertexOffset + local]);
+            }
+        }
+
+        CHECK(std::equal(indices.begin(), indices.end(), geometry.GetModelIndices().begin() + offset) && indices.size() == count);
+    }
+}
+
+// Meshlets must respect any vertex and triangle limits, whichever of the two runs out first.
+static void TestMeshletLimits() {
+    const uint32_t limits[][2] = { { 64, 124 }, { 3, 1 }, { 16, 124 }, { 256, 8 }, { 32, 20 } };
+
+    for (const uint32_t* limit : limits) {
+        GXGeometry grids;
+        BuildGrids(grids, { 0.0f, 5.0f }, 20);
+        grids.BuildMeshlets(limit[0], limit[1], 4);
+        CheckMeshlets(grids, limit[0], limit[1]);
+
+        GXGeometry random;
+        BuildRandomModel(random, 16);
+
+        GXVertexArrayOptions options;
+        options.WeldVertices = true;
+        random.CreateVertexArray(options);
+        random.OptimizeVertexCache();
+        random.BuildMeshlets(limit[0], limit[1]);
+        CheckMeshlets(random, limit[0], limit[1]);
+    }
+}
+
+// A flat meshlet's cone must cull it from behind, but not from in front or from the side.
+static void TestFlatMeshletCone() {
+    GXGeometry geometry;
+    BuildGrids(geometry, { 2.0f }, 4);
+    geometry.BuildMeshlets();
+
+    const GXMeshlet& meshlet = geometry.GetModelMeshlets().Meshlets[0];
+    CHECK(geometry.GetModelMeshlets().Meshlets.size() == 1);
+    CHECK(meshlet.ConeCutoff < 0.001f && glm::dot(meshlet.ConeAxis, glm::vec3(0.0f, 0.0f, 1.0f)) > 0.999f);
+
+    CHECK(meshlet.IsBackfacing(glm::vec3(2.0f, 2.0f, -10.0f)));
+    CHECK(meshlet.IsBackfacing(glm::vec3(50.0f, -30.0f, 1.0f)));
+    CHECK(!meshlet.IsBackfacing(glm::vec3(2.0f, 2.0f, 10.0f)));
+    CHECK(!meshlet.IsBackfacing(glm::vec3(50.0f, -30.0f, 3.0f)));
+}
+
+// Meshlets without a cone are never culled, even from their apex, and culled meshlets only hold triangles that
+// really face away from the camera.
+static void TestConeNeverCullsVisibleTriangles() {
+    GXMeshlet noCone;
+    noCone.ConeApex = glm::vec3(1.0f, 2.0f, 3.0f);
+    CHECK(!noCone.IsBackfacing(noCone.ConeApex));
+    CHECK(!noCone.IsBackfacing(glm::vec3(0.0f)));
+
+    GXMeshlet apex;
+    apex.ConeAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+    apex.ConeCutoff = 0.0f;
+    CHECK(!apex.IsBackfacing(apex.ConeApex));
+
+    GXGeometry geometry;
+    BuildRandomModel(geometry, 16);
+    geometry.CreateVertexArray();
+    geometry.BuildMeshlets(16, 8);
+
+    const GXMeshletList& list = geometry.GetModelMeshlets();
+    const std::vector<ModernVertex>& vertices = geometry.GetModelVertices();
+
+    std::mt19937 random(16);
+    std::uniform_real_distribution<float> coordinate(-20.0f, 20.0f);
+
+    for (const GXMeshlet& meshlet : list.Meshlets) {
+        for (int c = 0; c < 32; c++) {
+            glm::vec3 camera(coordinate(random), coordinate(random), coordinate(random));
+            if (!meshlet.IsBackfacing(camera))
+                continue;
+
+            for (uint32_t t = 0; t < meshlet.TriangleCount; t++) {
+                const uint8_t* triangle = &list.Triangles[(meshlet.TriangleOffset + t) * 3];
+                glm::vec3 p0(vertices[list.Vertices[meshlet.VertexOffset + triangle[0]]].Position);
+                glm::vec3 p1(vertices[list.Vertices[meshlet.VertexOffset + triangle[1]]].Position);
+                glm::vec3 p2(vertices[list.Vertices[meshlet.VertexOffset + triangle[2]]].Position);
+
+                CHECK(glm::dot(glm::cross(p1 - p0, p2 - p0), p0 - camera) >= -1e-3f);
+            }
+        }
+    }
+}
+
+int main() {
+    TestMeshletLimits();
+    TestFlatMeshletCone();
+    TestConeNeverCullsVisibleTriangles();
+
+    std::puts("MeshletTests passed");
+    return 0;
+}
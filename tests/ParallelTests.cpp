@@ -0,0 +1,62 @@
+#include "TestCommon.hpp"
+#include "util/GXParallel.hpp"
+
+#include <atomic>
+#include <stdexcept>
+
+// Every item must be visited exactly once, whatever the number of threads.
+static void TestEveryItemRunsOnce() {
+    const uint32_t threadCounts[] = { 0, 1, 2, 7, 64 };
+    const size_t counts[] = { 0, 1, 5, 1000 };
+
+    for (uint32_t threads : threadCounts) {
+        for (size_t count : counts) {
+            std::vector<std::atomic<uint32_t>> visits(count);
+            for (std::atomic<uint32_t>& v : visits) {
+                v = 0;
+            }
+
+            ParallelFor(count, threads, [&](size_t i) { visits[i]++; });
+
+            for (std::atomic<uint32_t>& v : visits) {
+                CHECK(v == 1);
+            }
+        }
+    }
+}
+
+// An exception thrown on any thread must reach the caller, after every thread has been joined.
+static void TestExceptionsReachTheCaller() {
+    const uint32_t threadCounts[] = { 1, 4, 16 };
+
+    for (uint32_t threads : threadCounts) {
+        std::atomic<size_t> running(0);
+        bool bThrew = false;
+
+        try {
+            ParallelFor(256, threads, [&](size_t i) {
+                running++;
+                if (i % 37 == 5)
+                    throw std::out_of_range("Item failed!");
+                running--;
+            });
+        }
+        catch (const std::out_of_range&) {
+            bThrew = true;
+        }
+
+        CHECK(bThrew);
+
+        // Only failed items are still counted, and each thread stops after its first failure.
+        size_t failed = running;
+        CHECK(failed >= 1 && failed <= threads);
+    }
+}
+
+int main() {
+    TestEveryItemRunsOnce();
+    TestExceptionsReachTheCaller();
+
+    std::puts("ParallelTests passed");
+    return 0;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "TestCommon.hpp"
+#include "util/GXSimd.hpp"
+
+// Tests of code with SIMD paths are built once per path with the code under test compiled in, so they check
+// whichever path GXSimd.hpp picked. Returns the name of that path, or null if this machine can't run it.
+inline const char* GetSimdPath() {
+#if defined(LIBFLIPPER_AVX2)
+#if defined(__GNUC__) || defined(__clang__)
+    if (!__builtin_cpu_supports("avx2"))
+        return nullptr;
+#endif
+    return "AVX2";
+#elif defined(LIBFLIPPER_SSSE3)
+#if defined(__GNUC__) || defined(__clang__)
+    if (!__builtin_cpu_supports("ssse3"))
+        return nullptr;
+#endif
+    return "SSSE3";
+#elif defined(LIBFLIPPER_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,74 @@
+#include "TestCommon.hpp"
+
+// Fills the model with one shape holding a gently curved grid of size by size quads, as a triangle list with every
+// triangle listing its own corners, and flattens it with or without welding.
+static void BuildGrid(GXGeometry& geometry, uint32_t size, bool weld) {
+    std::shared_ptr<GXShape> shape = std::make_shared<GXShape>();
+    shape->GetAttributeTable() = { EGXAttribute::Position, EGXAttribute::Normal, EGXAttribute::TexCoord0 };
+
+    auto MakeVertex = [size](uint32_t x, uint32_t y) {
+        ModernVertex vertex;
+        vertex.Position = glm::vec4(static_cast<float>(x), static_cast<float>(y), 0.001f * static_cast<float>(x * x), 0.0f);
+        vertex.Normal = glm::vec3(0.0f, 0.0f, 1.0f);
+        vertex.TexCoords[0] = glm::vec3(x / static_cast<float>(size), y / static_cast<float>(size), 0.0f);
+        return vertex;
+    };
+
+    GXPrimitive* triangles = new GXPrimitive(EGXPrimitiveType::Triangles);
+    for (uint32_t y = 0; y < size; y++) {
+        for (uint32_t x = 0; x < size; x++) {
+            triangles->GetVertices().insert(triangles->GetVertices().end(), {
+                MakeVertex(x, y), MakeVertex(x + 1, y), MakeVertex(x + 1, y + 1),
+                MakeVertex(x, y), MakeVertex(x + 1, y + 1), MakeVertex(x, y + 1)
+            });
+        }
+    }
+
+    shape->GetPrimitives().push_back(triangles);
+    geometry.GetShapes().push_back(shape);
+
+    GXVertexArrayOptions options;
+    options.WeldVertices = weld;
+    geometry.CreateVertexArray(options);
+}
+
+// Unwelded vertex arrays must simplify as far as welded ones, rather than seeing a seam at every shared corner.
+static void TestUnweldedInputSimplifiesLikeWelded() {
+    size_t counts[2];
+
+    for (bool weld : { false, true }) {
+        GXGeometry geometry;
+        BuildGrid(geometry, 20, weld);
+
+        const std::vector<uint32_t>& indices = geometry.GetModelIndices();
+        CHECK(indices.size() == 20 * 20 * 6);
+
+        std::vector<uint32_t> simplified;
+        GXSimplifyMesh(indices.data(), indices.size(), geometry.GetModelVertices().data(), 0, static_cast<uint32_t>(geometry.GetModelVertices().size()),
+                       indices.size() / 4, 0.05f, simplified);
+
+        counts[weld] = simplified.size();
+        CHECK(simplified.size() <= indices.size() / 2);
+    }
+
+    CHECK(counts[0] == counts[1]);
+}
+
+// Models flattened with the default options, which don't weld, must still get levels of detail.
+static void TestDefaultVertexArrayGetsLods() {
+    GXGeometry geometry;
+    BuildGrid(geometry, 20, false);
+    geometry.BuildLods(3);
+
+    const std::vector<GXShapeLod>& lods = geometry.GetShapes()[0]->GetLods();
+    CHECK(lods.size() >= 2);
+    CHECK(lods[0].IndexCount <= geometry.GetModelIndices().size() * 3 / 5);
+}
+
+int main() {
+    TestUnweldedInputSimplifiesLikeWelded();
+    TestDefaultVertexArrayGetsLods();
+
+    std::puts("SimplifierTests passed");
+    return 0;
+}
@@ -0,0 +1,210 @@
+#include "SimdTestCommon.hpp"
+#include "glm/geometric.hpp"
+#include "glm/matrix.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+// Returns the given number of matrices that rotate, scale unevenly and translate, so that normals need their own matrices.
+static std::vector<glm::mat4> GetRandomMatrices(std::mt19937& random, size_t count) {
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+    std::vector<glm::mat4> matrices(count);
+    for (glm::mat4& matrix : matrices) {
+        matrix = glm::translate(glm::mat4(1.0f), glm::vec3(unit(random), unit(random), unit(random)) * 50.0f);
+        matrix = glm::rotate(matrix, unit(random) * 3.0f, glm::normalize(glm::vec3(unit(random), unit(random), unit(random)) + glm::vec3(0.0f, 0.0f, 2.0f)));
+        matrix = glm::scale(matrix, glm::vec3(1.5f + unit(random), 1.5f + unit(random), 1.5f + unit(random)));
+    }
+
+    return matrices;
+}
+
+// Returns whether every component of a is within a relative tolerance of b.
+static bool Near(const glm::vec3& a, const glm::vec3& b) {
+    for (int c = 0; c < 3; c++) {
+        if (!(std::fabs(a[c] - b[c]) <= 1e-5f * std::max(1.0f, std::fabs(b[c]))))
+            return false;
+    }
+
+    return true;
+}
+
+// Returns whether a and b hold the same bits, so that untransformed NaNs and infinities compare equal.
+static bool SameBits(const glm::vec3& a, const glm::vec3& b) {
+    return std::memcmp(&a, &b, sizeof(glm::vec3)) == 0;
+}
+
+// Checks one skinned vertex against glm: transformed by the given matrix, or copied exactly if there is none.
+static void CheckSkinned(const ModernVertex& vertex, const glm::mat4* matrix, const glm::vec3& position, const glm::vec3& normal) {
+    if (matrix == nullptr) {
+        CHECK(SameBits(position, glm::vec3(vertex.Position)));
+        CHECK(SameBits(normal, vertex.Normal));
+        return;
+    }
+
+    CHECK(Near(position, glm::vec3(*matrix * glm::vec4(glm::vec3(vertex.Position), 1.0f))));
+
+    glm::vec3 expected = glm::transpose(glm::inverse(glm::mat3(*matrix))) * vertex.Normal;
+    if (glm::length(expected) > 0.0f)
+        expected = glm::normalize(expected);
+    CHECK(Near(normal, expected));
+}
+
+// Returns random vertices whose Position.w selects a slot in [0, slots), or is one of the values that select nothing.
+static std::vector<ModernVertex> GetRandomVertices(std::mt19937& random, size_t count, uint32_t slots) {
+    const float invalid[] = { -1.0f, static_cast<float>(slots), 65535.0f, std::numeric_limits<float>::quiet_NaN() };
+    std::uniform_real_distribution<float> coordinate(-10.0f, 10.0f);
+
+    std::vector<ModernVertex> vertices(count);
+    for (size_t i = 0; i < count; i++) {
+        ModernVertex& vertex = vertices[i];
+        vertex.Position = glm::vec4(coordinate(random), coordinate(random), coordinate(random), static_cast<float>(random() % slots));
+        vertex.Normal = glm::vec3(coordinate(random), coordinate(random), coordinate(random));
+
+        if (i % 5 == 2)
+            vertex.Position.w = invalid[random() % 4];
+        if (i % 11 == 4)
+            vertex.Normal = glm::vec3(0.0f);
+        if (i % 13 == 6) {
+            vertex.Position.x = std::numeric_limits<float>::infinity();
+            vertex.Position.w = -1.0f;
+        }
+    }
+
+    return vertices;
+}
+
+const size_t COUNTS[] = { 0, 1, 3, 4, 5, 7, 8, 9, 16, 17, 33, 67 };
+
+// Every vertex must be transformed by the matrix its index selects, or copied exactly if it selects none,
+// for counts that exercise both the vector loop and its scalar tail.
+static void TestSkinningMatchesGlm() {
+    std::mt19937 random(20);
+    std::vector<glm::mat4> matrices = GetRandomMatrices(random, 30);
+
+    GXSkinPalette palette;
+    palette.SetMatrices(matrices);
+
+    for (size_t count : COUNTS) {
+        std::vector<ModernVertex> vertices = GetRandomVertices(random, count, 30);
+
+        std::vector<glm::vec3> positions(count), normals(count);
+        GXSkinVertices(vertices.data(), vertices.size(), palette, positions.data(), normals.data());
+
+        std::vector<glm::vec3> positionsOnly(count);
+        GXSkinVertices(vertices.data(), vertices.size(), palette, positionsOnly.data(), nullptr);
+
+        for (size_t i = 0; i < count; i++) {
+            const float w = vertices[i].Position.w;
+            const glm::mat4* matrix = w >= 0.0f && w < 30.0f ? &matrices[static_cast<size_t>(w)] : nullptr;
+
+            CheckSkinned(vertices[i], matrix, positions[i], normals[i]);
+            CHECK(SameBits(positionsOnly[i], positions[i]));
+        }
+    }
+}
+
+// Skinning a scattered set of vertices through a draw palette must transform exactly those vertices, each by the
+// matrix its slot maps to, and leave every other output alone.
+static void TestGatheredSkinningFollowsDrawPalette() {
+    std::mt19937 random(20);
+    std::vector<glm::mat4> matrices = GetRandomMatrices(random, 30);
+
+    GXSkinPalette palette;
+    palette.SetMatrices(matrices);
+
+    // The last slot maps to a matrix the palette doesn't have.
+    const std::vector<uint32_t> drawPalette = { 27, 3, 12, 0, 9, 40 };
+
+    for (size_t count : COUNTS) {
+        std::vector<ModernVertex> vertices = GetRandomVertices(random, count * 2, static_cast<uint32_t>(drawPalette.size()));
+
+        std::vector<uint32_t> ids(count * 2);
+        std::iota(ids.begin(), ids.end(), 0);
+        std::shuffle(ids.begin(), ids.end(), random);
+        ids.resize(count);
+
+        const glm::vec3 untouched(-123.0f);
+        std::vector<glm::vec3> positions(count * 2, untouched), normals(count * 2, untouched);
+        GXSkinVertices(vertices.data(), ids.data(), ids.size(), palette, positions.data(), normals.data(), &drawPalette);
+
+        for (size_t v = 0; v < vertices.size(); v++) {
+            if (std::find(ids.begin(), ids.end(), v) == ids.end()) {
+                CHECK(positions[v] == untouched && normals[v] == untouched);
+                continue;
+            }
+
+            const float w = vertices[v].Position.w;
+            const glm::mat4* matrix = nullptr;
+            if (w >= 0.0f && w < static_cast<float>(drawPalette.size()) && drawPalette[static_cast<size_t>(w)] < matrices.size())
+                matrix = &matrices[drawPalette[static_cast<size_t>(w)]];
+
+            CheckSkinned(vertices[v], matrix, positions[v], normals[v]);
+        }
+    }
+}
+
+// A model skinned after its palettes are partitioned must transform every vertex of a draw by the matrix that the
+// draw's palette maps its slot to, on any number of threads.
+static void TestPartitionedModelSkinning() {
+    std::mt19937 random(20);
+    std::vector<glm::mat4> matrices = GetRandomMatrices(random, 10);
+
+    GXSkinPalette palette;
+    palette.SetMatrices(matrices);
+
+    GXGeometry geometry;
+    BuildRandomModel(geometry, 20, 40);
+
+    GXVertexArrayOptions options;
+    options.WeldVertices = true;
+    geometry.CreateVertexArray(options);
+    geometry.PartitionMatrixPalettes(3);
+
+    std::vector<glm::vec3> positions, normals, threadedPositions, threadedNormals;
+    geometry.SkinVertices(palette, positions, normals, 1);
+    geometry.SkinVertices(palette, threadedPositions, threadedNormals, 4);
+
+    CHECK(positions == threadedPositions && normals == threadedNormals);
+
+    size_t drawCount = 0;
+    for (const std::shared_ptr<GXShape>& shape : geometry.GetShapes()) {
+        for (const GXShapeDraw& draw : shape->GetDraws()) {
+            const std::vector<uint32_t>& indices = draw.Type == EGXPrimitiveType::Triangles ? geometry.GetModelIndices() :
+                                                   draw.Type == EGXPrimitiveType::Lines ? geometry.GetModelLineIndices() : geometry.GetModelPointIndices();
+
+            for (uint32_t i = draw.FirstIndex; i < draw.FirstIndex + draw.IndexCount; i++) {
+                const uint32_t v = indices[i];
+                const ModernVertex& vertex = geometry.GetModelVertices()[v];
+
+                const uint32_t slot = static_cast<uint32_t>(vertex.Position.w);
+                CHECK(slot < draw.Palette.size());
+
+                const uint32_t matrix = draw.Palette[slot];
+                CheckSkinned(vertex, matrix < matrices.size() ? &matrices[matrix] : nullptr, positions[v], normals[v]);
+            }
+
+            drawCount++;
+        }
+    }
+
+    CHECK(drawCount > 0);
+}
+
+int main() {
+    const char* path = GetSimdPath();
+    if (path == nullptr) {
+        std::puts("SkinningTests skipped: this machine can't run the SIMD path they were built for");
+        return 77;
+    }
+
+    TestSkinningMatchesGlm();
+    TestGatheredSkinningFollowsDrawPalette();
+    TestPartitionedModelSkinning();
+
+    std::printf("SkinningTests passed on the %s path\n", path);
+    return 0;
+}
@@ -0,0 +1,185 @@
+#include "TestCommon.hpp"
+#include "glm/geometric.hpp"
+
+#include <cmath>
+
+// Fills the model with one shape of two quads side by side facing +z, the left one spanning x = 0 to 1 and the
+// right one x = 1 to 2. The right quad's tex coords mirror the left's, so the vertices on x = 1 weld together
+// and sit on a seam where the tangent flips from +x to -x and the handedness from +1 to -1.
+static void BuildMirroredQuads(GXGeometry& geometry) {
+    std::shared_ptr<GXShape> shape = std::make_shared<GXShape>();
+    shape->GetAttributeTable() = { EGXAttribute::Position, EGXAttribute::Normal, EGXAttribute::TexCoord0 };
+
+    GXPrimitive* primitive = new GXPrimitive(EGXPrimitiveType::Quads);
+    for (float left : { 0.0f, 1.0f }) {
+        const float corners[4][2] = { { left, 0.0f }, { left + 1.0f, 0.0f }, { left + 1.0f, 1.0f }, { left, 1.0f } };
+        for (const float* corner : corners) {
+            ModernVertex vertex;
+            vertex.Position = glm::vec4(corner[0], corner[1], 0.0f, 0.0f);
+            vertex.Normal = glm::vec3(0.0f, 0.0f, 1.0f);
+            vertex.TexCoords[0] = glm::vec3(corner[0] <= 1.0f ? corner[0] : 2.0f - corner[0], corner[1], 0.0f);
+            primitive->GetVertices().push_back(vertex);
+        }
+    }
+    shape->GetPrimitives().push_back(primitive);
+
+    geometry.GetShapes().push_back(shape);
+
+    GXVertexArrayOptions options;
+    options.WeldVertices = true;
+    geometry.CreateVertexArray(options);
+}
+
+// Returns whether two vectors are equal to within the given tolerance.
+static bool Near(const glm::vec3& a, const glm::vec3& b, float tolerance = 1e-4f) {
+    return glm::length(a - b) <= tolerance;
+}
+
+// Every corner of every triangle of the mirrored quads must decode to the known frame of its side.
+static void CheckMirroredFrames(const GXGeometry& geometry) {
+    const std::vector<ModernVertex>& vertices = geometry.GetModelVertices();
+    const std::vector<glm::vec4>& frames = geometry.GetModelTangentFrames();
+    const std::vector<uint32_t>& indices = geometry.GetModelIndices();
+    CHECK(frames.size() == vertices.size());
+
+    const GXShape& shape = *geometry.GetShapes()[0];
+    uint32_t offset, count;
+    shape.GetVertexOffsetAndCount(offset, count);
+    CHECK(count == 12);
+
+    for (uint32_t t = offset; t < offset + count; t += 3) {
+        float centerX = (vertices[indices[t]].Position.x + vertices[indices[t + 1]].Position.x + vertices[indices[t + 2]].Position.x) / 3.0f;
+        const float side = centerX < 1.0f ? 1.0f : -1.0f;
+
+        for (uint32_t c = 0; c < 3; c++) {
+            const glm::vec4& frame = frames[indices[t + c]];
+            CHECK((frame.w < 0.0f ? -1.0f : 1.0f) == side);
+
+            glm::vec3 normal, tangent, bitangent;
+            GXDecodeTangentFrame(frame, normal, tangent, bitangent);
+            CHECK(Near(normal, glm::vec3(0.0f, 0.0f, 1.0f)));
+            CHECK(Near(tangent, glm::vec3(side, 0.0f, 0.0f)));
+            CHECK(Near(bitangent, glm::vec3(0.0f, 1.0f, 0.0f)));
+        }
+    }
+}
+
+// ModernVertex must stay free of tangent frames, so they don't take part in welding.
+static void TestVertexLayoutIsUnchanged() {
+    CHECK(sizeof(ModernVertex) == sizeof(float) * 39);
+}
+
+// The two welded vertices on the mirrored seam must each be split in two, one per handedness.
+static void TestMirroredSeamIsSplit() {
+    GXGeometry geometry;
+    BuildMirroredQuads(geometry);
+    CHECK(geometry.GetModelVertices().size() == 6);
+    CHECK(!geometry.HasTangentFrames());
+
+    geometry.GenerateTangentFrames(0, 2);
+    CHECK(geometry.HasTangentFrames());
+    CHECK(geometry.GetModelVertices().size() == 8);
+
+    uint32_t first, count;
+    geometry.GetShapes()[0]->GetModelVertexRange(first, count);
+    CHECK(first == 0 && count == 8);
+
+    CheckMirroredFrames(geometry);
+
+    // Each seam position is now held by one vertex per handedness.
+    const std::vector<ModernVertex>& vertices = geometry.GetModelVertices();
+    const std::vector<glm::vec4>& frames = geometry.GetModelTangentFrames();
+    for (float y : { 0.0f, 1.0f }) {
+        uint32_t rightHanded = 0, leftHanded = 0;
+        for (size_t v = 0; v < vertices.size(); v++) {
+            if (vertices[v].Position.x == 1.0f && vertices[v].Position.y == y)
+                (frames[v].w < 0.0f ? leftHanded : rightHanded)++;
+        }
+
+        CHECK(rightHanded == 1 && leftHanded == 1);
+    }
+}
+
+// The packed vertex buffers must store the frames as the NBT attribute, and passes that move or copy vertices
+// must carry the frames along.
+static void TestFramesFollowVertices() {
+    GXGeometry geometry;
+    BuildMirroredQuads(geometry);
+    geometry.GenerateTangentFrames();
+
+    geometry.BuildCompactVertices();
+    geometry.BuildQuantizedVertices();
+
+    auto CheckPacked = [&]() {
+        const std::vector<glm::vec4>& frames = geometry.GetModelTangentFrames();
+
+        for (int quantized = 0; quantized < 2; quantized++) {
+            const GXVertexLayout& layout = quantized ? geometry.GetQuantizedVertexLayout() : geometry.GetCompactVertexLayout();
+            const std::vector<uint8_t>& packed = quantized ? geometry.GetQuantizedVertices() : geometry.GetCompactVertices();
+            CHECK(packed.size() == frames.size() * layout.GetStride());
+
+            const GXVertexElement* nbt = nullptr;
+            for (const GXVertexElement& element : layout.GetElements()) {
+                if (element.Attribute == EGXAttribute::NBT)
+                    nbt = &element;
+            }
+            CHECK(nbt != nullptr);
+
+            for (size_t v = 0; v < frames.size(); v++) {
+                const uint8_t* src = packed.data() + v * layout.GetStride() + nbt->Offset;
+
+                glm::vec4 frame;
+                if (quantized) {
+                    int16_t values[4];
+                    std::memcpy(values, src, sizeof(values));
+                    frame = glm::vec4(values[0], values[1], values[2], values[3]) / 32767.0f;
+                }
+                else {
+                    std::memcpy(&frame, src, sizeof(frame));
+                }
+
+                for (int c = 0; c < 4; c++) {
+                    CHECK(std::fabs(frame[c] - frames[v][c]) <= (quantized ? 1.0f / 32767.0f : 0.0f));
+                }
+            }
+        }
+    };
+
+    CheckPacked();
+
+    geometry.OptimizeVertexCache();
+    geometry.OptimizeVertexFetch();
+    CheckMirroredFrames(geometry);
+    CheckPacked();
+
+    geometry.PartitionMatrixPalettes(3);
+    CheckMirroredFrames(geometry);
+    CheckPacked();
+
+    // Vertices added afterwards have no frame of their own, but keep the frames lined up with the vertices.
+    std::vector<ModernVertex> extra(3);
+    for (int i = 0; i < 3; i++) {
+        extra[i].Position = glm::vec4(static_cast<float>(i), 5.0f, 0.0f, 0.0f);
+    }
+
+    geometry.AddVertices(extra.data(), extra.size());
+    CHECK(geometry.GetModelTangentFrames().size() == geometry.GetModelVertices().size());
+    CHECK(geometry.GetModelTangentFrames().back() == glm::vec4(0.0f));
+
+    geometry.BuildCompactVertices();
+    geometry.BuildQuantizedVertices();
+    CheckPacked();
+
+    // Recreating the vertex array drops the frames along with the vertices they belonged to.
+    geometry.CreateVertexArray();
+    CHECK(!geometry.HasTangentFrames());
+}
+
+int main() {
+    TestVertexLayoutIsUnchanged();
+    TestMirroredSeamIsSplit();
+    TestFramesFollowVertices();
+
+    std::puts("TangentFrameTests passed");
+    return 0;
+}
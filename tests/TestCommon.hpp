@@ -0,0 +1,120 @@
+#pragma once
+
+#include "GXGeometry.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+// Fails the running test if the condition doesn't hold. Unlike assert, it is never compiled out.
+#define CHECK(condition)                                                                         \
+    do {                                                                                         \
+        if (!(condition)) {                                                                      \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition);   \
+            std::exit(1);                                                                        \
+        }                                                                                        \
+    } while (false)
+
+// The attribute tables of the shapes that BuildRandomModel creates, one per shape in turn.
+inline std::vector<EGXAttribute> GetRandomModelTable(size_t shape) {
+    switch (shape % 3) {
+        case 0:
+            return { EGXAttribute::Position, EGXAttribute::Normal, EGXAttribute::TexCoord0 };
+        case 1:
+            return { EGXAttribute::PositionMatrixIdx, EGXAttribute::Position, EGXAttribute::Color0 };
+        default:
+            return { EGXAttribute::Position };
+    }
+}
+
+// Fills the model with shapeCount shapes of primitives of every type, made of vertices picked from a small pool so
+// that vertices repeat, and strips and fans hold degenerate triangles. Every third shape, starting with the second,
+// stores its primitives in index form, referring to the attribute data that is also filled in here.
+inline void BuildRandomModel(GXGeometry& geometry, uint32_t seed, size_t shapeCount = 12) {
+    static const EGXPrimitiveType TYPES[] = {
+        EGXPrimitiveType::Quads, EGXPrimitiveType::Triangles, EGXPrimitiveType::TriangleStrips, EGXPrimitiveType::TriangleFan,
+        EGXPrimitiveType::Lines, EGXPrimitiveType::LineStrips, EGXPrimitiveType::Points
+    };
+
+    std::mt19937 random(seed);
+
+    GXAttributeData& attributes = geometry.GetAttributeData();
+    for (uint32_t i = 0; i < 32; i++) {
+        attributes.GetPositions().push_back(glm::vec4(static_cast<float>(i % 8), static_cast<float>(i / 8), static_cast<float>(i % 3), 0.0f));
+    }
+    for (uint32_t i = 0; i < 4; i++) {
+        attributes.GetColors(0).push_back(glm::vec4(i / 4.0f, 1.0f, 0.0f, 1.0f));
+    }
+
+    for (size_t s = 0; s < shapeCount; s++) {
+        std::shared_ptr<GXShape> shape = std::make_shared<GXShape>();
+        shape->GetAttributeTable() = GetRandomModelTable(s);
+
+        GXVertexCache cache(attributes);
+        cache.SetAttributeTable(shape->GetAttributeTable());
+
+        uint32_t primitiveCount = 1 + random() % 8;
+        for (uint32_t p = 0; p < primitiveCount; p++) {
+            GXPrimitive* primitive = new GXPrimitive(TYPES[random() % 7]);
+            uint32_t vertexCount = 2 + random() % 24;
+
+            for (uint32_t v = 0; v < vertexCount; v++) {
+                if (s % 3 == 1) {
+                    GXVertex vertex;
+                    vertex.SetIndex(EGXAttribute::PositionMatrixIdx, random() % 10);
+                    vertex.SetIndex(EGXAttribute::Position, random() % 32);
+                    vertex.SetIndex(EGXAttribute::Color0, random() % 4);
+                    primitive->AddIndexedVertex(cache.GetFormat(), vertex);
+                }
+                else {
+                    ModernVertex vertex;
+                    vertex.Position = glm::vec4(static_cast<float>(random() % 6), static_cast<float>(random() % 4), static_cast<float>(s), 0.0f);
+                    vertex.Normal = glm::vec3(0.0f, 0.0f, static_cast<float>(random() % 2));
+                    vertex.TexCoords[0] = glm::vec3(vertex.Position.x / 6.0f, vertex.Position.y / 4.0f, 0.0f);
+                    primitive->GetVertices().push_back(vertex);
+                }
+            }
+
+            shape->GetPrimitives().push_back(primitive);
+        }
+
+        geometry.GetShapes().push_back(shape);
+    }
+}
+
+// Returns whether two vertex lists hold the same vertices, bit for bit.
+inline bool SameVertices(const std::vector<ModernVertex>& a, const std::vector<ModernVertex>& b) {
+    return a.size() == b.size() && (a.empty() || std::memcmp(a.data(), b.data(), a.size() * sizeof(ModernVertex)) == 0);
+}
+
+// Returns whether two models' flattened lists, and their shapes' ranges of them, are identical.
+inline bool SameFlattenedModel(const GXGeometry& a, const GXGeometry& b) {
+    if (!SameVertices(a.GetModelVertices(), b.GetModelVertices()) || a.GetModelIndices() != b.GetModelIndices() ||
+        a.GetModelLineIndices() != b.GetModelLineIndices() || a.GetModelPointIndices() != b.GetModelPointIndices() ||
+        a.GetShapes().size() != b.GetShapes().size())
+        return false;
+
+    for (size_t s = 0; s < a.GetShapes().size(); s++) {
+        const GXShape& shapeA = *a.GetShapes()[s];
+        const GXShape& shapeB = *b.GetShapes()[s];
+
+        uint32_t rangeA[8], rangeB[8];
+        shapeA.GetVertexOffsetAndCount(rangeA[0], rangeA[1]);
+        shapeA.GetModelVertexRange(rangeA[2], rangeA[3]);
+        shapeA.GetLineOffsetAndCount(rangeA[4], rangeA[5]);
+        shapeA.GetPointOffsetAndCount(rangeA[6], rangeA[7]);
+        shapeB.GetVertexOffsetAndCount(rangeB[0], rangeB[1]);
+        shapeB.GetModelVertexRange(rangeB[2], rangeB[3]);
+        shapeB.GetLineOffsetAndCount(rangeB[4], rangeB[5]);
+        shapeB.GetPointOffsetAndCount(rangeB[6], rangeB[7]);
+
+        if (std::memcmp(rangeA, rangeB, sizeof(rangeA)) != 0)
+            return false;
+    }
+
+    return true;
+}
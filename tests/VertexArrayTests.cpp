@@ -0,0 +1,192 @@
+#include "TestCommon.hpp"
+
+#include <cmath>
+
+// Flattening on several threads must give exactly the same model as flattening on one.
+static void TestThreadCountDoesNotChangeOutput() {
+    for (bool weld : { false, true }) {
+        GXGeometry single, threaded;
+        BuildRandomModel(single, 1, 40);
+        BuildRandomModel(threaded, 1, 40);
+
+        GXVertexArrayOptions options;
+        options.WeldVertices = weld;
+        options.CalculateBounds = true;
+        options.CompactVertices = true;
+        single.CreateVertexArray(options);
+
+        options.ThreadCount = 4;
+        threaded.CreateVertexArray(options);
+
+        CHECK(!single.GetModelIndices().empty());
+        CHECK(SameFlattenedModel(single, threaded));
+        CHECK(single.GetCompactVertices() == threaded.GetCompactVertices());
+
+        for (size_t s = 0; s < single.GetShapes().size(); s++) {
+            const GXBoundingBox& a = single.GetShapes()[s]->GetBoundingBox();
+            const GXBoundingBox& b = threaded.GetShapes()[s]->GetBoundingBox();
+            CHECK(a.Min == b.Min && a.Max == b.Max);
+        }
+    }
+}
+
+// Every index a shape writes must point into its own range of the model vertex list.
+static void TestShapeIndicesStayInTheirVertexRange() {
+    GXGeometry geometry;
+    BuildRandomModel(geometry, 2);
+    geometry.CreateVertexArray();
+
+    for (const std::shared_ptr<GXShape>& shape : geometry.GetShapes()) {
+        uint32_t first, count, offset, indexCount;
+        shape->GetModelVertexRange(first, count);
+        shape->GetVertexOffsetAndCount(offset, indexCount);
+
+        for (uint32_t i = offset; i < offset + indexCount; i++) {
+            CHECK(geometry.GetModelIndices()[i] >= first && geometry.GetModelIndices()[i] < first + count);
+        }
+    }
+}
+
+// Returns the vertices of the model's triangles in order, three per triangle.
+static std::vector<ModernVertex> GetTriangleVertices(const GXGeometry& geometry) {
+    std::vector<ModernVertex> triangles;
+    for (uint32_t index : geometry.GetModelIndices()) {
+        triangles.push_back(geometry.GetModelVertices()[index]);
+    }
+
+    return triangles;
+}
+
+// Strips and fans that repeat a vertex must lose their degenerate triangles whether or not vertices are welded,
+// exactly as when primitives were triangulated by comparing their vertices.
+static void TestUnweldedOutputDropsDegenerateTriangles() {
+    auto MakeVertex = [](float x, float y) {
+        ModernVertex vertex;
+        vertex.Position = glm::vec4(x, y, 0.0f, 0.0f);
+        return vertex;
+    };
+
+    // Two strips joined by repeating the last vertex of the first and the first of the second, then a fan that
+    // repeats its centre and a quad that repeats a corner.
+    std::vector<ModernVertex> strip = { MakeVertex(0, 0), MakeVertex(0, 1), MakeVertex(1, 0), MakeVertex(1, 1), MakeVertex(1, 1),
+                                        MakeVertex(2, 0), MakeVertex(2, 0), MakeVertex(2, 1), MakeVertex(3, 0) };
+    std::vector<ModernVertex> fan = { MakeVertex(5, 5), MakeVertex(6, 5), MakeVertex(6, 6), MakeVertex(5, 5), MakeVertex(4, 6), MakeVertex(4, 5) };
+    std::vector<ModernVertex> quad = { MakeVertex(0, 9), MakeVertex(1, 9), MakeVertex(1, 9), MakeVertex(0, 8) };
+
+    // The triangles left once those with two equal vertices are dropped, in order.
+    std::vector<ModernVertex> expected;
+    auto AddExpected = [&expected](const ModernVertex& v0, const ModernVertex& v1, const ModernVertex& v2) {
+        if (v0 == v1 || v0 == v2 || v1 == v2)
+            return;
+
+        expected.insert(expected.end(), { v0, v1, v2 });
+    };
+
+    for (size_t i = 2; i < strip.size(); i++) {
+        if (i % 2 != 0)
+            AddExpected(strip[i - 2], strip[i], strip[i - 1]);
+        else
+            AddExpected(strip[i - 2], strip[i - 1], strip[i]);
+    }
+    for (size_t i = 1; i + 1 < fan.size(); i++) {
+        AddExpected(fan[i], fan[i + 1], fan[0]);
+    }
+    AddExpected(quad[0], quad[1], quad[2]);
+    AddExpected(quad[0], quad[2], quad[3]);
+
+    CHECK(expected.size() == 6 * 3);
+
+    for (bool weld : { false, true }) {
+        GXGeometry geometry;
+        std::shared_ptr<GXShape> shape = std::make_shared<GXShape>();
+        shape->GetAttributeTable() = { EGXAttribute::Position };
+
+        const std::pair<EGXPrimitiveType, const std::vector<ModernVertex>*> primitives[] = {
+            { EGXPrimitiveType::TriangleStrips, &strip }, { EGXPrimitiveType::TriangleFan, &fan }, { EGXPrimitiveType::Quads, &quad }
+        };
+        for (const auto& source : primitives) {
+            GXPrimitive* primitive = new GXPrimitive(source.first);
+            primitive->GetVertices() = *source.second;
+            shape->GetPrimitives().push_back(primitive);
+        }
+
+        geometry.GetShapes().push_back(shape);
+
+        GXVertexArrayOptions options;
+        options.WeldVertices = weld;
+        geometry.CreateVertexArray(options);
+
+        CHECK(SameVertices(GetTriangleVertices(geometry), expected));
+    }
+}
+
+// Welding must only change how vertices are shared, not which triangles are drawn.
+static void TestWeldingKeepsTheSameTriangles() {
+    GXGeometry welded, unwelded;
+    BuildRandomModel(welded, 3, 30);
+    BuildRandomModel(unwelded, 3, 30);
+
+    GXVertexArrayOptions options;
+    unwelded.CreateVertexArray(options);
+    options.WeldVertices = true;
+    welded.CreateVertexArray(options);
+
+    CHECK(welded.GetModelVertices().size() < unwelded.GetModelVertices().size());
+    CHECK(SameVertices(GetTriangleVertices(welded), GetTriangleVertices(unwelded)));
+}
+
+// Every stream must hold the matching attribute of each model vertex, and only enabled attributes get a stream.
+static void TestVertexStreamsMatchModelVertices() {
+    GXGeometry geometry;
+    BuildRandomModel(geometry, 5);
+
+    // Loose vertices with matrix indices that aren't valid, which must come out as UINT16_MAX.
+    std::vector<ModernVertex> loose(3);
+    loose[0].Position.w = -2.0f;
+    loose[1].Position.w = std::nanf("");
+    loose[2].Position.w = 7.0f;
+    geometry.AddVertices(loose);
+
+    GXVertexArrayOptions options;
+    options.WeldVertices = true;
+    options.SplitVertexStreams = true;
+    geometry.CreateVertexArray(options);
+
+    const GXAttributeData& streams = geometry.GetModelStreams();
+    const std::vector<ModernVertex>& vertices = geometry.GetModelVertices();
+
+    CHECK(streams.GetPositions().size() == vertices.size());
+    CHECK(streams.GetPositionMatrixIndices().size() == vertices.size());
+    CHECK(streams.GetNormals().size() == vertices.size());
+    CHECK(streams.GetColors(0).size() == vertices.size());
+    CHECK(streams.GetTexCoords(0).size() == vertices.size());
+    CHECK(streams.GetColors(1).empty() && streams.GetTexCoords(1).empty());
+
+    for (size_t v = 0; v < vertices.size(); v++) {
+        CHECK(std::memcmp(&streams.GetPositions()[v], &vertices[v].Position, sizeof(glm::vec4)) == 0);
+        CHECK(streams.GetNormals()[v] == vertices[v].Normal);
+        CHECK(streams.GetColors(0)[v] == vertices[v].Colors[0]);
+        CHECK(streams.GetTexCoords(0)[v] == vertices[v].TexCoords[0]);
+    }
+
+    CHECK(streams.GetPositionMatrixIndices()[0] == UINT16_MAX);
+    CHECK(streams.GetPositionMatrixIndices()[1] == UINT16_MAX);
+    CHECK(streams.GetPositionMatrixIndices()[2] == 7);
+
+    // Passes that move vertices rebuild the streams to match.
+    geometry.OptimizeVertexFetch();
+    for (size_t v = 0; v < vertices.size(); v++) {
+        CHECK(std::memcmp(&streams.GetPositions()[v], &vertices[v].Position, sizeof(glm::vec4)) == 0);
+    }
+}
+
+int main() {
+    TestThreadCountDoesNotChangeOutput();
+    TestShapeIndicesStayInTheirVertexRange();
+    TestUnweldedOutputDropsDegenerateTriangles();
+    TestWeldingKeepsTheSameTriangles();
+    TestVertexStreamsMatchModelVertices();
+
+    std::puts("VertexArrayTests passed");
+    return 0;
+}
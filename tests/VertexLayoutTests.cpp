@@ -0,0 +1,135 @@
+#include "TestCommon.hpp"
+#include "glm/geometric.hpp"
+#include "glm/gtc/packing.hpp"
+
+#include <cmath>
+#include <limits>
+
+// Returns a pointer to the given element of the given packed vertex.
+static const uint8_t* GetElement(const GXVertexLayout& layout, const std::vector<uint8_t>& buffer, size_t vertex, EGXAttribute attribute) {
+    const GXVertexElement* element = layout.FindElement(attribute);
+    CHECK(element != nullptr);
+
+    return buffer.data() + vertex * layout.GetStride() + element->Offset;
+}
+
+// Restores a UNorm16x4 position with the given parameters.
+static glm::vec3 DequantizePosition(const uint8_t* data, const GXDequantizationParams& params) {
+    uint16_t packed[4];
+    std::memcpy(packed, data, sizeof(packed));
+
+    return params.PositionOffset + params.PositionScale * glm::vec3(packed[0], packed[1], packed[2]) / 65535.0f;
+}
+
+// Restores an octahedral SNorm16x2 unit vector.
+static glm::vec3 DecodeOctahedral(const uint8_t* data) {
+    int16_t packed[2];
+    std::memcpy(packed, data, sizeof(packed));
+
+    glm::vec3 n(packed[0] / 32767.0f, packed[1] / 32767.0f, 0.0f);
+    n.z = 1.0f - std::fabs(n.x) - std::fabs(n.y);
+
+    if (n.z < 0.0f) {
+        float x = (1.0f - std::fabs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f);
+        float y = (1.0f - std::fabs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f);
+        n.x = x;
+        n.y = y;
+    }
+
+    return glm::normalize(n);
+}
+
+// Returns whether every component of a is within tolerance of b.
+static bool Near(const glm::vec3& a, const glm::vec3& b, float tolerance) {
+    return std::fabs(a.x - b.x) <= tolerance && std::fabs(a.y - b.y) <= tolerance && std::fabs(a.z - b.z) <= tolerance;
+}
+
+// Every vertex of the quantized buffer must come back close to the model vertex it was packed from, including
+// vertices outside of every shape, which are quantized with the model's own parameters.
+static void TestQuantizedRoundTrip() {
+    GXGeometry geometry;
+    BuildRandomModel(geometry, 11);
+
+    std::vector<ModernVertex> loose(6);
+    for (size_t i = 0; i < loose.size(); i++) {
+        loose[i].Position = glm::vec4(-40.0f + static_cast<float>(i) * 13.0f, 100.0f, static_cast<float>(i % 2) * -7.0f, 0.0f);
+    }
+    geometry.AddVertices(loose);
+
+    GXVertexArrayOptions options;
+    options.QuantizeVertices = true;
+    geometry.CreateVertexArray(options);
+
+    const GXVertexLayout& layout = geometry.GetQuantizedVertexLayout();
+    const std::vector<uint8_t>& buffer = geometry.GetQuantizedVertices();
+    const std::vector<ModernVertex>& vertices = geometry.GetModelVertices();
+    CHECK(buffer.size() == vertices.size() * layout.GetStride());
+
+    // Loose vertices come first, since they were added before the vertex array was created.
+    std::vector<const GXDequantizationParams*> params(vertices.size(), &geometry.GetDequantizationParams());
+    for (const std::shared_ptr<GXShape>& shape : geometry.GetShapes()) {
+        uint32_t first, count;
+        shape->GetModelVertexRange(first, count);
+
+        for (uint32_t v = first; v < first + count; v++) {
+            params[v] = &shape->GetDequantizationParams();
+        }
+    }
+
+    CHECK(geometry.GetDequantizationParams().PositionScale.x > 0.0f);
+
+    for (size_t v = 0; v < vertices.size(); v++) {
+        const ModernVertex& vertex = vertices[v];
+
+        // Half a quantization step of the largest extent, plus some rounding.
+        const GXDequantizationParams& p = *params[v];
+        float tolerance = std::max(p.PositionScale.x, std::max(p.PositionScale.y, p.PositionScale.z)) / 65535.0f + 1e-4f;
+        CHECK(Near(DequantizePosition(GetElement(layout, buffer, v, EGXAttribute::Position), p), glm::vec3(vertex.Position), tolerance));
+
+        if (glm::length(vertex.Normal) > 0.0f) {
+            glm::vec3 normal = DecodeOctahedral(GetElement(layout, buffer, v, EGXAttribute::Normal));
+            CHECK(glm::dot(normal, glm::normalize(vertex.Normal)) > 0.9999f);
+        }
+
+        const uint8_t* color = GetElement(layout, buffer, v, EGXAttribute::Color0);
+        for (int c = 0; c < 4; c++) {
+            CHECK(std::fabs(color[c] / 255.0f - vertex.Colors[0][c]) <= 0.5f / 255.0f + 1e-6f);
+        }
+
+        uint16_t texCoord[2];
+        std::memcpy(texCoord, GetElement(layout, buffer, v, EGXAttribute::TexCoord0), sizeof(texCoord));
+        CHECK(std::fabs(glm::unpackHalf1x16(texCoord[0]) - vertex.TexCoords[0].x) <= 1e-3f);
+        CHECK(std::fabs(glm::unpackHalf1x16(texCoord[1]) - vertex.TexCoords[0].y) <= 1e-3f);
+    }
+}
+
+// A Position.w that isn't a valid matrix index must be packed as UINT16_MAX, the same as a vertex without one.
+static void TestInvalidMatrixIndicesPackAsMissing() {
+    const float ws[] = { 3.0f, -1.0f, std::numeric_limits<float>::quiet_NaN(), 1e9f, 65535.0f };
+    const uint32_t expected[] = { 3, UINT16_MAX, UINT16_MAX, UINT16_MAX, UINT16_MAX };
+
+    std::vector<ModernVertex> vertices(5);
+    for (size_t i = 0; i < vertices.size(); i++) {
+        vertices[i].Position.w = ws[i];
+    }
+
+    GXVertexLayout layout;
+    layout.AddElement(EGXAttribute::PositionMatrixIdx, EGXVertexElementFormat::UInt32);
+
+    std::vector<uint8_t> buffer;
+    GXPackVertices(vertices.data(), vertices.size(), layout, buffer);
+
+    for (size_t i = 0; i < vertices.size(); i++) {
+        uint32_t index;
+        std::memcpy(&index, GetElement(layout, buffer, i, EGXAttribute::PositionMatrixIdx), sizeof(index));
+        CHECK(index == expected[i]);
+    }
+}
+
+int main() {
+    TestQuantizedRoundTrip();
+    TestInvalidMatrixIndicesPackAsMissing();
+
+    std::puts("VertexLayoutTests passed");
+    return 0;
+}